@@ -0,0 +1,903 @@
+//-------------------------------------------------------------------------
+//
+// The MIT License (MIT)
+//
+// Copyright (c) 2022 Andrew Duncan
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+//-------------------------------------------------------------------------
+
+
+#include <getopt.h>
+#include <libgen.h>
+
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <numbers>
+#include <numeric>
+#include <print>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "config.h"
+#include "fontConfig.h"
+#include "image8880.h"
+#include "image8880Font8x16.h"
+#include "image8880FreeType.h"
+#include "image8880Graphics.h"
+#include "image8880Jpeg.h"
+#include "image8880Png.h"
+#include "image8880Process.h"
+#include "image8880Qoi.h"
+#include "image8880Raw.h"
+#include "image8880Yuv.h"
+#include "rgb8880.h"
+#include "tokenize.h"
+
+//-------------------------------------------------------------------------
+
+using namespace fb32;
+
+//-------------------------------------------------------------------------
+
+namespace
+{
+
+//-------------------------------------------------------------------------
+
+using Clock = std::chrono::steady_clock;
+
+//-------------------------------------------------------------------------
+
+struct Benchmark
+{
+    std::string m_name;
+    std::function<void()> m_run;
+};
+
+//-------------------------------------------------------------------------
+
+struct Result
+{
+    std::string m_name;
+    Dimensions8880 m_dimensions;
+    std::size_t m_threads;
+    std::size_t m_iterations;
+    double m_meanUs;
+    double m_medianUs;
+    double m_minUs;
+
+    [[nodiscard]] double
+    megapixelsPerSecond() const noexcept
+    {
+        return (m_meanUs > 0.0) ? m_dimensions.area() / m_meanUs : 0.0;
+    }
+};
+
+//-------------------------------------------------------------------------
+
+struct Settings
+{
+    std::string m_match{};
+    Clock::duration m_minimumTime{std::chrono::milliseconds(200)};
+    std::size_t m_minimumIterations{3};
+};
+
+//-------------------------------------------------------------------------
+
+const std::string_view c_text{"The quick brown fox jumps over the lazy dog. "};
+
+//-------------------------------------------------------------------------
+
+// A gradient with a xor pattern on top, so that the compressors and
+// histogram functions see something other than a flat colour.
+
+Image8880
+testImage(
+    Dimensions8880 d)
+{
+    Image8880 image{d};
+
+    for (auto j = 0 ; j < d.height() ; ++j)
+    {
+        auto row = image.getRow(j);
+
+        for (auto i = 0 ; i < d.width() ; ++i)
+        {
+            const auto red = static_cast<uint8_t>((255 * i) / d.width());
+            const auto green = static_cast<uint8_t>((255 * j) / d.height());
+            const auto blue = static_cast<uint8_t>(((i ^ j) & 0x3F) * 4);
+
+            row[i] = RGB8880::rgbTo8880(red, green, blue);
+        }
+    }
+
+    return image;
+}
+
+//-------------------------------------------------------------------------
+
+Result
+measure(
+    const Benchmark& benchmark,
+    Dimensions8880 d,
+    std::size_t threads,
+    const Settings& settings)
+{
+    // Warm up caches and let the thread pool start its threads.
+
+    benchmark.m_run();
+
+    std::vector<double> samples;
+    const auto start = Clock::now();
+
+    while ((samples.size() < settings.m_minimumIterations) or
+           ((Clock::now() - start) < settings.m_minimumTime))
+    {
+        const auto begin = Clock::now();
+        benchmark.m_run();
+        const std::chrono::duration<double, std::micro> elapsed{Clock::now() - begin};
+        samples.push_back(elapsed.count());
+    }
+
+    std::ranges::sort(samples);
+
+    const auto size = samples.size();
+    const auto total = std::accumulate(samples.begin(), samples.end(), 0.0);
+    const auto median = (size % 2)
+                      ? samples[size / 2]
+                      : (samples[size / 2 - 1] + samples[size / 2]) / 2.0;
+
+    return Result{
+        benchmark.m_name,
+        d,
+        threads,
+        size,
+        total / size,
+        median,
+        samples.front()};
+}
+
+//-------------------------------------------------------------------------
+
+void
+runBenchmarks(
+    const std::vector<Benchmark>& benchmarks,
+    Dimensions8880 d,
+    std::size_t threads,
+    const Settings& settings,
+    std::vector<Result>& results)
+{
+    for (const auto& benchmark : benchmarks)
+    {
+        if (benchmark.m_name.find(settings.m_match) == std::string::npos)
+        {
+            continue;
+        }
+
+        const auto& result = results.emplace_back(measure(benchmark,
+                                                          d,
+                                                          threads,
+                                                          settings));
+
+        std::println(std::cerr,
+                     "{:<32} {:>5}x{:<5} {:>2} threads {:>12.1f} us",
+                     result.m_name,
+                     d.width(),
+                     d.height(),
+                     threads,
+                     result.m_meanUs);
+    }
+}
+
+//-------------------------------------------------------------------------
+
+// Everything in image8880Process.h and the YUV conversions. These are the
+// functions that use the thread pool, so they are run once for each thread
+// count.
+
+std::vector<Benchmark>
+processBenchmarks(
+    const Image8880& source,
+    Image8880& canvas)
+{
+    const auto d = source.getDimensions();
+    const auto chromaWidth = (d.width() + 1) / 2;
+
+    // Only the speed matters, so the YUV planes are left flat grey.
+
+    auto yuv = std::make_shared<std::vector<uint8_t>>(4 * chromaWidth * d.height(), 128);
+    const YuvPlane y{*yuv, d.width()};
+    const YuvPlane chroma{*yuv, chromaWidth};
+    const YuvPlane uv{*yuv, 2 * chromaWidth};
+    const YuvPlane yuyv{*yuv, 4 * chromaWidth};
+    const YuvToRGB8880 yuvToRGB{};
+
+    const Dimensions8880 half{std::max(1, d.width() / 2),
+                              std::max(1, d.height() / 2)};
+    const Dimensions8880 twice{d.width() * 2, d.height() * 2};
+
+    auto plan = [&source, half](ResizePlan::Filter filter)
+    {
+        return [&source,
+                plan = ResizePlan{source.getDimensions(), half, filter},
+                output = Image8880{half}]() mutable
+        {
+            plan.resize(source, output);
+        };
+    };
+
+    return
+    {
+        { "boxBlur/2", [&source] { (void)boxBlur(source, 2); } },
+        { "boxBlur/16", [&source] { (void)boxBlur(source, 16); } },
+        { "enlighten", [&source] { (void)enlighten(source, 0.5); } },
+        { "histogramIntensity", [&source] { (void)histogramIntensity(source); } },
+        { "histogramRGB", [&source] { (void)histogramRGB(source); } },
+        { "histogramStretch", [&source] { (void)histogramStretch(1, source); } },
+        { "maxRGB", [&source] { (void)maxRGB(source); } },
+        { "resizeNearestNeighbour/half", [&source, half] { (void)resizeNearestNeighbour(source, half); } },
+        { "resizeNearestNeighbour/twice", [&source, twice] { (void)resizeNearestNeighbour(source, twice); } },
+        { "resizeBilinear/half", [&source, half] { (void)resizeBilinearInterpolation(source, half); } },
+        { "resizeBilinear/twice", [&source, twice] { (void)resizeBilinearInterpolation(source, twice); } },
+        { "resizeLanczos3/half", [&source, half] { (void)resizeLanczos3Interpolation(source, half); } },
+        { "resizeLanczos3/twice", [&source, twice] { (void)resizeLanczos3Interpolation(source, twice); } },
+        { "resizePlan/nearestNeighbour/half", plan(ResizePlan::Filter::NEAREST_NEIGHBOUR) },
+        { "resizePlan/bilinear/half", plan(ResizePlan::Filter::BILINEAR) },
+        { "resizePlan/lanczos3/half", plan(ResizePlan::Filter::LANCZOS3) },
+        { "rotate/30", [&source] { (void)rotate(source, 30.0); } },
+        { "rotate90", [&source] { (void)rotate90(source); } },
+        { "rotate180", [&source] { (void)rotate180(source); } },
+        { "rotate270", [&source] { (void)rotate270(source); } },
+        { "scaleUp/2", [&source] { (void)scaleUp(source, 2); } },
+        { "toGrey", [&source] { (void)toGrey(source); } },
+        { "toGreen", [&source] { (void)toGreen(source); } },
+        { "yuv/i420", [&canvas, yuv, d, y, chroma, yuvToRGB] { yuvToRGB.i420(d, y, chroma, chroma, canvas); } },
+        { "yuv/nv12", [&canvas, yuv, d, y, uv, yuvToRGB] { yuvToRGB.nv12(d, y, uv, canvas); } },
+        { "yuv/yuyv", [&canvas, yuv, d, yuyv, yuvToRGB] { yuvToRGB.yuyv(d, yuyv, canvas); } }
+    };
+}
+
+//-------------------------------------------------------------------------
+
+// The image8880Graphics.h primitives and putImage(). Each one covers the
+// whole canvas, or draws enough shapes to do so.
+
+std::vector<Benchmark>
+graphicsBenchmarks(
+    const Image8880& source,
+    Image8880& canvas)
+{
+    const auto d = canvas.getDimensions();
+    const auto w = d.width();
+    const auto h = d.height();
+    const Point8880 centre{w / 2, h / 2};
+    const auto radius = std::min(w, h) / 2 - 1;
+    const uint32_t rgb{0x00FF8000};
+
+    // turn the source about its centre, which is then drawn at the centre
+
+    const auto sd = source.getDimensions();
+    const auto spin = Affine::rotate(30.0) *
+                      Affine::translate(-sd.width() / 2.0, -sd.height() / 2.0);
+
+    std::vector<Point8880> vertices;
+
+    for (auto k = 0 ; k < 32 ; ++k)
+    {
+        const auto r = (k % 2) ? radius : radius / 2;
+        const auto theta = (2.0 * std::numbers::pi * k) / 32.0;
+
+        vertices.emplace_back(centre.x() + static_cast<int>(r * std::cos(theta)),
+                              centre.y() + static_cast<int>(r * std::sin(theta)));
+    }
+
+    return
+    {
+        { "box", [&canvas, w, h, rgb]
+            {
+                for (auto k = 0 ; k < std::min(w, h) / 2 ; ++k)
+                {
+                    box(canvas, Point8880{k, k}, Point8880{w - 1 - k, h - 1 - k}, rgb);
+                }
+            }
+        },
+        { "boxFilled", [&canvas, w, h, rgb]
+            {
+                boxFilled(canvas, Point8880{0, 0}, Point8880{w - 1, h - 1}, rgb);
+            }
+        },
+        { "boxFilled/alpha", [&canvas, w, h, rgb]
+            {
+                boxFilled(canvas, Point8880{0, 0}, Point8880{w - 1, h - 1}, rgb, 127);
+            }
+        },
+        { "line", [&canvas, w, h, rgb]
+            {
+                for (auto x = 0 ; x < w ; x += 4)
+                {
+                    line(canvas, Point8880{x, 0}, Point8880{w - 1 - x, h - 1}, rgb);
+                }
+            }
+        },
+        { "horizontalLine", [&canvas, w, h, rgb]
+            {
+                for (auto y = 0 ; y < h ; ++y)
+                {
+                    horizontalLine(canvas, 0, w - 1, y, rgb);
+                }
+            }
+        },
+        { "verticalLine", [&canvas, w, h, rgb]
+            {
+                for (auto x = 0 ; x < w ; ++x)
+                {
+                    verticalLine(canvas, x, 0, h - 1, rgb);
+                }
+            }
+        },
+        { "circle", [&canvas, centre, radius, rgb]
+            {
+                for (auto r = 1 ; r <= radius ; ++r)
+                {
+                    circle(canvas, centre, r, rgb);
+                }
+            }
+        },
+        { "circleFilled", [&canvas, centre, radius, rgb]
+            {
+                circleFilled(canvas, centre, radius, rgb);
+            }
+        },
+        { "polygon", [&canvas, vertices, rgb]
+            {
+                polygon(canvas, vertices, rgb);
+            }
+        },
+        { "polygonFilled", [&canvas, vertices, rgb]
+            {
+                polygonFilled(canvas, vertices, rgb);
+            }
+        },
+        { "polyline", [&canvas, vertices, rgb]
+            {
+                polyline(canvas, vertices, rgb);
+            }
+        },
+        { "putImage", [&canvas, &source]
+            {
+                canvas.putImage(Point8880{0, 0}, source);
+            }
+        },
+        { "putImage/partial", [&canvas, &source, centre]
+            {
+                canvas.putImage(centre, source);
+            }
+        },
+        { "putImageTransformed/nearest/twice", [&canvas, &source]
+            {
+                canvas.putImageTransformed(Point8880{0, 0},
+                                           source,
+                                           Affine::scale(2.0),
+                                           Affine::Filter::NEAREST_NEIGHBOUR);
+            }
+        },
+        { "putImageTransformed/bilinear/rotate30", [&canvas, &source, centre, spin]
+            {
+                canvas.putImageTransformed(centre, source, spin);
+            }
+        },
+        { "putImageTransformed/bilinear/key/alpha", [&canvas, &source, rgb]
+            {
+                canvas.putImageTransformed(Point8880{0, 0},
+                                           source,
+                                           Affine::scale(1.5),
+                                           Affine::Filter::BILINEAR,
+                                           rgb,
+                                           127);
+            }
+        }
+    };
+}
+
+//-------------------------------------------------------------------------
+
+// Fill the canvas with lines of text.
+
+Benchmark
+fontBenchmark(
+    const std::string& name,
+    Interface8880Font& font,
+    Image8880& canvas)
+{
+    const auto d = canvas.getDimensions();
+    const auto lineHeight = std::max(1, font.getPixelDimensions().height());
+
+    std::string text;
+
+    while (static_cast<int>(text.size()) < d.width() / 4)
+    {
+        text += c_text;
+    }
+
+    return
+    {
+        name,
+        [&font, &canvas, text, lineHeight, height = d.height()]
+        {
+            for (auto y = 0 ; y < height ; y += lineHeight)
+            {
+                font.drawString(Point8880{0, y}, text, 0x00FFFFFF, canvas);
+            }
+        }
+    };
+}
+
+//-------------------------------------------------------------------------
+
+// Fill the canvas with lines of text in the 8x16 font, writing the
+// background of each character cell too.
+
+Benchmark
+fontOpaqueBenchmark(
+    Image8880Font8x16& font,
+    Image8880& canvas)
+{
+    const auto d = canvas.getDimensions();
+    const auto lineHeight = font.getPixelDimensions().height();
+
+    std::string text;
+
+    while (static_cast<int>(text.size()) < d.width() / 4)
+    {
+        text += c_text;
+    }
+
+    return
+    {
+        "font8x16/drawString/opaque",
+        [&font, &canvas, text, lineHeight, height = d.height()]
+        {
+            for (auto y = 0 ; y < height ; y += lineHeight)
+            {
+                font.drawString(Point8880{0, y}, text, 0x00FFFFFF, 0x00000000, canvas);
+            }
+        }
+    };
+}
+
+//-------------------------------------------------------------------------
+
+std::string
+jsonEscape(
+    std::string_view s)
+{
+    std::string escaped;
+
+    for (const auto c : s)
+    {
+        if ((c == '"') or (c == '\\'))
+        {
+            escaped += '\\';
+        }
+
+        escaped += c;
+    }
+
+    return escaped;
+}
+
+//-------------------------------------------------------------------------
+
+void
+writeCsv(
+    std::ostream& stream,
+    const std::vector<Result>& results)
+{
+    std::println(stream, "name,width,height,threads,iterations,mean_us,median_us,min_us,mpixels_per_s");
+
+    for (const auto& r : results)
+    {
+        std::println(stream,
+                     "{},{},{},{},{},{:.3f},{:.3f},{:.3f},{:.3f}",
+                     r.m_name,
+                     r.m_dimensions.width(),
+                     r.m_dimensions.height(),
+                     r.m_threads,
+                     r.m_iterations,
+                     r.m_meanUs,
+                     r.m_medianUs,
+                     r.m_minUs,
+                     r.megapixelsPerSecond());
+    }
+}
+
+//-------------------------------------------------------------------------
+
+void
+writeJson(
+    std::ostream& stream,
+    const std::vector<Result>& results)
+{
+    std::println(stream, "{{");
+    std::println(stream, "  \"project\": \"{}\",", c_projectName);
+    std::println(stream, "  \"version\": \"{}\",", c_projectVersion);
+    std::println(stream, "  \"commit\": \"{}\",", c_gitCommitHash);
+    std::println(stream, "  \"hardware_concurrency\": {},", std::thread::hardware_concurrency());
+    std::println(stream, "  \"results\": [");
+
+    for (std::size_t i = 0 ; i < results.size() ; ++i)
+    {
+        const auto& r = results[i];
+
+        std::println(stream,
+                     "    {{ \"name\": \"{}\", \"width\": {}, \"height\": {}, "
+                     "\"threads\": {}, \"iterations\": {}, \"mean_us\": {:.3f}, "
+                     "\"median_us\": {:.3f}, \"min_us\": {:.3f}, "
+                     "\"mpixels_per_s\": {:.3f} }}{}",
+                     jsonEscape(r.m_name),
+                     r.m_dimensions.width(),
+                     r.m_dimensions.height(),
+                     r.m_threads,
+                     r.m_iterations,
+                     r.m_meanUs,
+                     r.m_medianUs,
+                     r.m_minUs,
+                     r.megapixelsPerSecond(),
+                     (i + 1 < results.size()) ? "," : "");
+    }
+
+    std::println(stream, "  ]");
+    std::println(stream, "}}");
+}
+
+//-------------------------------------------------------------------------
+
+std::vector<int>
+parseList(
+    std::string_view s)
+{
+    std::vector<int> values;
+
+    for (const auto token : tokenize(s, [](char c) { return c == ','; }))
+    {
+        int value{};
+        const auto end = token.data() + token.size();
+        const auto [ptr, ec] = std::from_chars(token.data(), end, value);
+
+        if ((ec != std::errc{}) or (ptr != end) or (value < 0))
+        {
+            throw std::invalid_argument(std::format("invalid number \"{}\"", token));
+        }
+
+        values.push_back(value);
+    }
+
+    return values;
+}
+
+//-------------------------------------------------------------------------
+
+std::vector<Dimensions8880>
+parseSizes(
+    std::string_view s)
+{
+    std::vector<Dimensions8880> sizes;
+
+    for (const auto token : tokenize(s, [](char c) { return c == ','; }))
+    {
+        const auto values = parseList(std::string(token).replace(token.find('x'), 1, ","));
+
+        if ((values.size() != 2) or (values[0] == 0) or (values[1] == 0))
+        {
+            throw std::invalid_argument(std::format("invalid size \"{}\"", token));
+        }
+
+        sizes.emplace_back(values[0], values[1]);
+    }
+
+    return sizes;
+}
+
+//-------------------------------------------------------------------------
+
+} // namespace
+
+//-------------------------------------------------------------------------
+
+void
+printUsage(
+    std::ostream& stream,
+    const std::string& name)
+{
+    std::println(stream, "");
+    std::println(stream, "Usage: {} <options>", name);
+    std::println(stream, "");
+    std::println(stream, "    --font,-F - font file to use[:pixel height]");
+    std::println(stream, "    --format,-f - output format csv or json (default csv)");
+    std::println(stream, "    --help,-h - print usage and exit");
+    std::println(stream, "    --iterations,-i - minimum iterations of each benchmark (default 3)");
+    std::println(stream, "    --jpeg,-j - jpeg file to decode");
+    std::println(stream, "    --match,-m - only run benchmarks whose name contains this");
+    std::println(stream, "    --output,-o - file to write results to (default stdout)");
+    std::println(stream, "    --png,-p - png file to decode");
+    std::println(stream, "    --sizes,-s - image sizes (default 320x240,1280x720,1920x1080)");
+    std::println(stream, "    --threads,-t - thread counts, 0 for all cores (default 1,0)");
+    std::println(stream, "    --time,-T - minimum time of each benchmark in ms (default 200)");
+    std::println(stream, "");
+}
+
+//-------------------------------------------------------------------------
+
+int
+main(
+    int argc,
+    char *argv[])
+{
+    FontConfig fontConfig;
+    std::string format{"csv"};
+    std::string jpeg{};
+    std::string output{};
+    std::string png{};
+    const std::string program{basename(argv[0])};
+    Settings settings;
+    std::string sizesOption{"320x240,1280x720,1920x1080"};
+    std::string threadsOption{"1,0"};
+
+    //---------------------------------------------------------------------
+
+    static const char* sopts = "F:f:hi:j:m:o:p:s:t:T:";
+    static option lopts[] =
+    {
+        { "font", required_argument, nullptr, 'F' },
+        { "format", required_argument, nullptr, 'f' },
+        { "help", no_argument, nullptr, 'h' },
+        { "iterations", required_argument, nullptr, 'i' },
+        { "jpeg", required_argument, nullptr, 'j' },
+        { "match", required_argument, nullptr, 'm' },
+        { "output", required_argument, nullptr, 'o' },
+        { "png", required_argument, nullptr, 'p' },
+        { "sizes", required_argument, nullptr, 's' },
+        { "threads", required_argument, nullptr, 't' },
+        { "time", required_argument, nullptr, 'T' },
+        { nullptr, no_argument, nullptr, 0 }
+    };
+
+    int opt{};
+
+    while ((opt = ::getopt_long(argc, argv, sopts, lopts, nullptr)) != -1)
+    {
+        switch (opt)
+        {
+        case 'F':
+
+            fontConfig = parseFontConfig(optarg, 32);
+            break;
+
+        case 'f':
+
+            format = optarg;
+
+            if ((format != "csv") and (format != "json"))
+            {
+                std::println(std::cerr, "Error: unknown format \"{}\"", format);
+                ::exit(EXIT_FAILURE);
+            }
+
+            break;
+
+        case 'h':
+
+            printUsage(std::cout, program);
+            ::exit(EXIT_SUCCESS);
+            break;
+
+        case 'i':
+
+            settings.m_minimumIterations = std::max(1, std::stoi(optarg));
+            break;
+
+        case 'j':
+
+            jpeg = optarg;
+            break;
+
+        case 'm':
+
+            settings.m_match = optarg;
+            break;
+
+        case 'o':
+
+            output = optarg;
+            break;
+
+        case 'p':
+
+            png = optarg;
+            break;
+
+        case 's':
+
+            sizesOption = optarg;
+            break;
+
+        case 't':
+
+            threadsOption = optarg;
+            break;
+
+        case 'T':
+
+            settings.m_minimumTime = std::chrono::milliseconds(std::stoi(optarg));
+            break;
+
+        default:
+
+            printUsage(std::cerr, program);
+            ::exit(EXIT_FAILURE);
+            break;
+        }
+    }
+
+    //---------------------------------------------------------------------
+
+    try
+    {
+        const auto sizes = parseSizes(sizesOption);
+        const auto threadCounts = parseList(threadsOption);
+
+        std::unique_ptr<Interface8880Font> freeType;
+
+        if (not fontConfig.m_fontFile.empty())
+        {
+            freeType = std::make_unique<Image8880FreeType>(fontConfig);
+        }
+
+        Image8880Font8x16 font8x16;
+        std::vector<Result> results;
+
+        for (const auto d : sizes)
+        {
+            const auto source = testImage(d);
+            Image8880 canvas{d};
+
+            // Thread counts that map to the same number of threads (or all
+            // of them, without the thread pool) are only run once.
+
+            std::vector<std::size_t> done;
+
+            for (const auto threads : threadCounts)
+            {
+                setThreadCount(threads);
+
+                if (std::ranges::find(done, getThreadCount()) == done.end())
+                {
+                    done.push_back(getThreadCount());
+                    runBenchmarks(processBenchmarks(source, canvas),
+                                  d,
+                                  getThreadCount(),
+                                  settings,
+                                  results);
+                }
+            }
+
+            setThreadCount(0);
+
+            std::vector<Benchmark> benchmarks = graphicsBenchmarks(source, canvas);
+            benchmarks.push_back(fontBenchmark("font8x16/drawString",
+                                               font8x16,
+                                               canvas));
+            benchmarks.push_back(fontOpaqueBenchmark(font8x16, canvas));
+
+            if (freeType)
+            {
+                benchmarks.push_back(fontBenchmark("freeType/drawString",
+                                                   *freeType,
+                                                   canvas));
+            }
+
+            const auto qoi = std::filesystem::temp_directory_path() /
+                std::format("benchmark-{}x{}.qoi", d.width(), d.height());
+
+            writeQoi(qoi, source);
+
+            benchmarks.push_back({ "encodeQoi", [&source] { (void)encodeQoi(source); } });
+            benchmarks.push_back({ "decodeQoi", [data = encodeQoi(source)] { (void)decodeQoi(data); } });
+            benchmarks.push_back({ "encodeQois", [&source] { (void)encodeQois(source); } });
+            benchmarks.push_back({ "decodeQois", [data = encodeQois(source)] { (void)decodeQois(data); } });
+            benchmarks.push_back({ "encodeRaw8880", [&source] { (void)encodeRaw8880(source); } });
+            benchmarks.push_back({ "decodeRaw8880", [data = encodeRaw8880(source)] { (void)decodeRaw8880(data); } });
+            benchmarks.push_back({ "readQoi", [&qoi] { (void)readQoi(qoi); } });
+
+            runBenchmarks(benchmarks, d, 1, settings, results);
+
+            std::filesystem::remove(qoi);
+        }
+
+        // The decoders are timed on the files given, at their own size.
+
+        if (not jpeg.empty())
+        {
+            const auto d = readJpeg(jpeg).getDimensions();
+            const Dimensions8880 screen{1920, 1080};
+            runBenchmarks({ { "readJpeg", [&jpeg] { (void)readJpeg(jpeg); } },
+                            { "readJpeg/fit1080p", [&jpeg, screen] { (void)readJpeg(jpeg, screen); } } },
+                          d,
+                          1,
+                          settings,
+                          results);
+        }
+
+        if (not png.empty())
+        {
+            const auto d = readPng(png).getDimensions();
+            runBenchmarks({ { "readPng", [&png] { (void)readPng(png); } } },
+                          d,
+                          1,
+                          settings,
+                          results);
+        }
+
+        //-----------------------------------------------------------------
+
+        std::ofstream file;
+
+        if (not output.empty())
+        {
+            file.open(output);
+
+            if (not file)
+            {
+                throw std::invalid_argument(std::format("unable to open \"{}\"", output));
+            }
+        }
+
+        auto& stream = output.empty() ? std::cout : file;
+
+        if (format == "json")
+        {
+            writeJson(stream, results);
+        }
+        else
+        {
+            writeCsv(stream, results);
+        }
+    }
+    catch (std::exception& error)
+    {
+        std::println(std::cerr, "Error: {}", error.what());
+        exit(EXIT_FAILURE);
+    }
+
+    return 0;
+}
+
@@ -26,7 +26,6 @@
 //-------------------------------------------------------------------------
 
 #include "image8880Font8x16.h"
-#include "image8880Process.h"
 
 #include "boxworld.h"
 #include "images.h"
@@ -181,14 +180,14 @@ Boxworld::draw(
 
     if ((zoom > 1) and m_fitToScreen)
     {
-        const auto zoomed = scaleUp(m_image, zoom);
-        const auto zd = zoomed.getDimensions();
-
-        const int xOffset = (fbd.width() - zd.width()) / 2;
-        const int yOffset = (fbd.height() - zd.height()) / 2;
+        const int xOffset = (fbd.width() - (zoom * id.width())) / 2;
+        const int yOffset = (fbd.height() - (zoom * id.height())) / 2;
 
         const Point8880 p{ xOffset, yOffset };
-        fb.putImage(p, zoomed);
+        fb.putImageTransformed(p,
+                               m_image,
+                               Affine::scale(zoom),
+                               Affine::Filter::NEAREST_NEIGHBOUR);
     }
     else
     {
@@ -49,6 +49,7 @@
 #include "config.h"
 
 #include "image8880FreeType.h"
+#include "image8880TextCache.h"
 
 #include "cpuTrace.h"
 #include "dynamicInfo.h"
@@ -103,7 +104,7 @@ Info::getHostname() const noexcept
 void
 Info::init()
 {
-    m_font = createFont(m_fontConfig);
+    m_font = std::make_unique<fb32::Image8880TextCache>(createFont(m_fontConfig));
 
     m_fb = std::make_unique<fb32::FrameBuffer8880>(m_device, m_connector);
     m_fb->clearBuffers();
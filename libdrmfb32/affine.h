@@ -0,0 +1,197 @@
+//-------------------------------------------------------------------------
+//
+// The MIT License (MIT)
+//
+// Copyright (c) 2022 Andrew Duncan
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+//-------------------------------------------------------------------------
+
+#pragma once
+
+//-------------------------------------------------------------------------
+
+#include <cmath>
+#include <numbers>
+#include <optional>
+
+#include "point.h"
+
+//-------------------------------------------------------------------------
+
+namespace fb32
+{
+
+//-------------------------------------------------------------------------
+//
+// An Affine maps a source position (x, y) to
+//
+//   x' = a * x + b * y + c
+//   y' = d * x + e * y + f
+//
+// lhs * rhs applies rhs first and then lhs. Angles are in degrees and
+// turn the same way as rotate() in image8880Process.h.
+//
+//-------------------------------------------------------------------------
+
+class Affine
+{
+public:
+
+    enum class Filter
+    {
+        NEAREST_NEIGHBOUR,
+        BILINEAR
+    };
+
+    constexpr Affine() noexcept = default;
+
+    constexpr Affine(
+        double a,
+        double b,
+        double c,
+        double d,
+        double e,
+        double f) noexcept
+    :
+        m_a{a},
+        m_b{b},
+        m_c{c},
+        m_d{d},
+        m_e{e},
+        m_f{f}
+    {
+    }
+
+    [[nodiscard]] static Affine
+    rotate(
+        double angle) noexcept
+    {
+        const auto radians = angle * (std::numbers::pi_v<double> / 180.0);
+        const auto cosAngle = std::cos(radians);
+        const auto sinAngle = std::sin(radians);
+
+        return {cosAngle, -sinAngle, 0.0, sinAngle, cosAngle, 0.0};
+    }
+
+    [[nodiscard]] static Affine
+    rotate(
+        double angle,
+        double x,
+        double y) noexcept
+    {
+        return translate(x, y) * rotate(angle) * translate(-x, -y);
+    }
+
+    [[nodiscard]] static constexpr Affine
+    scale(
+        double sx,
+        double sy) noexcept
+    {
+        return {sx, 0.0, 0.0, 0.0, sy, 0.0};
+    }
+
+    [[nodiscard]] static constexpr Affine
+    scale(
+        double s) noexcept
+    {
+        return scale(s, s);
+    }
+
+    [[nodiscard]] static constexpr Affine
+    translate(
+        double dx,
+        double dy) noexcept
+    {
+        return {1.0, 0.0, dx, 0.0, 1.0, dy};
+    }
+
+    [[nodiscard]] constexpr double a() const noexcept { return m_a; }
+    [[nodiscard]] constexpr double b() const noexcept { return m_b; }
+    [[nodiscard]] constexpr double c() const noexcept { return m_c; }
+    [[nodiscard]] constexpr double d() const noexcept { return m_d; }
+    [[nodiscard]] constexpr double e() const noexcept { return m_e; }
+    [[nodiscard]] constexpr double f() const noexcept { return m_f; }
+
+    [[nodiscard]] constexpr double
+    determinant() const noexcept
+    {
+        return (m_a * m_e) - (m_b * m_d);
+    }
+
+    // Empty if the mapping squashes everything onto a line or a point.
+
+    [[nodiscard]] constexpr std::optional<Affine>
+    inverse() const noexcept
+    {
+        const auto det = determinant();
+
+        if ((det > -1e-12) and (det < 1e-12))
+        {
+            return {};
+        }
+
+        const auto a = m_e / det;
+        const auto b = -m_b / det;
+        const auto d = -m_d / det;
+        const auto e = m_a / det;
+
+        return Affine{a, b, -(a * m_c) - (b * m_f),
+                      d, e, -(d * m_c) - (e * m_f)};
+    }
+
+    [[nodiscard]] constexpr Point<double>
+    map(
+        double x,
+        double y) const noexcept
+    {
+        return {(m_a * x) + (m_b * y) + m_c, (m_d * x) + (m_e * y) + m_f};
+    }
+
+    [[nodiscard]] friend constexpr Affine
+    operator*(
+        const Affine& lhs,
+        const Affine& rhs) noexcept
+    {
+        return {(lhs.m_a * rhs.m_a) + (lhs.m_b * rhs.m_d),
+                (lhs.m_a * rhs.m_b) + (lhs.m_b * rhs.m_e),
+                (lhs.m_a * rhs.m_c) + (lhs.m_b * rhs.m_f) + lhs.m_c,
+                (lhs.m_d * rhs.m_a) + (lhs.m_e * rhs.m_d),
+                (lhs.m_d * rhs.m_b) + (lhs.m_e * rhs.m_e),
+                (lhs.m_d * rhs.m_c) + (lhs.m_e * rhs.m_f) + lhs.m_f};
+    }
+
+    friend bool operator==(const Affine& lhs, const Affine& rhs) = default;
+
+private:
+
+    double m_a{1.0};
+    double m_b{0.0};
+    double m_c{0.0};
+    double m_d{0.0};
+    double m_e{1.0};
+    double m_f{0.0};
+};
+
+//-------------------------------------------------------------------------
+
+} // namespace fb32
+
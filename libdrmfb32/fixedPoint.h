@@ -0,0 +1,98 @@
+//-------------------------------------------------------------------------
+//
+// The MIT License (MIT)
+//
+// Copyright (c) 2022 Andrew Duncan
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+//-------------------------------------------------------------------------
+
+#pragma once
+
+//-------------------------------------------------------------------------
+
+#include <algorithm>
+#include <cstdint>
+
+//-------------------------------------------------------------------------
+
+namespace fb32
+{
+
+//-------------------------------------------------------------------------
+
+// rotate() and putImageTransformed() step through source positions in
+// 16.16 fixed point.
+
+constexpr int c_fixedPointShift{16};
+constexpr double c_fixedPointOne{1 << c_fixedPointShift};
+
+//-------------------------------------------------------------------------
+
+// Narrow [first, last] to the values of i for which
+// 0 <= start + i * step <= maximum.
+
+inline void
+clipFixedPointSpan(
+    int64_t start,
+    int64_t step,
+    int64_t maximum,
+    int& first,
+    int& last) noexcept
+{
+    auto floorDivide = [](int64_t n, int64_t d) -> int64_t
+    {
+        const auto q = n / d;
+        return ((n % d != 0) and ((n < 0) != (d < 0))) ? q - 1 : q;
+    };
+
+    auto ceilDivide = [](int64_t n, int64_t d) -> int64_t
+    {
+        const auto q = n / d;
+        return ((n % d != 0) and ((n < 0) == (d < 0))) ? q + 1 : q;
+    };
+
+    int64_t low{first};
+    int64_t high{last};
+
+    if (step > 0)
+    {
+        low = std::max(low, ceilDivide(-start, step));
+        high = std::min(high, floorDivide(maximum - start, step));
+    }
+    else if (step < 0)
+    {
+        low = std::max(low, ceilDivide(maximum - start, step));
+        high = std::min(high, floorDivide(-start, step));
+    }
+    else if ((start < 0) or (start > maximum))
+    {
+        high = low - 1;
+    }
+
+    first = static_cast<int>(low);
+    last = static_cast<int>(std::max(high, low - 1));
+}
+
+//-------------------------------------------------------------------------
+
+} // namespace fb32
+
@@ -0,0 +1,197 @@
+//-------------------------------------------------------------------------
+//
+// The MIT License (MIT)
+//
+// Copyright (c) 2022 Andrew Duncan
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+//-------------------------------------------------------------------------
+
+#include <algorithm>
+#include <print>
+#include <system_error>
+
+#include "frameStatistics.h"
+
+//-------------------------------------------------------------------------
+
+using namespace std::chrono;
+
+//=========================================================================
+
+fb32::FrameStatistics::FrameStatistics(
+    nanoseconds refreshPeriod)
+:
+    m_blocked{},
+    m_csv{},
+    m_droppedFrames{0},
+    m_firstFlip{},
+    m_frames{0},
+    m_lastFlip{},
+    m_lastSequence{0},
+    m_latencyHistogram{},
+    m_refreshPeriod{refreshPeriod}
+{
+}
+
+//-------------------------------------------------------------------------
+
+void
+fb32::FrameStatistics::addFlip(
+    unsigned int sequence,
+    Clock::time_point presented,
+    Clock::time_point flipped)
+{
+    uint64_t dropped{0};
+
+    if (m_frames == 0)
+    {
+        m_firstFlip = flipped;
+    }
+    else if (m_refreshPeriod.count() > 0)
+    {
+        // the frame could have been shown at the first vertical blank
+        // after both it was presented and the previous flip completed
+
+        const auto ready = std::max(presented, m_lastFlip) - m_lastFlip;
+        const auto expected = std::max<int64_t>(
+            1,
+            (ready + m_refreshPeriod - nanoseconds{1}) / m_refreshPeriod);
+        const auto actual = static_cast<int64_t>(sequence - m_lastSequence);
+
+        if (actual > expected)
+        {
+            dropped = actual - expected;
+        }
+    }
+
+    const auto latency = duration_cast<milliseconds>(flipped - presented);
+    const auto bucket = std::clamp<int64_t>(latency.count(), 0, c_latencyBuckets - 1);
+
+    ++m_latencyHistogram[bucket];
+    m_droppedFrames += dropped;
+    m_lastFlip = flipped;
+    m_lastSequence = sequence;
+    ++m_frames;
+
+    if (m_csv.is_open())
+    {
+        std::println(m_csv,
+                     "{},{},{},{},{},{}",
+                     m_frames,
+                     sequence,
+                     duration_cast<microseconds>(presented.time_since_epoch()).count(),
+                     duration_cast<microseconds>(flipped.time_since_epoch()).count(),
+                     duration_cast<microseconds>(flipped - presented).count(),
+                     dropped);
+    }
+}
+
+//-------------------------------------------------------------------------
+
+double
+fb32::FrameStatistics::getAchievedHz() const noexcept
+{
+    if (m_frames < 2)
+    {
+        return 0.0;
+    }
+
+    const duration<double> elapsed = m_lastFlip - m_firstFlip;
+
+    return (elapsed.count() > 0.0) ? (m_frames - 1) / elapsed.count() : 0.0;
+}
+
+//-------------------------------------------------------------------------
+
+std::chrono::milliseconds
+fb32::FrameStatistics::getLatencyPercentile(
+    double percent) const noexcept
+{
+    const auto wanted = static_cast<uint64_t>((percent * m_frames) / 100.0);
+    uint64_t count{0};
+
+    for (int bucket = 0 ; bucket < c_latencyBuckets ; ++bucket)
+    {
+        count += m_latencyHistogram[bucket];
+
+        if ((count > 0) and (count >= wanted))
+        {
+            return milliseconds{bucket};
+        }
+    }
+
+    return milliseconds{c_latencyBuckets - 1};
+}
+
+//-------------------------------------------------------------------------
+
+void
+fb32::FrameStatistics::logCsv(
+    const std::string& filename)
+{
+    m_csv.close();
+
+    if (filename.empty())
+    {
+        return;
+    }
+
+    m_csv.open(filename);
+
+    if (not m_csv)
+    {
+        throw std::system_error(errno,
+                                std::system_category(),
+                                "cannot open " + filename);
+    }
+
+    std::println(m_csv, "frame,sequence,presented_us,flipped_us,latency_us,dropped");
+}
+
+//-------------------------------------------------------------------------
+
+void
+fb32::FrameStatistics::reset() noexcept
+{
+    m_blocked = Clock::duration{};
+    m_droppedFrames = 0;
+    m_frames = 0;
+    m_latencyHistogram.fill(0);
+}
+
+//-------------------------------------------------------------------------
+
+void
+fb32::FrameStatistics::writeSummary(
+    std::ostream& stream) const
+{
+    std::println(stream, "frames: {}", m_frames);
+    std::println(stream, "dropped frames: {}", m_droppedFrames);
+    std::println(stream, "achieved: {:.2f} Hz", getAchievedHz());
+    std::println(stream,
+                 "latency: median {} ms, 99% {} ms",
+                 getLatencyPercentile(50.0).count(),
+                 getLatencyPercentile(99.0).count());
+    std::println(stream,
+                 "blocked: {} ms",
+                 duration_cast<milliseconds>(m_blocked).count());
+}
@@ -0,0 +1,107 @@
+//-------------------------------------------------------------------------
+//
+// The MIT License (MIT)
+//
+// Copyright (c) 2022 Andrew Duncan
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+//-------------------------------------------------------------------------
+
+#pragma once
+
+//-------------------------------------------------------------------------
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <ostream>
+#include <string>
+
+//-------------------------------------------------------------------------
+
+namespace fb32
+{
+
+//-------------------------------------------------------------------------
+//
+// Presentation statistics gathered from page flip events. Latency is the
+// time from present() to the flip reaching the screen. A frame is counted
+// as dropped for each vertical blank it missed after it was presented and
+// the previous flip had completed.
+//
+//-------------------------------------------------------------------------
+
+class FrameStatistics
+{
+public:
+
+    using Clock = std::chrono::steady_clock;
+
+    // one bucket per millisecond, the last counts everything longer
+
+    static constexpr int c_latencyBuckets{64};
+
+    using LatencyHistogram = std::array<uint64_t, c_latencyBuckets>;
+
+    explicit FrameStatistics(std::chrono::nanoseconds refreshPeriod);
+
+    void addBlocked(Clock::duration blocked) noexcept { m_blocked += blocked; }
+
+    void
+    addFlip(
+        unsigned int sequence,
+        Clock::time_point presented,
+        Clock::time_point flipped);
+
+    [[nodiscard]] double getAchievedHz() const noexcept;
+    [[nodiscard]] Clock::duration getBlocked() const noexcept { return m_blocked; }
+    [[nodiscard]] uint64_t getDroppedFrames() const noexcept { return m_droppedFrames; }
+    [[nodiscard]] uint64_t getFrames() const noexcept { return m_frames; }
+    [[nodiscard]] const LatencyHistogram& getLatencyHistogram() const noexcept { return m_latencyHistogram; }
+    [[nodiscard]] std::chrono::milliseconds getLatencyPercentile(double percent) const noexcept;
+    [[nodiscard]] std::chrono::nanoseconds getRefreshPeriod() const noexcept { return m_refreshPeriod; }
+
+    // write a line for every flip to a CSV file, an empty name stops it
+
+    void logCsv(const std::string& filename);
+
+    void reset() noexcept;
+
+    void writeSummary(std::ostream& stream) const;
+
+private:
+
+    Clock::duration m_blocked;
+    std::ofstream m_csv;
+    uint64_t m_droppedFrames;
+    Clock::time_point m_firstFlip;
+    uint64_t m_frames;
+    Clock::time_point m_lastFlip;
+    unsigned int m_lastSequence;
+    LatencyHistogram m_latencyHistogram;
+    std::chrono::nanoseconds m_refreshPeriod;
+};
+
+//-------------------------------------------------------------------------
+
+} // namespace fb32
+
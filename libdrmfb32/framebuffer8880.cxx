@@ -30,6 +30,7 @@
 #include <stdint.h>
 #include <stdio.h>
 #include <string.h>
+#include <poll.h>
 #include <unistd.h>
 #include <xf86drm.h>
 #include <xf86drmMode.h>
@@ -38,6 +39,7 @@
 #include <sys/mman.h>
 
 #include <algorithm>
+#include <format>
 #include <fstream>
 #include <memory>
 #include <string>
@@ -46,22 +48,143 @@
 #include "drmMode.h"
 #include "framebuffer8880.h"
 #include "image8880.h"
+#include "image8880Qoi.h"
+#include "image8880Raw.h"
+#include "image8880View.h"
 #include "point.h"
+#include "tokenize.h"
+
+//=========================================================================
+
+namespace
+{
+
+//-------------------------------------------------------------------------
+
+int
+area(
+    const drm_mode_rect& r) noexcept
+{
+    return (r.x2 - r.x1) * (r.y2 - r.y1);
+}
+
+//-------------------------------------------------------------------------
+
+bool
+contains(
+    const drm_mode_rect& outer,
+    const drm_mode_rect& inner) noexcept
+{
+    return (outer.x1 <= inner.x1) and
+           (outer.y1 <= inner.y1) and
+           (outer.x2 >= inner.x2) and
+           (outer.y2 >= inner.y2);
+}
+
+//-------------------------------------------------------------------------
+
+bool
+touches(
+    const drm_mode_rect& a,
+    const drm_mode_rect& b) noexcept
+{
+    return (a.x1 <= b.x2) and
+           (b.x1 <= a.x2) and
+           (a.y1 <= b.y2) and
+           (b.y1 <= a.y2);
+}
+
+//-------------------------------------------------------------------------
+
+drm_mode_rect
+unite(
+    const drm_mode_rect& a,
+    const drm_mode_rect& b) noexcept
+{
+    return drm_mode_rect{
+        .x1 = std::min(a.x1, b.x1),
+        .y1 = std::min(a.y1, b.y1),
+        .x2 = std::max(a.x2, b.x2),
+        .y2 = std::max(a.y2, b.y2)
+    };
+}
+
+//-------------------------------------------------------------------------
+
+// Never holds more than c_maxDamageRectangles, so once that many are
+// reserved it doesn't allocate.
+
+void
+addRectangle(
+    std::vector<drm_mode_rect>& rectangles,
+    drm_mode_rect rect) noexcept
+{
+    const auto inside = [&rect](const drm_mode_rect& r) { return contains(r, rect); };
+
+    if (std::ranges::any_of(rectangles, inside))
+    {
+        return;
+    }
+
+    // merge with every rectangle it overlaps or touches
+
+    const auto adjacent = [&rect](const drm_mode_rect& r) { return touches(r, rect); };
+
+    for (auto it = std::ranges::find_if(rectangles, adjacent) ;
+         it != rectangles.end() ;
+         it = std::ranges::find_if(rectangles, adjacent))
+    {
+        rect = unite(*it, rect);
+        rectangles.erase(it);
+    }
+
+    // when full, merge with the rectangle that grows the least
+
+    if (rectangles.size() == fb32::FrameBuffer8880::c_maxDamageRectangles)
+    {
+        const auto growth = [&rect](const drm_mode_rect& r)
+        {
+            return area(unite(r, rect)) - area(r);
+        };
+
+        const auto it = std::ranges::min_element(rectangles, {}, growth);
+        rect = unite(*it, rect);
+        rectangles.erase(it);
+    }
+
+    rectangles.push_back(rect);
+}
+
+//-------------------------------------------------------------------------
+
+} // namespace
 
 //=========================================================================
 
 fb32::FrameBuffer8880::FrameBuffer8880(
     const std::string& device,
-    uint32_t connectorId)
+    uint32_t connectorId,
+    int bufferCount)
 :
     m_dimensions{},
     m_fd{},
     m_dbs{},
     m_dbFront{0},
     m_dbBack{1},
+    m_dbPending{c_noBuffer},
+    m_dbLatest{0},
+    m_dbQueued{},
     m_hasAtomic{false},
     m_hasUniversalPlanes{false},
     m_atomicProperties{},
+    m_damageClipsPropertyId{0},
+    m_trackDamage{false},
+    m_monotonicTimestamps{false},
+    m_statistics{std::chrono::nanoseconds{0}},
+    m_frameDump{},
+    m_frameNumber{0},
+    m_headless{false},
+    m_headlessSequence{0},
     m_blobId{0},
     m_connectorId{connectorId},
     m_crtcId{0},
@@ -69,6 +192,31 @@ fb32::FrameBuffer8880::FrameBuffer8880(
     m_mode{},
     m_originalCrtc(nullptr, [](drmModeCrtc*){})
 {
+    if ((bufferCount < c_minBuffers) or (bufferCount > c_maxBuffers))
+    {
+        throw std::invalid_argument("buffer count must be between " +
+                                    std::to_string(c_minBuffers) +
+                                    " and " +
+                                    std::to_string(c_maxBuffers));
+    }
+
+    m_dbs.resize(bufferCount);
+
+    // addDamage() is noexcept, so the damage lists mustn't allocate
+
+    for (auto& db : m_dbs)
+    {
+        db.m_damage.reserve(c_maxDamageRectangles);
+        db.m_stale.reserve(c_maxDamageRectangles);
+    }
+
+    if (device.starts_with(c_nullDevice))
+    {
+        createNullBuffers(device);
+        clearBuffers();
+        return;
+    }
+
     std::string card{device};
 
     if (card.empty())
@@ -94,6 +242,19 @@ fb32::FrameBuffer8880::FrameBuffer8880(
     findResources(connectorId);
     drm::drmSetMaster(m_fd);
 
+    uint64_t monotonic{0};
+    m_monotonicTimestamps = (drm::drmGetCap(m_fd, DRM_CAP_TIMESTAMP_MONOTONIC, &monotonic) == 0) and
+                            (monotonic != 0);
+
+    if (m_mode.clock > 0)
+    {
+        // mode clock is in kHz
+
+        const std::chrono::nanoseconds period{
+            (static_cast<int64_t>(m_mode.htotal) * m_mode.vtotal * 1'000'000) / m_mode.clock};
+        m_statistics = FrameStatistics{period};
+    }
+
     if (useAtomic())
     {
         if (drm::drmModeCreatePropertyBlob(
@@ -108,10 +269,17 @@ fb32::FrameBuffer8880::FrameBuffer8880(
         }
 
         createAtomicRequests();
+
+        m_damageClipsPropertyId = drm::findDrmPropertyId(m_fd,
+                                                         m_planeId,
+                                                         DRM_MODE_OBJECT_PLANE,
+                                                         "FB_DAMAGE_CLIPS");
     }
 
-    createDumbBuffer(m_dbFront);
-    createDumbBuffer(m_dbBack);
+    for (auto index = 0 ; index < bufferCount ; ++index)
+    {
+        createDumbBuffer(index);
+    }
 
     setDumbBuffer(m_dbFront);
     clearBuffers();
@@ -121,17 +289,29 @@ fb32::FrameBuffer8880::FrameBuffer8880(
 
 fb32::FrameBuffer8880::~FrameBuffer8880()
 {
+    if (m_headless)
+    {
+        return;
+    }
+
     try
     {
         clearBuffers();
 
+        while (isFlipPending())
+        {
+            readEvents();
+        }
+
         if (useAtomic())
         {
             drm::drmModeDestroyPropertyBlob(m_fd, m_blobId);
         }
 
-        destroyDumbBuffer(m_dbBack);
-        destroyDumbBuffer(m_dbFront);
+        for (auto index = 0 ; index < getBufferCount() ; ++index)
+        {
+            destroyDumbBuffer(index);
+        }
 
         drm::drmModeSetCrtc(m_fd,
                             m_originalCrtc,
@@ -150,19 +330,85 @@ fb32::FrameBuffer8880::~FrameBuffer8880()
 
 //-------------------------------------------------------------------------
 
+void
+fb32::FrameBuffer8880::acquireBackBuffer()
+{
+    if (m_dbBack != c_noBuffer)
+    {
+        return;
+    }
+
+    auto index = findFreeBuffer();
+
+    if (index == c_noBuffer)
+    {
+        const auto start = FrameStatistics::Clock::now();
+
+        while (index == c_noBuffer)
+        {
+            readEvents();
+            index = findFreeBuffer();
+        }
+
+        m_statistics.addBlocked(FrameStatistics::Clock::now() - start);
+    }
+
+    m_dbBack = index;
+
+    if (m_trackDamage)
+    {
+        copyStale(m_dbBack);
+    }
+}
+
+//-------------------------------------------------------------------------
+
+void
+fb32::FrameBuffer8880::addDamage(
+    Point8880 p,
+    Dimensions8880 d) noexcept
+{
+    if (not m_trackDamage or (m_dbBack == c_noBuffer))
+    {
+        return;
+    }
+
+    const drm_mode_rect rect{
+        .x1 = std::max(p.x(), 0),
+        .y1 = std::max(p.y(), 0),
+        .x2 = std::min(p.x() + d.width(), m_dimensions.width()),
+        .y2 = std::min(p.y() + d.height(), m_dimensions.height())
+    };
+
+    if ((rect.x1 < rect.x2) and (rect.y1 < rect.y2))
+    {
+        addRectangle(m_dbs[m_dbBack].m_damage, rect);
+    }
+}
+
+//-------------------------------------------------------------------------
+
 void
 fb32::FrameBuffer8880::clearBuffers(uint32_t rgb)
 {
-    clear(rgb);
-    update();
-    clear(rgb);
+    for (auto& db : m_dbs)
+    {
+        std::fill(db.m_fbp, db.m_fbp + getBufferSize(), rgb);
+        db.m_damage.clear();
+        db.m_stale.clear();
+    }
 }
 
 //-------------------------------------------------------------------------
 
 std::span<uint32_t>
-fb32::FrameBuffer8880::getBuffer() & noexcept
+fb32::FrameBuffer8880::getBuffer() &
 {
+    if (m_dbBack == c_noBuffer)
+    {
+        acquireBackBuffer();
+    }
+
     const auto& dbb = m_dbs[m_dbBack];
     return {dbb.m_fbp, getBufferSize()};
 }
@@ -170,8 +416,13 @@ fb32::FrameBuffer8880::getBuffer() & noexcept
 //-------------------------------------------------------------------------
 
 std::span<const uint32_t>
-fb32::FrameBuffer8880::getBuffer() const &noexcept
+fb32::FrameBuffer8880::getBuffer() const &
 {
+    if (m_dbBack == c_noBuffer)
+    {
+        throw std::logic_error("no back buffer to read, call acquireBackBuffer()");
+    }
+
     const auto& dbb = m_dbs[m_dbBack];
     return {dbb.m_fbp, getBufferSize()};
 }
@@ -181,8 +432,28 @@ fb32::FrameBuffer8880::getBuffer() const &noexcept
 std::size_t
 fb32::FrameBuffer8880::getBufferSize() const noexcept
 {
-    const auto& dbb = m_dbs[m_dbBack];
-    return static_cast<std::size_t>(dbb.m_lineLengthPixels) * m_dimensions.height();
+    // every buffer has the same dimensions and pitch
+
+    const auto& dbf = m_dbs[m_dbFront];
+    return static_cast<std::size_t>(dbf.m_lineLengthPixels) * m_dimensions.height();
+}
+
+//-------------------------------------------------------------------------
+
+void
+fb32::FrameBuffer8880::handleEvents()
+{
+    if (m_headless)
+    {
+        return;
+    }
+
+    pollfd pfd{ .fd = m_fd.fd(), .events = POLLIN, .revents = 0 };
+
+    while ((::poll(&pfd, 1, 0) > 0) and (pfd.revents & POLLIN))
+    {
+        readEvents();
+    }
 }
 
 //-------------------------------------------------------------------------
@@ -190,7 +461,7 @@ fb32::FrameBuffer8880::getBufferSize() const noexcept
 bool
 fb32::FrameBuffer8880::isMaster() const noexcept
 {
-    return drm::drmIsMaster(m_fd);
+    return m_headless or drm::drmIsMaster(m_fd);
 }
 
 //-------------------------------------------------------------------------
@@ -198,6 +469,11 @@ fb32::FrameBuffer8880::isMaster() const noexcept
 void
 fb32::FrameBuffer8880::masterSet() const noexcept
 {
+    if (m_headless)
+    {
+        return;
+    }
+
     drm::drmSetMaster(m_fd);
 }
 
@@ -206,6 +482,11 @@ fb32::FrameBuffer8880::masterSet() const noexcept
 void
 fb32::FrameBuffer8880::masterDrop() const noexcept
 {
+    if (m_headless)
+    {
+        return;
+    }
+
     drm::drmDropMaster(m_fd);
 }
 
@@ -215,51 +496,315 @@ std::size_t
 fb32::FrameBuffer8880::offset(
     Point8880 p) const noexcept
 {
-    const auto& dbb = m_dbs[m_dbBack];
-    return p.x() + p.y() * dbb.m_lineLengthPixels;
+    const auto& dbf = m_dbs[m_dbFront];
+    return p.x() + p.y() * dbf.m_lineLengthPixels;
 }
 
 //-------------------------------------------------------------------------
 
 void
-fb32::FrameBuffer8880::update()
+fb32::FrameBuffer8880::present()
 {
-    std::swap(m_dbFront, m_dbBack);
-    const auto& dbf = m_dbs[m_dbFront];
+    if (m_dbBack == c_noBuffer)
+    {
+        throw std::logic_error("no back buffer to present, call acquireBackBuffer()");
+    }
 
-    if (useAtomic())
+    if (m_trackDamage)
     {
-        auto atomicReq = drm::drmModeAtomicAlloc();
-        addAtomicProperties(atomicReq, dbf.m_fbId);
-        constexpr uint32_t flags = DRM_MODE_PAGE_FLIP_EVENT | DRM_MODE_ATOMIC_NONBLOCK;
-        auto result = drm::drmModeAtomicCommit(m_fd, atomicReq, flags, nullptr);
+        const auto& damage = m_dbs[m_dbBack].m_damage;
 
-        if (result < 0)
+        for (auto index = 0 ; index < getBufferCount() ; ++index)
         {
-            throw std::system_error(errno,
-                                    std::system_category(),
-                                    "unable to flip using atomic");
+            if (index != m_dbBack)
+            {
+                for (const auto& rect : damage)
+                {
+                    addRectangle(m_dbs[index].m_stale, rect);
+                }
+            }
         }
     }
+
+    if (not m_frameDump.empty())
+    {
+        writeQoi(std::format("{}{:06}.qoi", m_frameDump, m_frameNumber++), *this);
+    }
+
+    handleEvents();
+
+    m_dbs[m_dbBack].m_presented = FrameStatistics::Clock::now();
+    m_dbLatest = m_dbBack;
+    m_dbQueued.push_back(m_dbBack);
+    m_dbBack = c_noBuffer;
+
+    submitFlip();
+}
+
+//-------------------------------------------------------------------------
+
+void
+fb32::FrameBuffer8880::setDamageTracking(
+    bool track)
+{
+    const drm_mode_rect screen{
+        .x1 = 0,
+        .y1 = 0,
+        .x2 = m_dimensions.width(),
+        .y2 = m_dimensions.height()
+    };
+
+    for (auto index = 0 ; index < getBufferCount() ; ++index)
+    {
+        auto& db = m_dbs[index];
+        db.m_damage.clear();
+        db.m_stale.clear();
+
+        // start by bringing every buffer up to date with the latest frame
+
+        if (track and (index != m_dbLatest))
+        {
+            db.m_stale.push_back(screen);
+        }
+    }
+
+    m_trackDamage = track;
+
+    if (m_trackDamage and (m_dbBack != c_noBuffer))
+    {
+        copyStale(m_dbBack);
+    }
+}
+
+//-------------------------------------------------------------------------
+
+void
+fb32::FrameBuffer8880::setFrameDump(
+    const std::string& prefix)
+{
+    m_frameDump = prefix;
+    m_frameNumber = 0;
+}
+
+//-------------------------------------------------------------------------
+
+void
+fb32::FrameBuffer8880::screenshot(
+    const std::string& name) const
+{
+    const auto& dbf = m_dbs[m_dbFront];
+    const Image8880View front{m_dimensions,
+                              {dbf.m_fbp, getBufferSize()},
+                              dbf.m_lineLengthPixels};
+
+    if (name.ends_with(".raw"))
+    {
+        writeRaw8880(name, front);
+    }
     else
     {
+        writeQoi(name, front);
+    }
+}
+
+//-------------------------------------------------------------------------
+
+void
+fb32::FrameBuffer8880::update()
+{
+    present();
+    acquireBackBuffer();
+}
+
+//-------------------------------------------------------------------------
+
+void
+fb32::FrameBuffer8880::pageFlipHandler(
+    int,
+    unsigned int sequence,
+    unsigned int tv_sec,
+    unsigned int tv_usec,
+    unsigned int,
+    void* userData)
+{
+    if (userData)
+    {
+        auto fb = static_cast<FrameBuffer8880*>(userData);
+        auto flipped = FrameStatistics::Clock::now();
+
+        if (fb->m_monotonicTimestamps)
+        {
+            // the kernel timestamps vertical blanks with CLOCK_MONOTONIC,
+            // which is the clock steady_clock uses
+
+            flipped = FrameStatistics::Clock::time_point{
+                std::chrono::seconds{tv_sec} + std::chrono::microseconds{tv_usec}};
+        }
+
+        fb->flipComplete(sequence, flipped);
+    }
+}
+
+//-------------------------------------------------------------------------
+
+void
+fb32::FrameBuffer8880::copyStale(
+    int index)
+{
+    // copy the regions drawn since this buffer was last presented from
+    // the most recently presented buffer
+
+    auto& db = m_dbs[index];
+    const auto& source = m_dbs[m_dbLatest];
+
+    for (const auto& rect : db.m_stale)
+    {
+        const auto width = rect.x2 - rect.x1;
+
+        for (auto y = rect.y1 ; y < rect.y2 ; ++y)
+        {
+            const auto* from = source.m_fbp + rect.x1 + y * source.m_lineLengthPixels;
+            auto* to = db.m_fbp + rect.x1 + y * db.m_lineLengthPixels;
+            std::copy(from, from + width, to);
+        }
+    }
+
+    db.m_stale.clear();
+}
+
+//-------------------------------------------------------------------------
+
+int
+fb32::FrameBuffer8880::findFreeBuffer() const noexcept
+{
+    for (auto index = 0 ; index < getBufferCount() ; ++index)
+    {
+        if ((index != m_dbFront) and
+            (index != m_dbBack) and
+            (index != m_dbPending) and
+            (std::ranges::find(m_dbQueued, index) == m_dbQueued.end()))
+        {
+            return index;
+        }
+    }
+
+    return c_noBuffer;
+}
+
+//-------------------------------------------------------------------------
 
-        drm::drmModePageFlip(m_fd,
-                             m_crtcId,
-                             dbf.m_fbId,
-                             DRM_MODE_PAGE_FLIP_EVENT,
-                             nullptr);
+void
+fb32::FrameBuffer8880::flipComplete(
+    unsigned int sequence,
+    FrameStatistics::Clock::time_point flipped)
+{
+    if (m_dbPending != c_noBuffer)
+    {
+        m_statistics.addFlip(sequence, m_dbs[m_dbPending].m_presented, flipped);
+        m_dbFront = m_dbPending;
+        m_dbPending = c_noBuffer;
     }
+}
+
+//-------------------------------------------------------------------------
 
+void
+fb32::FrameBuffer8880::readEvents()
+{
     drmEventContext ev{
         .version = DRM_EVENT_CONTEXT_VERSION,
         .vblank_handler = nullptr,
         .page_flip_handler = nullptr,
-        .page_flip_handler2 = nullptr,
+        .page_flip_handler2 = pageFlipHandler,
         .sequence_handler = nullptr
     };
 
     drm::drmHandleEvent(m_fd, &ev);
+
+    // flips can't be submitted from inside the handler, as it may throw
+
+    submitFlip();
+}
+
+//-------------------------------------------------------------------------
+
+void
+fb32::FrameBuffer8880::submitFlip()
+{
+    if ((m_dbPending != c_noBuffer) or m_dbQueued.empty())
+    {
+        return;
+    }
+
+    const auto index = m_dbQueued.front();
+    auto& db = m_dbs[index];
+
+    if (m_headless)
+    {
+        // nothing to wait for, the flip completes straight away
+    }
+    else if (useAtomic())
+    {
+        auto atomicReq = drm::drmModeAtomicAlloc();
+        addAtomicProperties(atomicReq, db.m_fbId);
+
+        uint32_t damageBlobId{0};
+
+        if (hasDamageClips() and not db.m_damage.empty())
+        {
+            if (drm::drmModeCreatePropertyBlob(
+                    m_fd,
+                    db.m_damage.data(),
+                    db.m_damage.size() * sizeof(drm_mode_rect),
+                    &damageBlobId) == 0)
+            {
+                drm::drmModeAtomicAddProperty(atomicReq,
+                                              m_planeId,
+                                              m_damageClipsPropertyId,
+                                              damageBlobId);
+            }
+        }
+
+        constexpr uint32_t flags = DRM_MODE_PAGE_FLIP_EVENT | DRM_MODE_ATOMIC_NONBLOCK;
+        const auto result = drm::drmModeAtomicCommit(m_fd, atomicReq, flags, this);
+        const auto error = errno;
+
+        if (damageBlobId != 0)
+        {
+            drm::drmModeDestroyPropertyBlob(m_fd, damageBlobId);
+        }
+
+        if (result < 0)
+        {
+            throw std::system_error(error,
+                                    std::system_category(),
+                                    "unable to flip using atomic");
+        }
+    }
+    else
+    {
+        const auto result = drm::drmModePageFlip(m_fd,
+                                                 m_crtcId,
+                                                 db.m_fbId,
+                                                 DRM_MODE_PAGE_FLIP_EVENT,
+                                                 this);
+
+        if (result < 0)
+        {
+            throw std::system_error(errno,
+                                    std::system_category(),
+                                    "unable to page flip");
+        }
+    }
+
+    db.m_damage.clear();
+    m_dbQueued.pop_front();
+    m_dbPending = index;
+
+    if (m_headless)
+    {
+        flipComplete(++m_headlessSequence, FrameStatistics::Clock::now());
+    }
 }
 
 //-------------------------------------------------------------------------
@@ -345,6 +890,49 @@ fb32::FrameBuffer8880::createDumbBuffer(
 
 //-------------------------------------------------------------------------
 
+void
+fb32::FrameBuffer8880::createNullBuffers(
+    const std::string& device)
+{
+    m_headless = true;
+    m_dimensions.set(1920, 1080);
+
+    const auto tokens = tokenize(device, [](char c) { return c == ':'; });
+
+    if (tokens.size() > 1)
+    {
+        const auto size = tokenize(tokens[1], [](char c) { return c == 'x'; });
+
+        if (size.size() != 2)
+        {
+            throw std::invalid_argument("null device size must be WIDTHxHEIGHT");
+        }
+
+        m_dimensions.set(std::stoi(std::string(size[0])),
+                         std::stoi(std::string(size[1])));
+
+        if ((m_dimensions.width() <= 0) or (m_dimensions.height() <= 0))
+        {
+            throw std::invalid_argument("width and height must be greater than zero");
+        }
+    }
+
+    if (tokens.size() > 2)
+    {
+        setFrameDump(std::string(tokens[2]));
+    }
+
+    for (auto& db : m_dbs)
+    {
+        db.m_memory.resize(m_dimensions.area());
+        db.m_fbp = db.m_memory.data();
+        db.m_length = m_dimensions.area() * c_bytesPerPixel;
+        db.m_lineLengthPixels = m_dimensions.width();
+    }
+}
+
+//-------------------------------------------------------------------------
+
 void
 fb32::FrameBuffer8880::destroyDumbBuffer(
     int index)
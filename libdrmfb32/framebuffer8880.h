@@ -29,14 +29,16 @@
 
 //-------------------------------------------------------------------------
 
-#include <array>
 #include <cstdint>
+#include <deque>
 #include <string>
+#include <string_view>
 #include <vector>
 
 #include "drmMode.h"
 #include "point.h"
 #include "fileDescriptor.h"
+#include "frameStatistics.h"
 #include "interface8880Base.h"
 #include "rgb8880.h"
 
@@ -70,6 +72,10 @@ public:
         uint32_t m_fbHandle{0};
         int m_length{0};
         int m_lineLengthPixels{0};
+        std::vector<drm_mode_rect> m_damage{};
+        std::vector<drm_mode_rect> m_stale{};
+        FrameStatistics::Clock::time_point m_presented{};
+        std::vector<uint32_t> m_memory{};
     };
 
     //---------------------------------------------------------------------
@@ -85,50 +91,131 @@ public:
 
     //---------------------------------------------------------------------
 
+    // A device of "null" draws into memory instead of a display, so
+    // programs can be run and timed without one. The size defaults to
+    // 1920x1080 and can be set with "null:WIDTHxHEIGHT". Adding ":PREFIX"
+    // writes every presented frame to PREFIXnnnnnn.qoi.
+
     explicit FrameBuffer8880(
         const std::string& device = "",
-        uint32_t connectorId = 0);
+        uint32_t connectorId = 0,
+        int bufferCount = c_minBuffers);
 
     ~FrameBuffer8880() final;
 
+    static constexpr std::string_view c_nullDevice{"null"};
+    static constexpr int c_minBuffers{2};
+    static constexpr int c_maxBuffers{4};
+    static constexpr std::size_t c_maxDamageRectangles{16};
+
     FrameBuffer8880(const FrameBuffer8880& fb) = delete;
     FrameBuffer8880& operator=(const FrameBuffer8880& fb) = delete;
 
     FrameBuffer8880(FrameBuffer8880&& fb) = delete;
     FrameBuffer8880& operator=(FrameBuffer8880&& fb) = delete;
 
+    // Wait for a buffer to draw the next frame into. This only blocks when
+    // every other buffer is on screen or waiting to be.
+
+    void acquireBackBuffer();
+
+    void addDamage(Point8880 p, Dimensions8880 d) noexcept final;
+
     void clearBuffers(const RGB8880& rgb) { clearBuffers(rgb.get8880()); }
     void clearBuffers(uint32_t rgb = 0);
 
-    [[nodiscard]] std::span<uint32_t> getBuffer() & noexcept final;
-    [[nodiscard]] std::span<const uint32_t> getBuffer() const & noexcept final;
+    // Between present() and acquireBackBuffer() there is no back buffer.
+    // Drawing acquires one, reading throws std::logic_error.
+
+    [[nodiscard]] std::span<uint32_t> getBuffer() & final;
+    [[nodiscard]] std::span<const uint32_t> getBuffer() const & final;
 
     [[nodiscard]] std::span<uint32_t> getBuffer() && noexcept = delete;
     [[nodiscard]] std::span<const uint32_t> getBuffer() const && noexcept = delete;
 
+    [[nodiscard]] int getBufferCount() const noexcept { return static_cast<int>(m_dbs.size()); }
     [[nodiscard]] std::size_t getBufferSize() const noexcept;
 
     [[nodiscard]] drm::drmVersion_ptr getDrmVersion() noexcept { return drm::drmGetVersion(m_fd); }
 
     [[nodiscard]] Dimensions8880 getDimensions() const noexcept final { return m_dimensions; }
 
+    // The file descriptor becomes readable when a page flip completes,
+    // call handleEvents() when it does.
+
+    [[nodiscard]] int getEventFd() const noexcept { return m_fd.fd(); }
+    void handleEvents();
+
+    [[nodiscard]] FrameStatistics& getStatistics() noexcept { return m_statistics; }
+    [[nodiscard]] const FrameStatistics& getStatistics() const noexcept { return m_statistics; }
+
     [[nodiscard]] bool hasAtomic() const noexcept { return m_hasAtomic; }
+    [[nodiscard]] bool hasDamageClips() const noexcept { return m_damageClipsPropertyId != 0; }
     [[nodiscard]] bool hasUniversalPlanes() const noexcept { return m_hasUniversalPlanes; }
 
+    [[nodiscard]] bool isFlipPending() const noexcept { return m_dbPending != c_noBuffer; }
+    [[nodiscard]] bool isHeadless() const noexcept { return m_headless; }
     [[nodiscard]] bool isMaster() const noexcept;
+    [[nodiscard]] bool isTrackingDamage() const noexcept { return m_trackDamage; }
     void masterSet() const noexcept;
     void masterDrop() const noexcept;
 
     [[nodiscard]] std::size_t offset(Point8880 p) const noexcept final;
 
+    // Queue the back buffer to be shown at the next vertical blank and
+    // return without waiting. Any page flips that have completed are
+    // handled first, so frames are not held up when handleEvents() isn't
+    // called. Call acquireBackBuffer() before drawing the next frame.
+
+    void present();
+
+    // When tracking damage, acquireBackBuffer() copies the regions drawn
+    // since the buffer was last shown into it, so it always holds the most
+    // recent frame and only the parts that change need to be redrawn.
+
+    void setDamageTracking(bool track);
+
+    // Write every presented frame to PREFIXnnnnnn.qoi, an empty prefix
+    // stops writing.
+
+    void setFrameDump(const std::string& prefix);
+
+    // Write the front buffer, what is on screen now, to a file. A name
+    // ending in .raw is written as raw 8880 and any other name as QOI.
+
+    void screenshot(const std::string& name) const;
+
+    // present() then acquireBackBuffer().
+
     void update();
 
 private:
 
+    static constexpr int c_noBuffer{-1};
+
+    static void
+    pageFlipHandler(
+        int fd,
+        unsigned int sequence,
+        unsigned int tv_sec,
+        unsigned int tv_usec,
+        unsigned int crtc_id,
+        void* userData);
+
     void createDumbBuffer(int index);
+    void createNullBuffers(const std::string& device);
     void destroyDumbBuffer(int index);
     void setDumbBuffer(int index);
 
+    void copyStale(int index);
+    [[nodiscard]] int findFreeBuffer() const noexcept;
+    void
+    flipComplete(
+        unsigned int sequence,
+        FrameStatistics::Clock::time_point flipped);
+    void readEvents();
+    void submitFlip();
+
     void
     addAtomicProperties(
         drm::drmModeAtomicReq_ptr& atomicRequest,
@@ -149,13 +236,24 @@ private:
 
     fd::FileDescriptor m_fd;
 
-    std::array<DumbBuffer, 2> m_dbs;
+    std::vector<DumbBuffer> m_dbs;
     int m_dbFront;
     int m_dbBack;
+    int m_dbPending;
+    int m_dbLatest;
+    std::deque<int> m_dbQueued;
 
     bool m_hasAtomic;
     bool m_hasUniversalPlanes;
     std::vector<AtomicProperty> m_atomicProperties;
+    uint32_t m_damageClipsPropertyId;
+    bool m_trackDamage;
+    bool m_monotonicTimestamps;
+    FrameStatistics m_statistics;
+    std::string m_frameDump;
+    int m_frameNumber;
+    bool m_headless;
+    unsigned int m_headlessSequence;
     uint32_t m_blobId;
     uint32_t m_connectorId;
     uint32_t m_crtcId;
@@ -116,7 +116,7 @@ fb32::Image8880::copy(
     const fb32::Interface8880Base& i)
 {
     m_dimensions = i.getDimensions();
-    m_buffer.reserve(m_dimensions.area());
+    m_buffer.resize(m_dimensions.area());
 
     for (auto y = 0 ; y < m_dimensions.height() ; ++y)
     {
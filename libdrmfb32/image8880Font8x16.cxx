@@ -25,15 +25,281 @@
 //
 //-------------------------------------------------------------------------
 
+#include <algorithm>
+#include <array>
 #include <cstddef>
+#include <limits>
+#include <string_view>
 
 #include "image8880.h"
 #include "image8880Font8x16.h"
+#include "interface8880Base.h"
 #include "point.h"
 #include "rgb8880.h"
 
+//=========================================================================
+
+namespace
+{
+
+//-------------------------------------------------------------------------
+
+constexpr int c_glyphWidth{8};
+
+//-------------------------------------------------------------------------
+
+// Each bit of a font byte expanded to a whole pixel mask, most significant
+// bit first, so that a row of a glyph is written as 8 pixels without
+// testing any bits. The compiler turns the masked writes into vector
+// blends where the target has them.
+
+using GlyphRowMask = std::array<uint32_t, c_glyphWidth>;
+
+constexpr auto c_glyphRowMasks = []
+{
+    std::array<GlyphRowMask, 256> masks{};
+
+    for (std::size_t byte = 0 ; byte < masks.size() ; ++byte)
+    {
+        for (int i = 0 ; i < c_glyphWidth ; ++i)
+        {
+            const auto bit = (byte >> (c_glyphWidth - 1 - i)) & 1;
+            masks[byte][i] = bit ? 0xFFFFFFFF : 0;
+        }
+    }
+
+    return masks;
+}();
+
+//-------------------------------------------------------------------------
+
+// One line of text, drawn a row of pixels at a time right across the line
+// so that the image is written in order. The rows and the characters are
+// clipped once for the whole line, and the area drawn is added to the
+// damage of the image when the line is destroyed.
+
+class TextLine
+{
+public:
+
+    TextLine(
+        fb32::Interface8880Base& image,
+        fb32::Point8880 p,
+        const uint8_t* glyphs,
+        int height);
+
+    ~TextLine();
+
+    TextLine(const TextLine&) = delete;
+    TextLine& operator=(const TextLine&) = delete;
+
+    void
+    draw(
+        std::string_view text,
+        uint32_t rgb)
+    {
+        write<false>(text, rgb, 0);
+    }
+
+    void
+    draw(
+        std::string_view text,
+        uint32_t rgb,
+        uint32_t background)
+    {
+        write<true>(text, rgb, background);
+    }
+
+private:
+
+    template<bool OPAQUE>
+    void
+    write(
+        std::string_view text,
+        uint32_t rgb,
+        uint32_t background);
+
+    const uint8_t* m_glyphs;
+    int m_height;
+    fb32::Interface8880Base& m_image;
+    int m_jEnd{};
+    int m_jStart{};
+    uint32_t* m_row{};
+    std::ptrdiff_t m_stride{};
+    int m_width{};
+    int m_x{};
+    int m_xMax{};
+    int m_xMin{};
+    int m_y{};
+};
+
 //-------------------------------------------------------------------------
 
+TextLine::TextLine(
+    fb32::Interface8880Base& image,
+    fb32::Point8880 p,
+    const uint8_t* glyphs,
+    int height)
+:
+    m_glyphs{glyphs},
+    m_height{height},
+    m_image{image},
+    m_width{image.getDimensions().width()},
+    m_x{p.x()},
+    m_xMax{std::numeric_limits<int>::min()},
+    m_xMin{std::numeric_limits<int>::max()},
+    m_y{p.y()}
+{
+    const auto imageHeight = image.getDimensions().height();
+
+    m_jStart = std::clamp(-m_y, 0, height);
+    m_jEnd = std::clamp(imageHeight - m_y, m_jStart, height);
+
+    if (m_jStart < m_jEnd)
+    {
+        m_row = image.getRow(m_y + m_jStart).data();
+        m_stride = image.offset(fb32::Point8880{0, 1}) -
+                   image.offset(fb32::Point8880{0, 0});
+    }
+}
+
+//-------------------------------------------------------------------------
+
+TextLine::~TextLine()
+{
+    if (m_xMin < m_xMax)
+    {
+        m_image.addDamage(fb32::Point8880{m_xMin, m_y + m_jStart},
+                          fb32::Dimensions8880{m_xMax - m_xMin, m_jEnd - m_jStart});
+    }
+}
+
+//-------------------------------------------------------------------------
+
+template<bool OPAQUE>
+void
+TextLine::write(
+    std::string_view text,
+    uint32_t rgb,
+    uint32_t background)
+{
+    // Character k covers columns x0 + k * c_glyphWidth onwards. The
+    // members are copied, as the compiler must otherwise assume that
+    // writing a pixel could change them.
+
+    const auto* glyphs = m_glyphs;
+    const int height = m_height;
+    const int width = m_width;
+    const int x0 = m_x;
+
+    const int count = static_cast<int>(text.size());
+    const int kStart = (x0 < 0) ? std::min(count, -x0 / c_glyphWidth) : 0;
+    const int kEnd = (x0 < width)
+                   ? std::min(count, (width - x0 + c_glyphWidth - 1) / c_glyphWidth)
+                   : 0;
+
+    if ((kStart >= kEnd) or (m_jStart >= m_jEnd))
+    {
+        return;
+    }
+
+    auto* row = m_row;
+
+    for (int j = m_jStart ; j < m_jEnd ; ++j, row += m_stride)
+    {
+        for (int k = kStart ; k < kEnd ; ++k)
+        {
+            const auto c = static_cast<uint8_t>(text[k]);
+            const auto byte = glyphs[(c * height) + j];
+
+            if constexpr (not OPAQUE)
+            {
+                if (byte == 0)
+                {
+                    continue;
+                }
+            }
+
+            const GlyphRowMask mask = c_glyphRowMasks[byte];
+            const int x = x0 + (k * c_glyphWidth);
+
+            auto blend = [&](int i)
+            {
+                const auto pixel = OPAQUE ? background : row[x + i];
+                row[x + i] = (pixel & ~mask[i]) | (rgb & mask[i]);
+            };
+
+            if ((x >= 0) and (x + c_glyphWidth <= width))
+            {
+                for (int i = 0 ; i < c_glyphWidth ; ++i)
+                {
+                    blend(i);
+                }
+            }
+            else
+            {
+                const int iStart = std::max(0, -x);
+                const int iEnd = std::min(c_glyphWidth, width - x);
+
+                for (int i = iStart ; i < iEnd ; ++i)
+                {
+                    blend(i);
+                }
+            }
+        }
+    }
+
+    m_xMin = std::min(m_xMin, std::max(0, m_x + (kStart * c_glyphWidth)));
+    m_xMax = std::max(m_xMax, std::min(m_width, m_x + (kEnd * c_glyphWidth)));
+}
+
+//-------------------------------------------------------------------------
+
+// Draw each line of sv with draw(line, text), where a line starts at p.x()
+// and each line is height below the one before.
+
+template<typename DRAW>
+fb32::Point8880
+drawLines(
+    fb32::Interface8880Base& image,
+    fb32::Point8880 p,
+    std::string_view sv,
+    const uint8_t* glyphs,
+    int height,
+    DRAW draw)
+{
+    fb32::Point8880 position{p};
+
+    for (;;)
+    {
+        const auto newline = sv.find('\n');
+        const auto text = sv.substr(0, newline);
+
+        {
+            TextLine line{image, position, glyphs, height};
+            draw(line, text);
+        }
+
+        position.translateX(static_cast<int>(text.size()) * c_glyphWidth);
+
+        if (newline == std::string_view::npos)
+        {
+            break;
+        }
+
+        sv.remove_prefix(newline + 1);
+        position.set(p.x(), position.y() + height);
+    }
+
+    return position;
+}
+
+//-------------------------------------------------------------------------
+
+} // namespace
+
+//=========================================================================
+
 namespace fb32
 {
 
@@ -4737,6 +5003,16 @@ Image8880Font8x16::drawChar(
 {
     const auto d = getPixelDimensions();
 
+    if (auto base = dynamic_cast<Interface8880Base*>(&image))
+    {
+        const char text{static_cast<char>(c)};
+
+        TextLine line{*base, p, &font[0][0], d.height()};
+        line.draw(std::string_view{&text, 1}, rgb);
+
+        return Point8880(p.x() + d.width(), p.y());
+    }
+
     for (auto j = 0 ; j < d.height() ; ++j)
     {
         const auto byte = font[c][j];
@@ -4780,6 +5056,16 @@ Image8880Font8x16::drawString(
     Interface8880& image)
 {
     const auto d = getPixelDimensions();
+
+    if (auto base = dynamic_cast<Interface8880Base*>(&image))
+    {
+        return drawLines(*base, p, sv, &font[0][0], d.height(),
+                         [rgb](TextLine& line, std::string_view text)
+                         {
+                             line.draw(text, rgb);
+                         });
+    }
+
     Point8880 position{p};
     Point8880 start{p};
 
@@ -4806,4 +5092,36 @@ Image8880Font8x16::drawString(
 
 //-------------------------------------------------------------------------
 
+Point8880
+Image8880Font8x16::drawString(
+    Point8880 p,
+    std::string_view sv,
+    const RGB8880& rgb,
+    const RGB8880& background,
+    Interface8880Base& image)
+{
+    return drawString(p, sv, rgb.get8880(), background.get8880(), image);
+}
+
+//-------------------------------------------------------------------------
+
+Point8880
+Image8880Font8x16::drawString(
+    Point8880 p,
+    std::string_view sv,
+    uint32_t rgb,
+    uint32_t background,
+    Interface8880Base& image)
+{
+    const auto d = getPixelDimensions();
+
+    return drawLines(image, p, sv, &font[0][0], d.height(),
+                     [rgb, background](TextLine& line, std::string_view text)
+                     {
+                         line.draw(text, rgb, background);
+                     });
+}
+
+//-------------------------------------------------------------------------
+
 } // namespace fb32
@@ -47,6 +47,7 @@ using Point8880 = Point<int>;
 
 //-------------------------------------------------------------------------
 
+class Interface8880Base;
 class RGB8880;
 
 //-------------------------------------------------------------------------
@@ -98,6 +99,26 @@ public:
         std::string_view sv,
         uint32_t rgb,
         Interface8880& image) final;
+
+    // Draw sv writing the whole of each character cell, rgb where the
+    // glyph is set and background elsewhere, so there is no need to clear
+    // behind the text first.
+
+    Point8880
+    drawString(
+        Point8880 p,
+        std::string_view sv,
+        const RGB8880& rgb,
+        const RGB8880& background,
+        Interface8880Base& image);
+
+    Point8880
+    drawString(
+        Point8880 p,
+        std::string_view sv,
+        uint32_t rgb,
+        uint32_t background,
+        Interface8880Base& image);
 };
 
 //-------------------------------------------------------------------------
@@ -27,8 +27,9 @@
 //-------------------------------------------------------------------------
 
 #include "image8880FreeType.h"
-#include "interface8880Null.h"
+#include "interface8880Base.h"
 
+#include <functional>
 #include <stdexcept>
 
 //-------------------------------------------------------------------------
@@ -123,11 +124,7 @@ fb32::Dimensions8880
 Image8880FreeType::getStringDimensions(
     std::string_view s)
 {
-    constexpr RGB8880 c{0};
-    Interface8880Null n{};
-
-    Point8880 p = drawString(Point8880{0, 0}, s, c, n);
-
+    const auto p = layoutString(Point8880{0, 0}, s, [](Point8880, const Glyph&) {});
     const auto d = getPixelDimensions();
 
     return Dimensions8880{p.x(), p.y() + d.height()};
@@ -139,14 +136,10 @@ fb32::Dimensions8880
 Image8880FreeType::getWideCharDimensions(
     uint32_t c)
 {
-    constexpr RGB8880 rgb{0};
-    Interface8880Null n{};
-
-    Point8880 p = drawWideChar(Point8880{0, 0}, c, rgb, n);
-
+    const auto glyph = findGlyph(c);
     const auto d = getPixelDimensions();
 
-    return Dimensions8880{p.x(), p.y() + d.height()};
+    return Dimensions8880{glyph ? glyph->m_advance : 0, d.height()};
 }
 
 //-------------------------------------------------------------------------
@@ -204,23 +197,16 @@ Image8880FreeType::drawWideChar(
     Interface8880& image)
 {
     Point8880 position{p};
-    position.translateY(m_face->size->metrics.ascender >> 6);
-    const auto glyph_index{FT_Get_Char_Index(m_face, c)};
 
-    if (FT_Load_Glyph(m_face, glyph_index, FT_LOAD_RENDER) == 0)
+    if (const auto glyph = findGlyph(c))
     {
-        const auto slot{m_face->glyph};
-
-        drawChar(position.x() + slot->bitmap_left,
-                 position.y() - slot->bitmap_top,
-                 slot->bitmap,
-                 rgb,
-                 image);
+        position.translateY(m_face->size->metrics.ascender >> 6);
+        drawGlyph(position, *glyph, rgb, image);
+        position.translateY(-(m_face->size->metrics.ascender >> 6));
 
-        position.translateX(slot->advance.x >> 6);
+        position.translateX(glyph->m_advance);
     }
 
-    position.translateY(-(m_face->size->metrics.ascender >> 6));
     return position;
 }
 
@@ -233,108 +219,214 @@ Image8880FreeType::drawString(
     const RGB8880& rgb,
     Interface8880& image)
 {
-    const auto d = getPixelDimensions();
-    Point8880 position{p};
-    position.translateY(m_face->size->metrics.ascender >> 6);
+    return layoutString(p, sv, [&](Point8880 position, const Glyph& glyph)
+    {
+        drawGlyph(position, glyph, rgb, image);
+    });
+}
 
-    auto slot{m_face->glyph};
-    const auto use_kerning{FT_HAS_KERNING(m_face)};
-    FT_UInt previous{0};
+//-------------------------------------------------------------------------
 
-    for (const auto c : sv)
+Point8880
+Image8880FreeType::drawString(
+    Point8880 p,
+    std::string_view sv,
+    uint32_t rgb,
+    Interface8880& image)
+{
+    return drawString(p, sv, RGB8880(rgb), image);
+}
+
+//-------------------------------------------------------------------------
+
+std::size_t
+Image8880FreeType::CacheKeyHash::operator()(
+    const CacheKey& key) const noexcept
+{
+    const std::hash<FT_ULong> hash;
+
+    auto seed = hash(key.m_pixelSize);
+    seed ^= hash(key.m_first) + 0x9E3779B9 + (seed << 6) + (seed >> 2);
+    seed ^= hash(key.m_second) + 0x9E3779B9 + (seed << 6) + (seed >> 2);
+
+    return seed;
+}
+
+//-------------------------------------------------------------------------
+
+void
+Image8880FreeType::drawGlyph(
+    Point8880 p,
+    const Glyph& glyph,
+    const RGB8880& rgb,
+    Interface8880& image)
+{
+    const Point8880 position{p.x() + glyph.m_offset.x(),
+                             p.y() + glyph.m_offset.y()};
+
+    if (auto base = dynamic_cast<Interface8880Base*>(&image))
     {
-        if (c == '\n')
-        {
-            position.set(p.x(), position.y() + d.height());
-        }
-        else
+        base->blendCoverage(position, glyph.m_dimensions, glyph.m_coverage, rgb.get8880());
+        return;
+    }
+
+    const auto width = glyph.m_dimensions.width();
+
+    for (int j = 0 ; j < glyph.m_dimensions.height() ; ++j)
+    {
+        for (int i = 0 ; i < width ; ++i)
         {
-            const auto glyph_index{FT_Get_Char_Index(m_face, c)};
+            const auto alpha = glyph.m_coverage[(j * width) + i];
 
-            if (use_kerning and previous and glyph_index)
+            if (alpha)
             {
-                FT_Vector delta;
+                const Point8880 pixel{position.x() + i, position.y() + j};
+                auto background{image.getPixelRGB(pixel)};
 
-                FT_Get_Kerning(m_face,
-                               previous,
-                               glyph_index,
-                               ft_kerning_default,
-                               &delta);
-
-                position.translateX(delta.x >> 6);
+                if (background)
+                {
+                    image.setPixelRGB(pixel, rgb.blend(alpha, *background));
+                }
             }
+        }
+    }
+}
 
-            if (FT_Load_Glyph(m_face, glyph_index, FT_LOAD_RENDER) == 0)
-            {
-                slot = m_face->glyph;
+//-------------------------------------------------------------------------
 
-                drawChar(position.x() + slot->bitmap_left,
-                         position.y() - slot->bitmap_top,
-                         slot->bitmap,
-                         rgb,
-                         image);
+const Image8880FreeType::Glyph*
+Image8880FreeType::findGlyph(
+    FT_ULong c)
+{
+    const CacheKey key{m_pixelSize, c, 0};
+
+    if (const auto it = m_glyphs.find(key) ; it != m_glyphs.end())
+    {
+        return it->second ? &*(it->second) : nullptr;
+    }
 
-                position.translateX(slot->advance.x >> 6);
-                previous = glyph_index;
+    auto& entry = m_glyphs[key];
+    const auto index{FT_Get_Char_Index(m_face, c)};
+
+    if (FT_Load_Glyph(m_face, index, FT_LOAD_RENDER) != 0)
+    {
+        return nullptr;
+    }
+
+    const auto slot{m_face->glyph};
+    const auto& bitmap{slot->bitmap};
+    const int width = bitmap.width;
+    const int height = bitmap.rows;
+
+    Glyph glyph{index,
+                Point8880{slot->bitmap_left, -slot->bitmap_top},
+                static_cast<int>(slot->advance.x >> 6),
+                Dimensions8880{width, height},
+                std::vector<uint8_t>(width * height)};
+
+    for (int j = 0 ; j < height ; ++j)
+    {
+        const auto* row{bitmap.buffer + (j * bitmap.pitch)};
+        auto* coverage{glyph.m_coverage.data() + (j * width)};
+
+        if (bitmap.pixel_mode == FT_PIXEL_MODE_MONO)
+        {
+            for (int i = 0 ; i < width ; ++i)
+            {
+                coverage[i] = ((row[i / 8] << (i % 8)) & 0x80) ? 255 : 0;
             }
         }
+        else
+        {
+            std::copy(row, row + width, coverage);
+        }
     }
 
-    //-----------------------------------------------------------------
+    entry = std::move(glyph);
 
-    const auto advance = slot->bitmap.width - (slot->advance.x >> 6);
+    return &*entry;
+}
+
+//-------------------------------------------------------------------------
+
+int
+Image8880FreeType::findKerning(
+    FT_UInt previous,
+    FT_UInt index)
+{
+    const CacheKey key{m_pixelSize, previous, index};
 
-    if (advance > 0)
+    if (const auto it = m_kerning.find(key) ; it != m_kerning.end())
     {
-        position.translateX(advance);
+        return it->second;
     }
 
-    position.translateY(-(m_face->size->metrics.ascender >> 6));
+    FT_Vector delta{};
 
-    return position;
+    FT_Get_Kerning(m_face,
+                   previous,
+                   index,
+                   ft_kerning_default,
+                   &delta);
+
+    return m_kerning[key] = delta.x >> 6;
 }
 
 //-------------------------------------------------------------------------
 
+template<typename DRAW>
 Point8880
-Image8880FreeType::drawString(
+Image8880FreeType::layoutString(
     Point8880 p,
     std::string_view sv,
-    uint32_t rgb,
-    Interface8880& image)
+    DRAW draw)
 {
-    return drawString(p, sv, RGB8880(rgb), image);
-}
+    const auto d = getPixelDimensions();
+    const auto ascender = m_face->size->metrics.ascender >> 6;
 
-//-------------------------------------------------------------------------
+    Point8880 position{p};
+    position.translateY(ascender);
 
-void
-Image8880FreeType::drawChar(
-        int xOffset,
-        int yOffset,
-        const FT_Bitmap& bitmap,
-        const RGB8880& rgb,
-        Interface8880& image)
-{
-    for (unsigned j = 0 ; j < bitmap.rows ; ++j)
-    {
-        const auto* row{bitmap.buffer + (j * bitmap.pitch)};
+    const auto use_kerning{FT_HAS_KERNING(m_face)};
+    const Glyph* last{};
+    FT_UInt previous{0};
 
-        for (unsigned i = 0 ; i < bitmap.width ; ++i)
+    for (const auto c : sv)
+    {
+        if (c == '\n')
         {
-            if (row[i])
+            position.set(p.x(), position.y() + d.height());
+        }
+        else if (const auto glyph = findGlyph(c))
+        {
+            if (use_kerning and previous and glyph->m_index)
             {
-                const Point8880 p{static_cast<int>(i + xOffset),
-                                           static_cast<int>(j + yOffset)};
-                auto background{image.getPixelRGB(p)};
-
-                if (background)
-                {
-                    image.setPixelRGB(p, rgb.blend(row[i], *background));
-                }
+                position.translateX(findKerning(previous, glyph->m_index));
             }
+
+            draw(position, *glyph);
+
+            position.translateX(glyph->m_advance);
+            previous = glyph->m_index;
+            last = glyph;
         }
     }
+
+    //-----------------------------------------------------------------
+
+    if (last)
+    {
+        const auto advance = last->m_dimensions.width() - last->m_advance;
+
+        if (advance > 0)
+        {
+            position.translateX(advance);
+        }
+    }
+
+    position.translateY(-ascender);
+
+    return position;
 }
 
 //-------------------------------------------------------------------------
@@ -32,8 +32,13 @@
 #include <ft2build.h>
 #include <freetype/freetype.h>
 
+#include <cstddef>
 #include <cstdint>
+#include <optional>
 #include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
 
 #include "fontConfig.h"
 #include "interface8880.h"
@@ -125,17 +130,51 @@ public:
 
 private:
 
+    // Rendered glyphs and kerning are cached by pixel size and character
+    // code (or pair of glyph indices), so text that has been drawn before
+    // is drawn again without calling FreeType.
+
+    struct CacheKey
+    {
+        int m_pixelSize{};
+        FT_ULong m_first{};
+        FT_ULong m_second{};
+
+        bool operator==(const CacheKey&) const noexcept = default;
+    };
+
+    struct CacheKeyHash
+    {
+        [[nodiscard]] std::size_t operator()(const CacheKey& key) const noexcept;
+    };
+
+    struct Glyph
+    {
+        FT_UInt m_index{};
+        Point8880 m_offset{0, 0};
+        int m_advance{};
+        Dimensions8880 m_dimensions{};
+        std::vector<uint8_t> m_coverage{};
+    };
+
     void
-    drawChar(
-        int xOffset,
-        int yOffset,
-        const FT_Bitmap& bitmap,
+    drawGlyph(
+        Point8880 p,
+        const Glyph& glyph,
         const RGB8880& rgb,
         Interface8880& image);
 
+    [[nodiscard]] const Glyph* findGlyph(FT_ULong c);
+    [[nodiscard]] int findKerning(FT_UInt previous, FT_UInt index);
+
+    template<typename DRAW>
+    Point8880 layoutString(Point8880 p, std::string_view sv, DRAW draw);
+
     int m_pixelSize{};
 
     FT_Face m_face{};
+    std::unordered_map<CacheKey, std::optional<Glyph>, CacheKeyHash> m_glyphs{};
+    std::unordered_map<CacheKey, int, CacheKeyHash> m_kerning{};
     FT_Library m_library{};
 };
 
@@ -334,6 +334,7 @@ horizontalLine(
 
     std::span<uint32_t> row = iface.getRow(y).subspan(x1, x2 - x1 + 1);
     std::fill(begin(row), end(row), rgb);
+    iface.addDamage(Point8880{x1, y}, Dimensions8880{x2 - x1 + 1, 1});
 }
 
 //-------------------------------------------------------------------------
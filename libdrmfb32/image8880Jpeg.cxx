@@ -26,12 +26,11 @@
 //-------------------------------------------------------------------------
 
 #include "image8880Jpeg.h"
+#include "mappedFile.h"
 
 //-------------------------------------------------------------------------
 
 #include <cstdint>
-#include <filesystem>
-#include <fstream>
 #include <stdexcept>
 #include <vector>
 
@@ -71,12 +70,15 @@ public:
     void decodeToGrey(fb32::Image8880& image);
     JpegDetails details() const noexcept { return m_details; }
     tjhandle instance() const noexcept { return m_instance; }
+    fb32::Dimensions8880 output() const noexcept { return m_output; }
+    void scaleToFit(fb32::Dimensions8880 target);
 
 private:
 
     std::span<const uint8_t> m_data;
     tjhandle m_instance;
     JpegDetails m_details;
+    fb32::Dimensions8880 m_output;
 };
 
 //-------------------------------------------------------------------------
@@ -86,7 +88,8 @@ TurboJpegDecode::TurboJpegDecode(
 :
     m_data{data},
     m_instance{tjInitDecompress()},
-    m_details{}
+    m_details{},
+    m_output{}
 {
     if (m_instance == nullptr)
     {
@@ -105,6 +108,8 @@ TurboJpegDecode::TurboJpegDecode(
     {
         throw std::invalid_argument("Invalid JPEG header");
     }
+
+    m_output.set(m_details.m_width, m_details.m_height);
 }
 
 //-------------------------------------------------------------------------
@@ -124,9 +129,9 @@ TurboJpegDecode::decode(
                                m_data.data(),
                                m_data.size(),
                                reinterpret_cast<unsigned char*>(image.getBuffer().data()),
-                               m_details.m_width,
-                               m_details.m_width * fb32::Interface8880Base::c_bytesPerPixel,
-                               m_details.m_height,
+                               m_output.width(),
+                               m_output.width() * fb32::Interface8880Base::c_bytesPerPixel,
+                               m_output.height(),
                                TJPF_BGRX,
                                TJFLAG_ACCURATEDCT);
 
@@ -146,9 +151,9 @@ TurboJpegDecode::decodeToGrey(
                                m_data.data(),
                                m_data.size(),
                                reinterpret_cast<unsigned char*>(greyBuffer.data()),
-                               m_details.m_width,
-                               m_details.m_width,
-                               m_details.m_height,
+                               m_output.width(),
+                               m_output.width(),
+                               m_output.height(),
                                TJPF_GRAY,
                                TJFLAG_ACCURATEDCT);
 
@@ -167,6 +172,48 @@ TurboJpegDecode::decodeToGrey(
 
 //-------------------------------------------------------------------------
 
+void
+TurboJpegDecode::scaleToFit(
+    fb32::Dimensions8880 target)
+{
+    // The DCT can be scaled by any of the factors libjpeg-turbo supports
+    // (1/8, 1/4, 3/8 ... 1) for a fraction of the cost of a full decode.
+    // Choose the smallest that still fills target in one dimension, so
+    // the image fitted to target is never enlarged from a reduced decode.
+
+    int count{0};
+    const auto* factors = tjGetScalingFactors(&count);
+
+    if (factors == nullptr)
+    {
+        return;
+    }
+
+    const auto width = m_details.m_width;
+    const auto height = m_details.m_height;
+
+    for (const auto& factor : std::span(factors, count))
+    {
+        if (factor.num >= factor.denom)
+        {
+            continue;
+        }
+
+        const fb32::Dimensions8880 scaled{TJSCALED(width, factor),
+                                          TJSCALED(height, factor)};
+
+        const bool fills = (scaled.width() >= target.width()) or
+                           (scaled.height() >= target.height());
+
+        if (fills and (scaled.area() < m_output.area()))
+        {
+            m_output = scaled;
+        }
+    }
+}
+
+//-------------------------------------------------------------------------
+
 }
 
 //=========================================================================
@@ -187,6 +234,29 @@ decodeJpeg(
 
 //-------------------------------------------------------------------------
 
+Image8880
+decodeJpeg(
+    std::span<const uint8_t> data,
+    Dimensions8880 target,
+    Dimensions8880* original)
+{
+    TurboJpegDecode tjd{data};
+    tjd.scaleToFit(target);
+
+    if (original)
+    {
+        const auto details{tjd.details()};
+        *original = Dimensions8880{details.m_width, details.m_height};
+    }
+
+    Image8880 image{tjd.output()};
+    tjd.decode(image);
+
+    return image;
+}
+
+//-------------------------------------------------------------------------
+
 void
 decodeJpegToGrey(
     Image8880& image,
@@ -202,13 +272,9 @@ Image8880
 readJpeg(
     const std::string& name)
 {
-    const auto length{std::filesystem::file_size(std::filesystem::path(name))};
+    const fb32::MappedFile file{name};
 
-    std::ifstream ifs{name, std::ios_base::binary};
-    std::vector<uint8_t> buffer(length);
-    ifs.read(reinterpret_cast<char*>(buffer.data()), buffer.size());
-
-    TurboJpegDecode tjd{buffer};
+    TurboJpegDecode tjd{file.getData()};
     auto details{tjd.details()};
     const fb32::Dimensions8880 d{details.m_width, details.m_height};
     fb32::Image8880 image{d};
@@ -220,17 +286,26 @@ readJpeg(
 
 //-------------------------------------------------------------------------
 
+Image8880
+readJpeg(
+    const std::string& name,
+    Dimensions8880 target,
+    Dimensions8880* original)
+{
+    const MappedFile file{name};
+
+    return decodeJpeg(file.getData(), target, original);
+}
+
+//-------------------------------------------------------------------------
+
 Image8880
 readJpegToGrey(
     const std::string& name)
 {
-    const auto length{std::filesystem::file_size(std::filesystem::path(name))};
-
-    std::ifstream ifs{name, std::ios_base::binary};
-    std::vector<uint8_t> buffer(length);
-    ifs.read(reinterpret_cast<char*>(buffer.data()), buffer.size());
+    const fb32::MappedFile file{name};
 
-    TurboJpegDecode tjd{buffer};
+    TurboJpegDecode tjd{file.getData()};
     auto details{tjd.details()};
     const fb32::Dimensions8880 d{details.m_width, details.m_height};
     fb32::Image8880 image{d};
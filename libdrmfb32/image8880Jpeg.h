@@ -46,6 +46,23 @@ void decodeJpegToGrey(Image8880& image, std::span<const uint8_t> data);
 [[nodiscard]] Image8880 readJpeg(const std::string& name);
 [[nodiscard]] Image8880 readJpegToGrey(const std::string& name);
 
+// Decode at the smallest DCT scale (1/8, 1/4 ... 1) that is no smaller
+// than the image fitted within target, which is much faster than decoding
+// a large photograph in full and resizing it. The full size of the image
+// is returned in original if given.
+
+[[nodiscard]] Image8880
+decodeJpeg(
+    std::span<const uint8_t> data,
+    Dimensions8880 target,
+    Dimensions8880* original = nullptr);
+
+[[nodiscard]] Image8880
+readJpeg(
+    const std::string& name,
+    Dimensions8880 target,
+    Dimensions8880* original = nullptr);
+
 //-------------------------------------------------------------------------
 
 } // namespace fb32
@@ -27,13 +27,12 @@
 
 #include "image8880.h"
 #include "image8880Png.h"
+#include "mappedFile.h"
 
 //-------------------------------------------------------------------------
 
 #include <algorithm>
 #include <cstdint>
-#include <filesystem>
-#include <fstream>
 #include <stdexcept>
 #include <vector>
 
@@ -305,13 +304,8 @@ readPng(
     const std::string& name,
     const fb32::RGB8880& background)
 {
-    const auto length{std::filesystem::file_size(std::filesystem::path(name))};
-
-    std::ifstream ifs{name, std::ios_base::binary};
-    std::vector<uint8_t> buffer(length);
-    ifs.read(reinterpret_cast<char*>(buffer.data()), buffer.size());
-
-    PngDecode pd{buffer, background};
+    const MappedFile file{name};
+    PngDecode pd{file.getData(), background};
 
     return pd.decode();
 }
@@ -26,62 +26,131 @@
 //-------------------------------------------------------------------------
 
 #include <algorithm>
+#include <array>
 #include <cmath>
 #include <functional>
 #include <mutex>
 #include <numbers>
 #include <stdexcept>
+#include <vector>
 
+#include "fixedPoint.h"
 #include "image8880.h"
 #include "image8880Process.h"
-
-#ifdef WITH_BS_THREAD_POOL
-#include "BS_thread_pool.hpp"
-#endif
+#include "threadPool.h"
 
 //-------------------------------------------------------------------------
 
 using size_type = std::vector<uint32_t>::size_type;
 using Point = fb32::Point8880;
 
+#ifdef WITH_BS_THREAD_POOL
+using fb32::threadPool;
+#endif
+
 //=========================================================================
 
 namespace {
 
 //-------------------------------------------------------------------------
 
-class AccumulateRGB8880
+class BoxBlurDivide
 {
 public:
 
-    void add(const fb32::RGB8880& rgb) noexcept
+    // Divide a channel sum by the blur diameter. For the radii we
+    // normally use the division is replaced by an exact multiply and
+    // shift, which lets the compiler vectorize the blur loops.
+
+    explicit BoxBlurDivide(int diameter) noexcept
+    :
+        m_diameter{static_cast<uint32_t>(diameter)},
+        m_multiplier{((1U << c_shift) + m_diameter - 1) / m_diameter},
+        m_exact{(255U * m_diameter * m_diameter) < (1U << c_shift)}
     {
-        const auto rgb8 = rgb.getRGB8();
-        m_red += rgb8.red;
-        m_green += rgb8.green;
-        m_blue += rgb8.blue;
     }
 
-    void subtract(const fb32::RGB8880& rgb) noexcept
+    [[nodiscard]] bool exact() const noexcept { return m_exact; }
+
+    [[nodiscard]] uint32_t multiply(uint32_t sum) const noexcept
     {
-        const auto rgb8 = rgb.getRGB8();
-        m_red -= rgb8.red;
-        m_green -= rgb8.green;
-        m_blue -= rgb8.blue;
+        return (sum * m_multiplier) >> c_shift;
     }
 
-    [[nodiscard]] fb32::RGB8880 average(int count) const noexcept
+    [[nodiscard]] uint32_t divide(uint32_t sum) const noexcept
     {
-        return fb32::RGB8880{static_cast<uint8_t>(m_red / count),
-                             static_cast<uint8_t>(m_green / count),
-                             static_cast<uint8_t>(m_blue / count)};
+        return sum / m_diameter;
     }
 
 private:
 
-    int m_red{0};
-    int m_green{0};
-    int m_blue{0};
+    static constexpr uint32_t c_shift{24};
+
+    uint32_t m_diameter;
+    uint32_t m_multiplier;
+    bool m_exact;
+};
+
+//-------------------------------------------------------------------------
+
+constexpr int c_resizePrecisionBits{16};
+constexpr int c_bilinearFractionBits{c_resizePrecisionBits / 2};
+constexpr int32_t c_bilinearOne{1 << c_bilinearFractionBits};
+
+// The horizontal Lanczos3 pass keeps this many fractional bits, and any
+// overshoot, for each channel. Lanczos3 weights overshoot by less than
+// 0.3, so the values fit in an int16_t, and the vertical pass adds them
+// up without overflowing.
+
+constexpr int c_intermediateFractionBits{5};
+
+//-------------------------------------------------------------------------
+
+template<int PRECISION_BITS = c_resizePrecisionBits>
+class ResizeAccumulator
+{
+public:
+
+    void add(uint32_t pixel, int32_t coefficient) noexcept
+    {
+        m_red += fb32::getRed(pixel) * coefficient;
+        m_green += fb32::getGreen(pixel) * coefficient;
+        m_blue += fb32::getBlue(pixel) * coefficient;
+    }
+
+    void add(const int16_t* channels, int32_t coefficient) noexcept
+    {
+        m_red += channels[0] * coefficient;
+        m_green += channels[1] * coefficient;
+        m_blue += channels[2] * coefficient;
+    }
+
+    [[nodiscard]] uint32_t get8880() const noexcept
+    {
+        return fb32::RGB8880::rgbTo8880(clamp(m_red), clamp(m_green), clamp(m_blue));
+    }
+
+    // The sums without clamping, for a later pass.
+
+    void getChannels(int16_t* channels) const noexcept
+    {
+        channels[0] = static_cast<int16_t>(m_red >> PRECISION_BITS);
+        channels[1] = static_cast<int16_t>(m_green >> PRECISION_BITS);
+        channels[2] = static_cast<int16_t>(m_blue >> PRECISION_BITS);
+    }
+
+private:
+
+    [[nodiscard]] static uint8_t clamp(int32_t value) noexcept
+    {
+        return static_cast<uint8_t>(std::clamp(value >> PRECISION_BITS, 0, 255));
+    }
+
+    static constexpr int32_t c_round{1 << (PRECISION_BITS - 1)};
+
+    int32_t m_red{c_round};
+    int32_t m_green{c_round};
+    int32_t m_blue{c_round};
 };
 
 //-------------------------------------------------------------------------
@@ -239,72 +308,96 @@ private:
 
 //-------------------------------------------------------------------------
 
-#ifdef WITH_BS_THREAD_POOL
-
-BS::thread_pool& threadPool()
+template<typename Rows>
+void
+iterateRows(
+    int jStart,
+    int jEnd,
+    Rows rows)
 {
-    static BS::thread_pool s_threadPool;
-
-    return s_threadPool;
-}
-
+#ifdef WITH_BS_THREAD_POOL
+    auto& tPool = threadPool();
+    tPool.submit_blocks<int>(jStart, jEnd, rows).wait();
+#else
+    rows(jStart, jEnd);
 #endif
+}
 
 //-------------------------------------------------------------------------
 
+// Horizontal pass. Each row is copied into a buffer padded with the edge
+// pixels, so the running sum needs no clamping inside the loop.
+
+template<typename Divide>
 void
 boxBlurRows(
     const fb32::Interface8880Base& input,
     fb32::Image8880& rb,
     int radius,
+    Divide divide,
     int jStart,
     int jEnd)
 {
-    auto clamp = [](int value, int end) -> int
-    {
-        return std::clamp(value, 0, end - 1);
-    };
-
-    const auto d = input.getDimensions();
-
+    const auto width = input.getDimensions().width();
     const auto diameter = 2 * radius + 1;
-    const auto width = d.width();
-    auto inputi = input.getBuffer().data();
-    auto rbi = rb.getBuffer().data();
+
+    std::vector<uint32_t> padded(width + diameter);
 
     for (auto j = jStart ; j < jEnd ; ++j)
     {
-        AccumulateRGB8880 argb;
+        const auto row = input.getRow(j);
 
-        for (auto k = -radius - 1 ; k < radius ; ++k)
+        std::fill_n(padded.begin(), radius + 1, row.front());
+        std::ranges::copy(row, padded.begin() + radius + 1);
+        std::fill_n(padded.begin() + radius + 1 + width, radius, row.back());
+
+        uint32_t red{};
+        uint32_t green{};
+        uint32_t blue{};
+
+        for (auto k = 0 ; k < diameter ; ++k)
         {
-            const Point p{clamp(k, width), j};
-            argb.add(fb32::RGB8880(*(inputi + input.offset(p))));
+            const auto pixel = padded[k];
+            red += fb32::getRed(pixel);
+            green += fb32::getGreen(pixel);
+            blue += fb32::getBlue(pixel);
         }
 
+        const auto* add = padded.data() + diameter;
+        const auto* subtract = padded.data();
+        auto* output = rb.getRow(j).data();
+
         for (auto i = 0 ; i < width ; ++i)
         {
-            Point p{clamp(i + radius, width), j};
-            argb.add(fb32::RGB8880(*(inputi + input.offset(p))));
-
-            p = Point(clamp(i - radius - 1, width), j);
-            argb.subtract(fb32::RGB8880(*(inputi + input.offset(p))));
+            red += fb32::getRed(*add) - fb32::getRed(*subtract);
+            green += fb32::getGreen(*add) - fb32::getGreen(*subtract);
+            blue += fb32::getBlue(*add) - fb32::getBlue(*subtract);
+            ++add;
+            ++subtract;
 
-            p = Point(i, j);
-            *(rbi + rb.offset(p)) = argb.average(diameter).get8880();
+            *(output++) = (divide(red) << 16) | (divide(green) << 8) | divide(blue);
         }
     }
 }
 
 //-------------------------------------------------------------------------
 
+// Vertical pass. Rather than walking down each column, the columns are
+// processed in strips that are walked a row at a time, keeping a running
+// sum for every column in the strip. All memory access is then
+// sequential and the inner loops are simple enough to be vectorized.
+
+constexpr int c_boxBlurStripWidth{256};
+
+template<typename Divide>
 void
 boxBlurColumns(
     const fb32::Image8880& rb,
     fb32::Image8880& output,
     int radius,
-    int iStart,
-    int iEnd)
+    Divide divide,
+    int stripStart,
+    int stripEnd)
 {
     auto clamp = [](int value, int end) -> int
     {
@@ -312,68 +405,274 @@ boxBlurColumns(
     };
 
     const auto d = rb.getDimensions();
-    const auto diameter = 2 * radius + 1;
     const auto height = d.height();
-    const auto rbi = rb.getBuffer().data();
-    auto outputi = output.getBuffer().data();
+    const auto* rbi = rb.getBuffer().data();
+    auto* outputi = output.getBuffer().data();
 
-    for (auto i = iStart ; i < iEnd ; ++i)
+    std::array<uint32_t, c_boxBlurStripWidth> red;
+    std::array<uint32_t, c_boxBlurStripWidth> green;
+    std::array<uint32_t, c_boxBlurStripWidth> blue;
+
+    for (auto strip = stripStart ; strip < stripEnd ; ++strip)
     {
-        AccumulateRGB8880 argb;
+        const auto iStart = strip * c_boxBlurStripWidth;
+        const auto width = std::min(c_boxBlurStripWidth, d.width() - iStart);
+
+        red.fill(0);
+        green.fill(0);
+        blue.fill(0);
 
         for (auto k = -radius - 1 ; k < radius ; ++k)
         {
-            const Point p{i, clamp(k, height)};
-            argb.add(fb32::RGB8880(*(rbi + rb.offset(p))));
+            const auto* row = rbi + rb.offset(Point{iStart, clamp(k, height)});
+
+            for (auto i = 0 ; i < width ; ++i)
+            {
+                red[i] += fb32::getRed(row[i]);
+                green[i] += fb32::getGreen(row[i]);
+                blue[i] += fb32::getBlue(row[i]);
+            }
         }
 
         for (auto j = 0 ; j < height ; ++j)
         {
-            Point p{i, clamp(j + radius, height)};
-            argb.add(fb32::RGB8880(*(rbi + rb.offset(p))));
+            const auto* add = rbi + rb.offset(Point{iStart, clamp(j + radius, height)});
+            const auto* subtract = rbi + rb.offset(Point{iStart, clamp(j - radius - 1, height)});
+            auto* row = outputi + output.offset(Point{iStart, j});
 
-            p = Point(i, clamp(j - radius - 1, height));
-            argb.subtract(fb32::RGB8880(*(rbi + rb.offset(p))));
+            for (auto i = 0 ; i < width ; ++i)
+            {
+                red[i] += fb32::getRed(add[i]) - fb32::getRed(subtract[i]);
+                green[i] += fb32::getGreen(add[i]) - fb32::getGreen(subtract[i]);
+                blue[i] += fb32::getBlue(add[i]) - fb32::getBlue(subtract[i]);
 
-            p = Point(i, j);
-            *(outputi + output.offset(p)) = argb.average(diameter).get8880();
+                row[i] = (divide(red[i]) << 16) |
+                         (divide(green[i]) << 8) |
+                         divide(blue[i]);
+            }
         }
     }
 }
 
 //-------------------------------------------------------------------------
 
+template<typename Divide>
 void
-rowsCountIntensity(
+boxBlurPasses(
     const fb32::Interface8880Base& input,
-    CountIntensity& count,
+    fb32::Image8880& rb,
+    fb32::Image8880& output,
+    int radius,
+    Divide divide)
+{
+    const auto d = input.getDimensions();
+    const auto strips = (d.width() + c_boxBlurStripWidth - 1) / c_boxBlurStripWidth;
+
+#ifdef WITH_BS_THREAD_POOL
+
+    auto& tPool = threadPool();
+
+    auto iterateRows = [&input, &rb, radius, divide](int start, int end)
+    {
+        boxBlurRows(input, rb, radius, divide, start, end);
+    };
+
+    tPool.submit_blocks<int>(0, d.height(), iterateRows).wait();
+
+    auto iterateColumns = [&rb, &output, radius, divide](int start, int end)
+    {
+        boxBlurColumns(rb, output, radius, divide, start, end);
+    };
+
+    tPool.submit_blocks<int>(0, strips, iterateColumns).wait();
+
+#else
+
+    boxBlurRows(input, rb, radius, divide, 0, d.height());
+    boxBlurColumns(rb, output, radius, divide, 0, strips);
+
+#endif
+}
+
+//-------------------------------------------------------------------------
+
+// enlighten() scales each pixel by an amount looked up from the box
+// blurred maximum of its channels. The maximum is only ever needed as one
+// 8 bit channel, so it is made while padding each row for the horizontal
+// blur, and the vertical blur applies the scale as each value is made.
+// The blurred values are exactly those of boxBlur(maxRGB(input)).
+
+constexpr int c_enlightenShift{16};
+constexpr uint32_t c_enlightenOne{1U << c_enlightenShift};
+
+using EnlightenTable = std::array<uint32_t, 256>;
+
+template<typename Divide>
+void
+enlightenRows(
+    const fb32::Interface8880Base& input,
+    std::vector<uint8_t>& rb,
+    int radius,
+    Divide divide,
     int jStart,
     int jEnd)
 {
-    for (int j = jStart ; j < jEnd ; ++j)
+    const auto width = input.getDimensions().width();
+    const auto diameter = 2 * radius + 1;
+
+    std::vector<uint8_t> padded(width + diameter);
+
+    for (auto j = jStart ; j < jEnd ; ++j)
     {
         const auto row = input.getRow(j);
+        auto* maximum = padded.data() + radius + 1;
 
-        for (const auto value : row)
+        for (auto i = 0 ; i < width ; ++i)
         {
-            auto pixel = fb32::RGB8880(value);
-            count.add(pixel);
+            const auto pixel = row[i];
+            maximum[i] = std::max({fb32::getRed(pixel),
+                                   fb32::getGreen(pixel),
+                                   fb32::getBlue(pixel)});
+        }
+
+        std::fill_n(padded.begin(), radius + 1, maximum[0]);
+        std::fill_n(padded.begin() + radius + 1 + width, radius, maximum[width - 1]);
+
+        uint32_t sum{};
+
+        for (auto k = 0 ; k < diameter ; ++k)
+        {
+            sum += padded[k];
+        }
+
+        const auto* add = padded.data() + diameter;
+        const auto* subtract = padded.data();
+        auto* output = rb.data() + static_cast<std::size_t>(j) * width;
+
+        for (auto i = 0 ; i < width ; ++i)
+        {
+            sum += *(add++);
+            sum -= *(subtract++);
+
+            output[i] = static_cast<uint8_t>(divide(sum));
         }
     }
 }
 
 //-------------------------------------------------------------------------
 
+template<typename Divide>
 void
-rowsCountRGB(
+enlightenColumns(
     const fb32::Interface8880Base& input,
-    CountRGB& count,
+    const std::vector<uint8_t>& rb,
+    fb32::Image8880& output,
+    const EnlightenTable& table,
+    int radius,
+    Divide divide,
+    int stripStart,
+    int stripEnd)
+{
+    const auto d = input.getDimensions();
+    const auto height = d.height();
+    const auto rowLength = static_cast<std::size_t>(d.width());
+
+    auto rbRow = [&rb, height, rowLength](int j)
+    {
+        return rb.data() + std::clamp(j, 0, height - 1) * rowLength;
+    };
+
+    std::array<uint32_t, c_boxBlurStripWidth> sum;
+
+    for (auto strip = stripStart ; strip < stripEnd ; ++strip)
+    {
+        const auto iStart = strip * c_boxBlurStripWidth;
+        const auto width = std::min(c_boxBlurStripWidth, d.width() - iStart);
+
+        sum.fill(0);
+
+        for (auto k = -radius - 1 ; k < radius ; ++k)
+        {
+            const auto* row = rbRow(k) + iStart;
+
+            for (auto i = 0 ; i < width ; ++i)
+            {
+                sum[i] += row[i];
+            }
+        }
+
+        for (auto j = 0 ; j < height ; ++j)
+        {
+            const auto* add = rbRow(j + radius) + iStart;
+            const auto* subtract = rbRow(j - radius - 1) + iStart;
+            const auto* in = input.getRow(j).data() + iStart;
+            auto* out = output.getRow(j).data() + iStart;
+
+            for (auto i = 0 ; i < width ; ++i)
+            {
+                sum[i] += add[i];
+                sum[i] -= subtract[i];
+
+                const auto pixel = in[i];
+                const auto scale = table[divide(sum[i])];
+
+                auto scaled = [scale](uint32_t channel) -> uint32_t
+                {
+                    return std::min((channel * scale) >> c_enlightenShift, 255U);
+                };
+
+                // Pixels that are bright enough are left as they are.
+
+                out[i] = (scale == c_enlightenOne)
+                       ? pixel
+                       : (scaled(fb32::getRed(pixel)) << 16) |
+                         (scaled(fb32::getGreen(pixel)) << 8) |
+                         scaled(fb32::getBlue(pixel));
+            }
+        }
+    }
+}
+
+//-------------------------------------------------------------------------
+
+template<typename Divide>
+void
+enlightenPasses(
+    const fb32::Interface8880Base& input,
+    fb32::Image8880& output,
+    const EnlightenTable& table,
+    int radius,
+    Divide divide)
+{
+    const auto d = input.getDimensions();
+    const auto strips = (d.width() + c_boxBlurStripWidth - 1) / c_boxBlurStripWidth;
+
+    std::vector<uint8_t> rb(static_cast<std::size_t>(d.width()) * d.height());
+
+    iterateRows(0, d.height(), [&input, &rb, radius, divide](int start, int end)
+    {
+        enlightenRows(input, rb, radius, divide, start, end);
+    });
+
+    iterateRows(0, strips, [&](int start, int end)
+    {
+        enlightenColumns(input, rb, output, table, radius, divide, start, end);
+    });
+}
+
+//-------------------------------------------------------------------------
+
+void
+rowsCountIntensity(
+    const fb32::Interface8880Base& input,
+    CountIntensity& count,
     int jStart,
     int jEnd)
 {
     for (int j = jStart ; j < jEnd ; ++j)
     {
         const auto row = input.getRow(j);
+
         for (const auto value : row)
         {
             auto pixel = fb32::RGB8880(value);
@@ -385,58 +684,19 @@ rowsCountRGB(
 //-------------------------------------------------------------------------
 
 void
-rowsBilinearInterpolation(
+rowsCountRGB(
     const fb32::Interface8880Base& input,
-    fb32::Image8880& output,
+    CountRGB& count,
     int jStart,
     int jEnd)
 {
-    const auto id = input.getDimensions();
-    const auto od = output.getDimensions();
-    const auto xScale = (od.width() > 1)
-                      ? (id.width() - 1.0f) / (od.width() - 1.0f)
-                      : 0.0f;
-    const auto yScale = (od.height() > 1)
-                      ? (id.height() - 1.0f) / (od.height() - 1.0f)
-                      : 0.0f;
-
-    for (int j = jStart; j < jEnd; ++j)
+    for (int j = jStart ; j < jEnd ; ++j)
     {
-        for (int i = 0; i < od.width(); ++i)
+        const auto row = input.getRow(j);
+        for (const auto value : row)
         {
-            int xLow = static_cast<int>(std::floor(xScale * i));
-            int yLow = static_cast<int>(std::floor(yScale * j));
-            int xHigh = static_cast<int>(std::ceil(xScale * i));
-            int yHigh = static_cast<int>(std::ceil(yScale * j));
-
-            const auto xWeight = (xScale * i) - xLow;
-            const auto yWeight = (yScale * j) - yLow;
-
-            auto a = *input.getPixelRGB8(Point{xLow, yLow});
-            auto b = *input.getPixelRGB8(Point{xHigh, yLow});
-            auto c = *input.getPixelRGB8(Point{xLow, yHigh});
-            auto d = *input.getPixelRGB8(Point{xHigh, yHigh});
-
-            const auto aWeight = (1.0f - xWeight) * (1.0f - yWeight);
-            const auto bWeight = xWeight * (1.0f - yWeight);
-            const auto cWeight = (1.0f - xWeight) * yWeight;
-            const auto dWeight = xWeight * yWeight;
-
-            auto evaluate = [&](const uint8_t fb32::RGB8::* channel) -> uint8_t
-            {
-                float value = a.*channel * aWeight
-                            + b.*channel * bWeight
-                            + c.*channel * cWeight
-                            + d.*channel * dWeight;
-
-                return static_cast<uint8_t>(std::clamp(value, 0.0f, 255.0f));
-            };
-
-            fb32::RGB8880 rgb{evaluate(&fb32::RGB8::red),
-                              evaluate(&fb32::RGB8::green),
-                              evaluate(&fb32::RGB8::blue)};
-
-            output.setPixelRGB(Point{i, j}, rgb);
+            auto pixel = fb32::RGB8880(value);
+            count.add(pixel);
         }
     }
 }
@@ -510,97 +770,139 @@ lanczosKernel(float x, int a)
 //-------------------------------------------------------------------------
 
 void
-rowsLanczos3Interpolation(
+rowsScaleUp(
     const fb32::Interface8880Base& input,
     fb32::Image8880& output,
+    uint8_t scale,
     int jStart,
     int jEnd)
 {
     const auto id = input.getDimensions();
-    const auto od = output.getDimensions();
-    constexpr int a{3};
-    const auto xScale = (od.width() > 1)
-                      ? (id.width() - 1.0f) / (od.width() - 1.0f)
-                      : 0.0f;
-    const auto yScale = (od.height() > 1)
-                      ? (id.height() - 1.0f) / (od.height() - 1.0f)
-                      : 0.0f;
+    auto inputi = input.getBuffer().data() + (jStart * id.width());
 
-    for (int j = jStart; j < jEnd; ++j)
+    for (auto j = jStart ; j < jEnd ; ++j)
     {
-        for (int i = 0; i < od.width(); ++i)
+        for (int i = 0 ; i < id.width() ; ++i)
         {
-            const auto xMid = i * xScale;
-            const auto yMid = j * yScale;
-
-            const auto xLow = std::max(0, static_cast<int>(std::floor(xMid)) - a + 1);
-            const auto xHigh = std::min(id.width() - 1, static_cast<int>(std::floor(xMid)) + a);
-            const auto yLow = std::max(0, static_cast<int>(std::floor(yMid)) - a + 1);
-            const auto yHigh = std::min(id.height() - 1, static_cast<int>(std::floor(yMid)) + a);
-
-            float weightsSum{};
-            float redSum{};
-            float greenSum{};
-            float blueSum{};
-
-            for (int y = yLow; y <= yHigh; ++y)
+            auto pixel = *(inputi++);
+            for (int b = 0 ; b < scale ; ++b)
             {
-                const auto dy = yMid - y;
-                const auto yKernelValue = lanczosKernel(dy, a);
-
-                for (int x = xLow; x <= xHigh; ++x)
+                for (int a = 0 ; a < scale ; ++a)
                 {
-                    const auto dx = xMid - x;
-                    const auto weight = lanczosKernel(dx, a) * yKernelValue;
-                    weightsSum += weight;
-
-                    auto rgb = *input.getPixelRGB(Point{x, y});
-                    const auto rgb8 = rgb.getRGB8();
-                    redSum += rgb8.red * weight;
-                    greenSum += rgb8.green * weight;
-                    blueSum += rgb8.blue * weight;
+                    Point p{(i * scale) + a, (j * scale) + b};
+                    output.setPixel(p, pixel);
                 }
             }
-
-            const auto red = std::clamp(redSum / weightsSum, 0.0f, 255.0f);
-            const auto green = std::clamp(greenSum / weightsSum, 0.0f, 255.0f);
-            const auto blue = std::clamp(blueSum / weightsSum, 0.0f, 255.0f);
-
-            fb32::RGB8880 rgb{static_cast<uint8_t>(red),
-                                static_cast<uint8_t>(green),
-                                static_cast<uint8_t>(blue)};
-
-            output.setPixelRGB(Point{i, j}, rgb);
         }
     }
 }
 
 //-------------------------------------------------------------------------
 
+// Output pixel (i, j) is sampled from the input at (x, y) where
+//
+//   x = a * i + b * j + c
+//   y = d * i + e * j + f
+
+struct RotateMapping
+{
+    double a;
+    double b;
+    double c;
+    double d;
+    double e;
+    double f;
+};
+
+//-------------------------------------------------------------------------
+
+// For each output row the span of pixels that fall inside the input is
+// found exactly in 16.16 fixed point, the rest of the row is background.
+// Within the span the source position is stepped incrementally and
+// sampled bilinearly with 8 bit weights.
+
 void
-rowsNearestNeighbour(
+rowsRotate(
     const fb32::Interface8880Base& input,
     fb32::Image8880& output,
+    uint32_t background,
+    const RotateMapping& m,
     int jStart,
     int jEnd)
 {
     const auto id = input.getDimensions();
     const auto od = output.getDimensions();
-    const int a = (od.width() > id.width()) ? 0 : 1;
-    const int b = (od.height() > id.height()) ? 0 : 1;
+    const auto width = id.width();
+    const auto height = id.height();
+
+    const auto* pixels = input.getBuffer().data();
+    const auto stride = static_cast<std::ptrdiff_t>(input.offset(Point{0, 1}) -
+                                                    input.offset(Point{0, 0}));
+
+    const int64_t xMaximum{static_cast<int64_t>(width - 1) << fb32::c_fixedPointShift};
+    const int64_t yMaximum{static_cast<int64_t>(height - 1) << fb32::c_fixedPointShift};
+    const auto xStep = static_cast<int32_t>(std::lround(m.a * fb32::c_fixedPointOne));
+    const auto yStep = static_cast<int32_t>(std::lround(m.d * fb32::c_fixedPointOne));
 
     for (int j = jStart ; j < jEnd ; ++j)
     {
-        const int y = (j * (id.height() - b)) / (od.height() - b);
-        for (int i = 0 ; i < od.width() ; ++i)
+        const auto xStart = std::llround((m.b * j + m.c) * fb32::c_fixedPointOne);
+        const auto yStart = std::llround((m.e * j + m.f) * fb32::c_fixedPointOne);
+
+        int first{0};
+        int last{od.width() - 1};
+
+        fb32::clipFixedPointSpan(xStart, xStep, xMaximum, first, last);
+        fb32::clipFixedPointSpan(yStart, yStep, yMaximum, first, last);
+
+        auto row = output.getRow(j);
+
+        if (first > last)
         {
-            const int x = (i * (id.width() - a)) / (od.width() - a);
-            auto pixel{input.getPixel(Point{x, y})};
+            std::ranges::fill(row, background);
+            continue;
+        }
+
+        std::fill(row.begin(), row.begin() + first, background);
+        std::fill(row.begin() + last + 1, row.end(), background);
+
+        auto x = static_cast<int32_t>(xStart + first * int64_t{xStep});
+        auto y = static_cast<int32_t>(yStart + first * int64_t{yStep});
+        auto* out = row.data();
+
+        for (int i = first ; i <= last ; ++i)
+        {
+            const auto ix = x >> fb32::c_fixedPointShift;
+            const auto iy = y >> fb32::c_fixedPointShift;
+            const uint32_t fx = (x >> 8) & 0xFF;
+            const uint32_t fy = (y >> 8) & 0xFF;
+
+            // On the last column or row the fraction is zero, so the
+            // neighbour is not needed.
+
+            const auto* p0 = pixels + (iy * stride) + ix;
+            const auto* p1 = p0 + ((iy < height - 1) ? stride : 0);
+            const auto nx = (ix < width - 1) ? 1 : 0;
 
-            if (pixel.has_value())
+            const auto w00 = (256 - fx) * (256 - fy);
+            const auto w10 = fx * (256 - fy);
+            const auto w01 = (256 - fx) * fy;
+            const auto w11 = fx * fy;
+
+            auto channel = [&](int shift) -> uint32_t
             {
-                output.setPixel(Point{i, j}, pixel.value());
-            }
+                const auto value = ((p0[0] >> shift) & 0xFF) * w00 +
+                                   ((p0[nx] >> shift) & 0xFF) * w10 +
+                                   ((p1[0] >> shift) & 0xFF) * w01 +
+                                   ((p1[nx] >> shift) & 0xFF) * w11;
+
+                return value >> 16;
+            };
+
+            out[i] = (channel(16) << 16) | (channel(8) << 8) | channel(0);
+
+            x += xStep;
+            y += yStep;
         }
     }
 }
@@ -608,10 +910,9 @@ rowsNearestNeighbour(
 //-------------------------------------------------------------------------
 
 void
-rowsScaleUp(
+rowsToGrey(
     const fb32::Interface8880Base& input,
     fb32::Image8880& output,
-    uint8_t scale,
     int jStart,
     int jEnd)
 {
@@ -623,14 +924,9 @@ rowsScaleUp(
         for (int i = 0 ; i < id.width() ; ++i)
         {
             auto pixel = *(inputi++);
-            for (int b = 0 ; b < scale ; ++b)
-            {
-                for (int a = 0 ; a < scale ; ++a)
-                {
-                    Point p{(i * scale) + a, (j * scale) + b};
-                    output.setPixel(p, pixel);
-                }
-            }
+            const Point p{i, j};
+
+            output.setPixel(p, fb32::RGB8880(pixel).toGrey().get8880());
         }
     }
 }
@@ -638,94 +934,328 @@ rowsScaleUp(
 //-------------------------------------------------------------------------
 
 void
-rowsRotate(
-    const fb32::Image8880& image,
+rowsToGreen(
+    const fb32::Interface8880Base& input,
     fb32::Image8880& output,
-    double sinAngle,
-    double cosAngle,
     int jStart,
     int jEnd)
 {
-    const auto id = image.getDimensions();
-    const auto od = output.getDimensions();
+    const auto id = input.getDimensions();
+    auto inputi = input.getBuffer().data() + (jStart * id.width());
+
+    for (auto j = jStart ; j < jEnd ; ++j)
+    {
+        for (int i = 0 ; i < id.width() ; ++i)
+        {
+            auto pixel = *(inputi++);
+            const Point p{i, j};
+            const fb32::RGB8880 rgb{pixel};
+            const auto intensity = rgb.toIntensity();
+            const fb32::RGB8880 green{0, intensity, 0};
 
-    const auto y00 = id.height() * cosAngle;
+            output.setPixel(p, green.get8880());
+        }
+    }
+}
 
-    for (int j = jStart ; j < jEnd ; ++j)
+//-------------------------------------------------------------------------
+
+void
+CountIntensity::count(
+    const fb32::Interface8880Base& input)
+{
+    const auto d = input.getDimensions();
+
+#ifdef WITH_BS_THREAD_POOL
+    std::mutex countMutex;
+    auto& tPool = threadPool();
+    auto iterateRows = [this, &input, &countMutex](int start, int end)
+    {
+        CountIntensity localCount;
+        rowsCountIntensity(input, localCount, start, end);
+        std::lock_guard<std::mutex> lock(countMutex);
+        add(localCount);
+    };
+
+    tPool.submit_blocks<int>(0, d.height(), iterateRows).wait();
+#else
+    CountIntensity localCount;
+    rowsCountIntensity(input, localCount, 0, d.height());
+    add(localCount);
+#endif
+}
+
+//-------------------------------------------------------------------------
+
+void
+CountRGB::count(
+    const fb32::Interface8880Base& input)
+{
+    const auto d = input.getDimensions();
+
+#ifdef WITH_BS_THREAD_POOL
+    std::mutex countMutex;
+    auto& tPool = threadPool();
+    auto iterateRows = [this, &input, &countMutex](int start, int end)
     {
-        const auto b = y00 - j;
-        const auto bSinAngle = b * sinAngle;
-        const auto bCosAngle = b * cosAngle;
+        CountRGB localCount;
+        rowsCountRGB(input, localCount, start, end);
+        std::lock_guard<std::mutex> lock(countMutex);
+        add(localCount);
+    };
+
+    tPool.submit_blocks<int>(0, d.height(), iterateRows).wait();
+#else
+    CountRGB localCount;
+    rowsCountRGB(input, localCount, 0, d.height());
+    add(localCount);
+#endif
+}
+
+//-------------------------------------------------------------------------
+
+};
+
+//=========================================================================
+
+fb32::ResizePlan::ResizePlan(
+    Dimensions8880 input,
+    Dimensions8880 output,
+    Filter filter)
+:
+    m_columns{},
+    m_filter{filter},
+    m_horizontal{},
+    m_input{input},
+    m_intermediate{},
+    m_output{output},
+    m_rows{},
+    m_vertical{}
+{
+    if ((input.width() <= 0) or
+        (input.height() <= 0) or
+        (output.width() <= 0) or
+        (output.height() <= 0))
+    {
+        throw std::invalid_argument("width and height must be greater than zero");
+    }
+
+    switch (m_filter)
+    {
+    case Filter::NEAREST_NEIGHBOUR:
+
+        m_columns = nearestNeighbourSamples(input.width(), output.width());
+        m_rows = nearestNeighbourSamples(input.height(), output.height());
+        break;
+
+    case Filter::BILINEAR:
+
+        m_columns = bilinearSamples(input.width(), output.width());
+        m_rows = bilinearSamples(input.height(), output.height());
+        break;
+
+    case Filter::LANCZOS3:
+
+        m_horizontal = lanczos3Weights(input.width(), output.width());
+        m_vertical = lanczos3Weights(input.height(), output.height());
+        m_intermediate.resize(static_cast<std::size_t>(output.width()) *
+                              input.height() *
+                              c_intermediateChannels);
+        break;
+    }
+}
 
-        for (int i = 0 ; i < od.width() ; ++i)
+//-------------------------------------------------------------------------
+
+fb32::Image8880&
+fb32::ResizePlan::resize(
+    const Interface8880Base& input,
+    Image8880& output)
+{
+    if ((input.getDimensions() != m_input) or
+        (output.getDimensions() != m_output))
+    {
+        throw std::invalid_argument("image dimensions do not match resize plan");
+    }
+
+    switch (m_filter)
+    {
+    case Filter::NEAREST_NEIGHBOUR:
+
+        iterateRows(0, m_output.height(), [this, &input, &output](int start, int end)
+        {
+            resizeNearestNeighbour(input, output, start, end);
+        });
+        break;
+
+    case Filter::BILINEAR:
+
+        iterateRows(0, m_output.height(), [this, &input, &output](int start, int end)
+        {
+            resizeBilinear(input, output, start, end);
+        });
+        break;
+
+    case Filter::LANCZOS3:
+    {
+        // only the input rows used by the vertical pass need resizing
+
+        const auto last = m_output.height() - 1;
+        const auto jStart = m_vertical.m_start[0];
+        const auto jEnd = m_vertical.m_start[last] + m_vertical.m_count[last];
+
+        iterateRows(jStart, jEnd, [this, &input](int start, int end)
+        {
+            resizeHorizontal(input, start, end);
+        });
+
+        iterateRows(0, m_output.height(), [this, &output](int start, int end)
+        {
+            resizeVertical(output, start, end);
+        });
+        break;
+    }
+    }
+
+    return output;
+}
+
+//-------------------------------------------------------------------------
+
+fb32::ResizePlan::Samples
+fb32::ResizePlan::bilinearSamples(
+    int inputSize,
+    int outputSize)
+{
+    const auto scale = (outputSize > 1)
+                     ? (inputSize - 1.0f) / (outputSize - 1.0f)
+                     : 0.0f;
+
+    Samples samples;
+    samples.m_low.resize(outputSize);
+    samples.m_high.resize(outputSize);
+    samples.m_fraction.resize(outputSize);
+
+    for (int i = 0 ; i < outputSize ; ++i)
+    {
+        const auto position = scale * i;
+        const auto low = static_cast<int>(std::floor(position));
+
+        samples.m_low[i] = low;
+        samples.m_high[i] = std::min(low + 1, inputSize - 1);
+        samples.m_fraction[i] = static_cast<int32_t>(
+            std::lround((position - low) * c_bilinearOne));
+    }
+
+    return samples;
+}
+
+//-------------------------------------------------------------------------
+
+fb32::ResizePlan::Weights
+fb32::ResizePlan::lanczos3Weights(
+    int inputSize,
+    int outputSize)
+{
+    constexpr int a{3};
+    const auto scale = static_cast<double>(inputSize) / outputSize;
+    const auto filterScale = std::max(scale, 1.0);
+    const auto support = a * filterScale;
+
+    Weights weights;
+    weights.m_taps = 2 * static_cast<int>(std::ceil(support)) + 1;
+    weights.m_start.resize(outputSize);
+    weights.m_count.resize(outputSize);
+    weights.m_coefficients.resize(outputSize * weights.m_taps);
+
+    std::vector<double> kernel(weights.m_taps);
+
+    for (int i = 0 ; i < outputSize ; ++i)
+    {
+        const auto centre = (i + 0.5) * scale;
+        const auto start = std::max(static_cast<int>(centre - support + 0.5), 0);
+        const auto end = std::min(static_cast<int>(centre + support + 0.5), inputSize);
+        const auto count = std::min(end - start, weights.m_taps);
+
+        double total{};
+
+        for (int k = 0 ; k < count ; ++k)
         {
-            const auto x = (i * cosAngle) - bSinAngle;
-            const auto y = (i * sinAngle) + bCosAngle;
+            const auto x = (start + k - centre + 0.5) / filterScale;
+            kernel[k] = lanczosKernel(static_cast<float>(x), a);
+            total += kernel[k];
+        }
 
-            const auto x0 = static_cast<int>(floor(x));
-            const auto y0 = static_cast<int>(floor(y));
+        if (total == 0.0)
+        {
+            total = 1.0;
+        }
 
-            const auto x1 = static_cast<int>(ceil(x));
-            const auto y1 = static_cast<int>(ceil(y));
+        auto coefficients = weights.m_coefficients.begin() + (i * weights.m_taps);
 
-            const auto pixel00 = image.getPixel(Point{x0, id.height() - 1 - y0});
-            const auto pixel01 = image.getPixel(Point{x0, id.height() - 1 - y1});
-            const auto pixel10 = image.getPixel(Point{x1, id.height() - 1 - y0});
-            const auto pixel11 = image.getPixel(Point{x1, id.height() - 1 - y1});
+        for (int k = 0 ; k < count ; ++k)
+        {
+            coefficients[k] = static_cast<int32_t>(
+                std::lround((kernel[k] / total) * (1 << c_resizePrecisionBits)));
+        }
 
-            if (pixel00.has_value() and
-                pixel01.has_value() and
-                pixel10.has_value() and
-                pixel11.has_value())
-            {
-                const auto xWeight = x - x0;
-                const auto yWeight = y - y0;
+        weights.m_start[i] = start;
+        weights.m_count[i] = count;
+    }
 
-                const auto aWeight = (1.0 - xWeight) * (1.0 - yWeight);
-                const auto bWeight = (1.0 - xWeight) * yWeight;
-                const auto cWeight = xWeight * (1.0 - yWeight);
-                const auto dWeight = xWeight * yWeight;
+    return weights;
+}
 
-                auto evaluate = [&](const uint8_t fb32::RGB8::* channel) -> uint8_t
-                {
-                    double value = fb32::RGB8(pixel00.value()).*channel * aWeight
-                                 + fb32::RGB8(pixel01.value()).*channel * bWeight
-                                 + fb32::RGB8(pixel10.value()).*channel * cWeight
-                                 + fb32::RGB8(pixel11.value()).*channel * dWeight;
+//-------------------------------------------------------------------------
 
-                    return static_cast<uint8_t>(std::clamp(value, 0.0, 255.0));
-                };
+fb32::ResizePlan::Samples
+fb32::ResizePlan::nearestNeighbourSamples(
+    int inputSize,
+    int outputSize)
+{
+    const int a = (outputSize > inputSize) ? 0 : 1;
+    const int divisor = std::max(outputSize - a, 1);
 
-                fb32::RGB8880 rgb{evaluate(&fb32::RGB8::red),
-                                  evaluate(&fb32::RGB8::green),
-                                  evaluate(&fb32::RGB8::blue)};
+    Samples samples;
+    samples.m_low.resize(outputSize);
 
-                output.setPixel(Point{i, j}, rgb.get8880());
-            }
-        }
+    for (int i = 0 ; i < outputSize ; ++i)
+    {
+        samples.m_low[i] = (i * (inputSize - a)) / divisor;
     }
+
+    return samples;
 }
 
 //-------------------------------------------------------------------------
 
 void
-rowsToGrey(
-    const fb32::Interface8880Base& input,
-    fb32::Image8880& output,
+fb32::ResizePlan::resizeBilinear(
+    const Interface8880Base& input,
+    Image8880& output,
     int jStart,
-    int jEnd)
+    int jEnd) const
 {
-    const auto id = input.getDimensions();
-    auto inputi = input.getBuffer().data() + (jStart * id.width());
-
     for (auto j = jStart ; j < jEnd ; ++j)
     {
-        for (int i = 0 ; i < id.width() ; ++i)
+        const auto* rowLow = input.getRow(m_rows.m_low[j]).data();
+        const auto* rowHigh = input.getRow(m_rows.m_high[j]).data();
+        const auto yFraction = m_rows.m_fraction[j];
+        auto* row = output.getRow(j).data();
+
+        for (auto i = 0 ; i < m_output.width() ; ++i)
         {
-            auto pixel = *(inputi++);
-            const Point p{i, j};
+            const auto xLow = m_columns.m_low[i];
+            const auto xHigh = m_columns.m_high[i];
+            const auto xFraction = m_columns.m_fraction[i];
 
-            output.setPixel(p, fb32::RGB8880(pixel).toGrey().get8880());
+            ResizeAccumulator<> accumulator;
+            accumulator.add(rowLow[xLow], (c_bilinearOne - xFraction) * (c_bilinearOne - yFraction));
+            accumulator.add(rowLow[xHigh], xFraction * (c_bilinearOne - yFraction));
+            accumulator.add(rowHigh[xLow], (c_bilinearOne - xFraction) * yFraction);
+            accumulator.add(rowHigh[xHigh], xFraction * yFraction);
+
+            row[i] = accumulator.get8880();
         }
     }
 }
@@ -733,26 +1263,31 @@ rowsToGrey(
 //-------------------------------------------------------------------------
 
 void
-rowsToGreen(
-    const fb32::Interface8880Base& input,
-    fb32::Image8880& output,
+fb32::ResizePlan::resizeHorizontal(
+    const Interface8880Base& input,
     int jStart,
     int jEnd)
 {
-    const auto id = input.getDimensions();
-    auto inputi = input.getBuffer().data() + (jStart * id.width());
+    const auto& w = m_horizontal;
 
     for (auto j = jStart ; j < jEnd ; ++j)
     {
-        for (int i = 0 ; i < id.width() ; ++i)
+        const auto* row = input.getRow(j).data();
+        auto* output = m_intermediate.data() +
+                       (static_cast<std::size_t>(j) * m_output.width() * c_intermediateChannels);
+
+        for (auto i = 0 ; i < m_output.width() ; ++i)
         {
-            auto pixel = *(inputi++);
-            const Point p{i, j};
-            const fb32::RGB8880 rgb{pixel};
-            const auto intensity = rgb.toIntensity();
-            const fb32::RGB8880 green{0, intensity, 0};
+            const auto* pixel = row + w.m_start[i];
+            const auto* coefficient = w.m_coefficients.data() + (i * w.m_taps);
+            ResizeAccumulator<c_resizePrecisionBits - c_intermediateFractionBits> accumulator;
 
-            output.setPixel(p, green.get8880());
+            for (auto k = 0 ; k < w.m_count[i] ; ++k)
+            {
+                accumulator.add(pixel[k], coefficient[k]);
+            }
+
+            accumulator.getChannels(output + (i * c_intermediateChannels));
         }
     }
 }
@@ -760,62 +1295,67 @@ rowsToGreen(
 //-------------------------------------------------------------------------
 
 void
-CountIntensity::count(
-    const fb32::Interface8880Base& input)
+fb32::ResizePlan::resizeNearestNeighbour(
+    const Interface8880Base& input,
+    Image8880& output,
+    int jStart,
+    int jEnd) const
 {
-    const auto d = input.getDimensions();
-
-#ifdef WITH_BS_THREAD_POOL
-    std::mutex countMutex;
-    auto& tPool = threadPool();
-    auto iterateRows = [this, &input, &countMutex](int start, int end)
+    for (auto j = jStart ; j < jEnd ; ++j)
     {
-        CountIntensity localCount;
-        rowsCountIntensity(input, localCount, start, end);
-        std::lock_guard<std::mutex> lock(countMutex);
-        add(localCount);
-    };
+        auto outputRow = output.getRow(j);
 
-    tPool.detach_blocks<int>(0, d.height(), iterateRows);
-    tPool.wait();
-#else
-    CountIntensity localCount;
-    rowsCountIntensity(input, localCount, 0, d.height());
-    add(localCount);
-#endif
+        // when enlarging, consecutive output rows often share a source row
+
+        if ((j > jStart) and (m_rows.m_low[j] == m_rows.m_low[j - 1]))
+        {
+            const auto previous = output.getRow(j - 1);
+            std::copy(previous.begin(), previous.end(), outputRow.begin());
+            continue;
+        }
+
+        const auto* row = input.getRow(m_rows.m_low[j]).data();
+
+        for (auto i = 0 ; i < m_output.width() ; ++i)
+        {
+            outputRow[i] = row[m_columns.m_low[i]];
+        }
+    }
 }
 
 //-------------------------------------------------------------------------
 
 void
-CountRGB::count(
-    const fb32::Interface8880Base& input)
+fb32::ResizePlan::resizeVertical(
+    Image8880& output,
+    int jStart,
+    int jEnd) const
 {
-    const auto d = input.getDimensions();
+    const auto& w = m_vertical;
+    const auto width = m_output.width();
+    const auto stride = static_cast<std::size_t>(width) * c_intermediateChannels;
 
-#ifdef WITH_BS_THREAD_POOL
-    std::mutex countMutex;
-    auto& tPool = threadPool();
-    auto iterateRows = [this, &input, &countMutex](int start, int end)
+    for (auto j = jStart ; j < jEnd ; ++j)
     {
-        CountRGB localCount;
-        rowsCountRGB(input, localCount, start, end);
-        std::lock_guard<std::mutex> lock(countMutex);
-        add(localCount);
-    };
+        const auto* column = m_intermediate.data() + (w.m_start[j] * stride);
+        const auto* coefficient = w.m_coefficients.data() + (j * w.m_taps);
+        auto* row = output.getRow(j).data();
 
-    tPool.detach_blocks<int>(0, d.height(), iterateRows);
-    tPool.wait();
-#else
-    CountRGB localCount;
-    rowsCountRGB(input, localCount, 0, d.height());
-    add(localCount);
-#endif
-}
+        for (auto i = 0 ; i < width ; ++i)
+        {
+            const auto* pixel = column + (i * c_intermediateChannels);
+            ResizeAccumulator<c_resizePrecisionBits + c_intermediateFractionBits> accumulator;
 
-//-------------------------------------------------------------------------
+            for (auto k = 0 ; k < w.m_count[j] ; ++k)
+            {
+                accumulator.add(pixel, coefficient[k]);
+                pixel += stride;
+            }
 
-};
+            row[i] = accumulator.get8880();
+        }
+    }
+}
 
 //=========================================================================
 
@@ -828,32 +1368,27 @@ fb32::boxBlur(
     Image8880 rb{d};
     Image8880 output{d};
 
-#ifdef WITH_BS_THREAD_POOL
-
-    auto& tPool = threadPool();
-
-    auto iterateRows = [&input, &rb, radius](int start, int end)
+    if ((d.width() == 0) or (d.height() == 0))
     {
-        boxBlurRows(input, rb, radius, start, end);
-    };
+        return output;
+    }
 
-    tPool.detach_blocks<int>(0, d.height(), iterateRows);
-    tPool.wait();
+    const BoxBlurDivide bbd{2 * radius + 1};
 
-    auto iterateColumns = [&rb, &output, radius](int start, int end)
+    if (bbd.exact())
     {
-        boxBlurColumns(rb, output, radius, start, end);
-    };
-
-    tPool.detach_blocks<int>(0, d.width(), iterateColumns);
-    tPool.wait();
-
-#else
-
-    boxBlurRows(input, rb, radius, 0, d.height());
-    boxBlurColumns(rb, output, radius, 0, d.width());
-
-#endif
+        boxBlurPasses(input, rb, output, radius, [bbd](uint32_t sum)
+        {
+            return bbd.multiply(sum);
+        });
+    }
+    else
+    {
+        boxBlurPasses(input, rb, output, radius, [bbd](uint32_t sum)
+        {
+            return bbd.divide(sum);
+        });
+    }
 
     return output;
 }
@@ -866,32 +1401,28 @@ fb32::enlighten(
     double strength)
 {
     const auto d = input.getDimensions();
-    auto flerp = [](double value1, double value2, double alpha)->double
+    Image8880 output{d};
+
+    if ((d.width() == 0) or (d.height() == 0))
     {
-        return (value1 * (1.0 - alpha)) + (value2 * alpha);
-    };
+        return output;
+    }
 
-    auto scaled = [](uint8_t channel, double scale)->uint8_t
+    auto flerp = [](double value1, double value2, double alpha)->double
     {
-        return static_cast<uint8_t>(std::clamp(channel * scale, 0.0, 255.0));
+        return (value1 * (1.0 - alpha)) + (value2 * alpha);
     };
 
-    const auto mb = boxBlur(maxRGB(input), 12);
-
-    Image8880 output{d};
-
     const auto strength2 = strength * strength;
     const auto minI = 1.0 / flerp(1.0, 10.0, strength2);
     const auto maxI = 1.0 / flerp(1.0, 1.111, strength2);
 
-    auto mbi = mb.getBuffer().data();
-    auto outputi = output.getBuffer().data();
+    // The scale for each blurred maximum channel value, in fixed point.
+
+    EnlightenTable table;
 
-    for (auto pixel : input.getBuffer())
+    for (int max = 0 ; max < 256 ; ++max)
     {
-        RGB8880 c{pixel};
-        const auto rgb8 = c.getRGB8();
-        const auto max = RGB8(*(mbi++)).red;
         const auto illumination = std::clamp(max / 255.0, minI, maxI);
 
         if (illumination < maxI)
@@ -899,12 +1430,30 @@ fb32::enlighten(
             const auto r = illumination / maxI;
             const auto scale = (0.4 + (r * 0.6)) / r;
 
-            c.setRGB(scaled(rgb8.red, scale),
-                     scaled(rgb8.green, scale),
-                     scaled(rgb8.blue, scale));
+            table[max] = static_cast<uint32_t>(scale * c_enlightenOne);
         }
+        else
+        {
+            table[max] = c_enlightenOne;
+        }
+    }
 
-        *(outputi++) = c.get8880();
+    constexpr int radius{12};
+    const BoxBlurDivide bbd{2 * radius + 1};
+
+    if (bbd.exact())
+    {
+        enlightenPasses(input, output, table, radius, [bbd](uint32_t sum)
+        {
+            return bbd.multiply(sum);
+        });
+    }
+    else
+    {
+        enlightenPasses(input, output, table, radius, [bbd](uint32_t sum)
+        {
+            return bbd.divide(sum);
+        });
     }
 
     return output;
@@ -912,6 +1461,18 @@ fb32::enlighten(
 
 //-------------------------------------------------------------------------
 
+std::size_t
+fb32::getThreadCount() noexcept
+{
+#ifdef WITH_BS_THREAD_POOL
+    return threadPool().get_thread_count();
+#else
+    return 1;
+#endif
+}
+
+//-------------------------------------------------------------------------
+
 fb32::Image8880
 fb32::histogramIntensity(
     const Interface8880Base& input)
@@ -995,8 +1556,7 @@ fb32::histogramStretch(
         rowsHistogramStretch(low, high, input, output, start, end);
     };
 
-    tPool.detach_blocks<int>(0, d.height(), iterateRows);
-    tPool.wait();
+    tPool.submit_blocks<int>(0, d.height(), iterateRows).wait();
 #else
     rowsHistogramStretch(low, high, input, output, 0, d.height());
 #endif
@@ -1085,20 +1645,11 @@ fb32::resizeToBilinearInterpolation(
     const fb32::Interface8880Base& input,
     fb32::Image8880& output)
 {
-    const auto od = output.getDimensions();
-#ifdef WITH_BS_THREAD_POOL
-    auto& tPool = threadPool();
-    auto iterateRows = [&input, &output](int start, int end)
-    {
-        rowsBilinearInterpolation(input, output, start, end);
-    };
+    ResizePlan plan{input.getDimensions(),
+                    output.getDimensions(),
+                    ResizePlan::Filter::BILINEAR};
 
-    tPool.detach_blocks<int>(0, od.height(), iterateRows);
-    tPool.wait();
-#else
-    rowsBilinearInterpolation(input, output, 0, od.height());
-#endif
-    return output;
+    return plan.resize(input, output);
 }
 
 //-------------------------------------------------------------------------
@@ -1108,20 +1659,11 @@ fb32::resizeToLanczos3Interpolation(
     const fb32::Interface8880Base& input,
     fb32::Image8880& output)
 {
-    const auto od = output.getDimensions();
-#ifdef WITH_BS_THREAD_POOL
-    auto& tPool = threadPool();
-    auto iterateRows = [&input, &output](int start, int end)
-    {
-        rowsLanczos3Interpolation(input, output, start, end);
-    };
+    ResizePlan plan{input.getDimensions(),
+                    output.getDimensions(),
+                    ResizePlan::Filter::LANCZOS3};
 
-    tPool.detach_blocks<int>(0, od.height(), iterateRows);
-    tPool.wait();
-#else
-    rowsLanczos3Interpolation(input, output, 0, od.height());
-#endif
-    return output;
+    return plan.resize(input, output);
 }
 
 //-------------------------------------------------------------------------
@@ -1131,21 +1673,11 @@ fb32::resizeToNearestNeighbour(
     const fb32::Interface8880Base& input,
     fb32::Image8880& output)
 {
-    const auto od = output.getDimensions();
-#ifdef WITH_BS_THREAD_POOL
-    auto& tPool = threadPool();
-    auto iterateRows = [&input, &output](int start, int end)
-    {
-        rowsNearestNeighbour(input, output, start, end);
-    };
-
-    tPool.detach_blocks<int>(0, od.height(), iterateRows);
-    tPool.wait();
-#else
-    rowsNearestNeighbour(input, output, 0, od.height());
-#endif
+    ResizePlan plan{input.getDimensions(),
+                    output.getDimensions(),
+                    ResizePlan::Filter::NEAREST_NEIGHBOUR};
 
-    return output;
+    return plan.resize(input, output);
 }
 
 //-------------------------------------------------------------------------
@@ -1165,34 +1697,39 @@ fb32::rotate(
         angle = 360.0 + fmod(angle, 360.0);
     }
 
-    // rotate so angle is in the range 0 to 90
+    // split into a number of quarter turns and an angle of 0 to 90
 
-    Image8880 image;
+    int quarters = static_cast<int>(angle / 90.0);
+    angle -= quarters * 90.0;
 
-    if (angle >= 270.0)
-    {
-        image = rotate270(input);
-        angle -= 270.0;
-    }
-    else if (angle >= 180.0)
-    {
-        image = rotate180(input);
-        angle -= 180.0;
-    }
-    else if (angle >= 90.0)
-    {
-        image = rotate90(input);
-        angle -= 90.0;
-    }
-    else
+    if (angle > 89.99)
     {
-        image = input;
+        angle = 0.0;
+        ++quarters;
     }
 
-    // now angle is in the range 0 to 90
-    if (std::min(angle, 90.0 - angle) < 0.01)
+    quarters %= 4;
+
+    if (angle < 0.01)
     {
-        return image;
+        switch (quarters)
+        {
+        case 1:
+
+            return rotate90(input);
+
+        case 2:
+
+            return rotate180(input);
+
+        case 3:
+
+            return rotate270(input);
+
+        default:
+
+            return Image8880{input};
+        }
     }
 
     //---------------------------------------------------------------------
@@ -1209,36 +1746,73 @@ fb32::rotate(
     // x = x' * cos(angle) - y' * sin(angle)
     // y = x' * sin(angle) + y' * cos(angle)
     //
+    // The output pixel (i, j) is first mapped into the input turned by
+    // the quarter turns (u, v), and from there into the input itself, so
+    // that no turned copy of the input is made.
+    //
     //---------------------------------------------------------------------
 
     const auto radians = angle * (std::numbers::pi_v<double> / 180.0);
     const auto cosAngle = std::cos(radians);
     const auto sinAngle = std::sin(radians);
 
-    const auto id = image.getDimensions();
+    const auto id = input.getDimensions();
+    const auto w = static_cast<double>(id.width());
+    const auto h = static_cast<double>(id.height());
+
+    // dimensions of the input after the quarter turns
 
-    const auto x10 = (id.width() * cosAngle) + (id.height() * sinAngle);
-    const auto y00 = id.height() * cosAngle;
-    const auto y11 = -(id.width() * sinAngle);
+    const bool sideways = (quarters % 2) == 1;
+    const auto qw = sideways ? h : w;
+    const auto qh = sideways ? w : h;
+
+    const auto x10 = (qw * cosAngle) + (qh * sinAngle);
+    const auto y00 = qh * cosAngle;
+    const auto y11 = -(qw * sinAngle);
 
     const Dimensions8880 od{ static_cast<int>(std::ceil(x10)),
                              static_cast<int>(std::ceil(y00 - y11 + 1.0))};
 
-    Image8880 output{od};
-    output.clear(background);
+    // u = i * cos + j * sin - y00 * sin
+    // v = -i * sin + j * cos + (qh - 1 - y00 * cos)
 
-#ifdef WITH_BS_THREAD_POOL
-    auto& tPool = threadPool();
-    auto iterateRows = [&image, &output, sinAngle, cosAngle](int start, int end)
+    const RotateMapping uv{cosAngle,
+                           sinAngle,
+                           -y00 * sinAngle,
+                           -sinAngle,
+                           cosAngle,
+                           qh - 1.0 - (y00 * cosAngle)};
+
+    RotateMapping m{uv};
+
+    switch (quarters)
     {
-        rowsRotate(image, output, sinAngle, cosAngle, start, end);
-    };
+    case 1: // x = v, y = h - 1 - u
 
-    tPool.detach_blocks<int>(0, od.height(), iterateRows);
-    tPool.wait();
-#else
-    rowsRotate(image, output, sinAngle, cosAngle, 0, od.height());
-#endif
+        m = {uv.d, uv.e, uv.f, -uv.a, -uv.b, h - 1.0 - uv.c};
+        break;
+
+    case 2: // x = w - 1 - u, y = h - 1 - v
+
+        m = {-uv.a, -uv.b, w - 1.0 - uv.c, -uv.d, -uv.e, h - 1.0 - uv.f};
+        break;
+
+    case 3: // x = w - 1 - v, y = u
+
+        m = {-uv.d, -uv.e, w - 1.0 - uv.f, uv.a, uv.b, uv.c};
+        break;
+
+    default:
+
+        break;
+    }
+
+    Image8880 output{od};
+
+    iterateRows(0, od.height(), [&input, &output, background, &m](int start, int end)
+    {
+        rowsRotate(input, output, background, m, start, end);
+    });
 
     return output;
 }
@@ -1344,8 +1918,7 @@ fb32::scaleUp(
         rowsScaleUp(input, output, scale, start, end);
     };
 
-    tPool.detach_blocks<int>(0, id.height(), iterateRows);
-    tPool.wait();
+    tPool.submit_blocks<int>(0, id.height(), iterateRows).wait();
 #else
     rowsScaleUp(input, output, scale, 0, id.height());
 #endif
@@ -1355,6 +1928,41 @@ fb32::scaleUp(
 
 //-------------------------------------------------------------------------
 
+void
+fb32::setThreadCount(
+    [[maybe_unused]] std::size_t threads)
+{
+#ifdef WITH_BS_THREAD_POOL
+    auto& tPool = threadPool();
+    tPool.wait();
+
+    if (threads == 0)
+    {
+        tPool.reset();
+    }
+    else
+    {
+        tPool.reset(threads);
+    }
+#endif
+}
+
+//-------------------------------------------------------------------------
+
+#ifdef WITH_BS_THREAD_POOL
+
+BS::thread_pool&
+fb32::threadPool()
+{
+    static BS::thread_pool s_threadPool;
+
+    return s_threadPool;
+}
+
+#endif
+
+//-------------------------------------------------------------------------
+
 fb32::Image8880
 fb32::toGrey(
     const Interface8880Base& input)
@@ -1369,8 +1977,7 @@ fb32::toGrey(
         rowsToGrey(input, output, start, end);
     };
 
-    tPool.detach_blocks<int>(0, id.height(), iterateRows);
-    tPool.wait();
+    tPool.submit_blocks<int>(0, id.height(), iterateRows).wait();
 #else
     rowsToGrey(input, output, 0, id.height());
 #endif
@@ -1394,8 +2001,7 @@ fb32::toGreen(
         rowsToGreen(input, output, start, end);
     };
 
-    tPool.detach_blocks<int>(0, id.height(), iterateRows);
-    tPool.wait();
+    tPool.submit_blocks<int>(0, id.height(), iterateRows).wait();
 #else
     rowsToGreen(input, output, 0, id.height());
 #endif
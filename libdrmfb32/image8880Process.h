@@ -29,6 +29,10 @@
 
 //-------------------------------------------------------------------------
 
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
 #include "image8880.h"
 #include "interface8880Base.h"
 #include "rgb8880.h"
@@ -39,6 +43,105 @@
 namespace fb32
 {
 
+//-------------------------------------------------------------------------
+//
+// A ResizePlan holds the source coordinates and filter weights needed to
+// resize an image of one size to another. Building them is the expensive
+// part, so keep the plan and reuse it for images of the same size.
+//
+// NEAREST_NEIGHBOUR and BILINEAR keep a source index (and fraction) for
+// each output column and row. LANCZOS3 resizes horizontally and then
+// vertically, and when reducing the filter is widened so that every input
+// pixel contributes to the output. The result of the horizontal pass is
+// kept in fixed point, so it is only rounded and clamped once.
+//
+//-------------------------------------------------------------------------
+
+class ResizePlan
+{
+public:
+
+    enum class Filter
+    {
+        NEAREST_NEIGHBOUR,
+        BILINEAR,
+        LANCZOS3
+    };
+
+    ResizePlan(
+        Dimensions8880 input,
+        Dimensions8880 output,
+        Filter filter);
+
+    [[nodiscard]] Filter getFilter() const noexcept { return m_filter; }
+
+    [[nodiscard]] Dimensions8880 getInputDimensions() const noexcept { return m_input; }
+    [[nodiscard]] Dimensions8880 getOutputDimensions() const noexcept { return m_output; }
+
+    [[nodiscard]] bool
+    matches(
+        Dimensions8880 input,
+        Dimensions8880 output,
+        Filter filter) const noexcept
+    {
+        return (input == m_input) and
+               (output == m_output) and
+               (filter == m_filter);
+    }
+
+    Image8880& resize(const Interface8880Base& input, Image8880& output);
+
+private:
+
+    static constexpr int c_intermediateChannels{3};
+
+    struct Samples
+    {
+        std::vector<int> m_low{};
+        std::vector<int> m_high{};
+        std::vector<int32_t> m_fraction{};
+    };
+
+    struct Weights
+    {
+        int m_taps{};
+        std::vector<int> m_start{};
+        std::vector<int> m_count{};
+        std::vector<int32_t> m_coefficients{};
+    };
+
+    [[nodiscard]] static Samples bilinearSamples(int inputSize, int outputSize);
+    [[nodiscard]] static Weights lanczos3Weights(int inputSize, int outputSize);
+    [[nodiscard]] static Samples nearestNeighbourSamples(int inputSize, int outputSize);
+
+    void
+    resizeBilinear(
+        const Interface8880Base& input,
+        Image8880& output,
+        int jStart,
+        int jEnd) const;
+
+    void resizeHorizontal(const Interface8880Base& input, int jStart, int jEnd);
+
+    void
+    resizeNearestNeighbour(
+        const Interface8880Base& input,
+        Image8880& output,
+        int jStart,
+        int jEnd) const;
+
+    void resizeVertical(Image8880& output, int jStart, int jEnd) const;
+
+    Samples m_columns;
+    Filter m_filter;
+    Weights m_horizontal;
+    Dimensions8880 m_input;
+    std::vector<int16_t> m_intermediate;
+    Dimensions8880 m_output;
+    Samples m_rows;
+    Weights m_vertical;
+};
+
 //-------------------------------------------------------------------------
 
 [[nodiscard]] Image8880
@@ -51,6 +154,12 @@ enlighten(
     const Interface8880Base& input,
     double strength);
 
+// Number of threads used by the image processing functions. Without the
+// thread pool everything runs on the calling thread, so this is always 1.
+
+[[nodiscard]] std::size_t
+getThreadCount() noexcept;
+
 [[nodiscard]] Image8880
 histogramIntensity(
     const Interface8880Base& input);
@@ -144,6 +253,13 @@ scaleUp(
     const Interface8880Base& input,
     uint8_t scale);
 
+// Restart the thread pool with the given number of threads (0 uses the
+// hardware concurrency). Does nothing without the thread pool.
+
+void
+setThreadCount(
+    std::size_t threads);
+
 [[nodiscard]] Image8880
 toGrey(
     const Interface8880Base& input);
@@ -27,14 +27,16 @@
 //-------------------------------------------------------------------------
 
 #include "image8880Qoi.h"
+#include "mappedFile.h"
+#include "threadPool.h"
 
 //-------------------------------------------------------------------------
 
 #include <algorithm>
 #include <array>
 #include <cstdint>
-#include <filesystem>
 #include <fstream>
+#include <span>
 #include <stdexcept>
 #include <vector>
 
@@ -60,13 +62,22 @@ constexpr uint8_t QOI_MASKED_OP_DIFF{0x40};
 constexpr uint8_t QOI_MASKED_OP_LUMA{0x80};
 constexpr uint8_t QOI_MASKED_OP_RUN{0xC0};
 
+constexpr int QOI_MAX_RUN{62};
+
+// as in the reference decoder, which keeps the image size well inside an int
+
+constexpr uint32_t QOI_PIXELS_MAX{400'000'000};
+
+constexpr uint32_t QOIS_MAGIC{('q' << 24) | ('o' << 16) | ('i' << 8) | 's'};
+constexpr std::size_t QOIS_HEADER_SIZE{20};
+
 //-------------------------------------------------------------------------
 
 class QoiHeader
 {
 public:
 
-    explicit QoiHeader(const std::array<uint8_t, QOI_HEADER_SIZE>& data);
+    explicit QoiHeader(std::span<const uint8_t, QOI_HEADER_SIZE> data);
 
     uint32_t getWidth() const noexcept { return m_width; }
     uint32_t getHeight() const noexcept { return m_height; }
@@ -84,7 +95,7 @@ private:
 //-------------------------------------------------------------------------
 
 QoiHeader::QoiHeader(
-    const std::array<uint8_t, QOI_HEADER_SIZE>& data)
+    std::span<const uint8_t, QOI_HEADER_SIZE> data)
 :
     m_width{0},
     m_height{0},
@@ -118,6 +129,11 @@ QoiHeader::QoiHeader(
         throw std::invalid_argument("QOI width or height is zero");
     }
 
+    if (m_height > (QOI_PIXELS_MAX / m_width))
+    {
+        throw std::invalid_argument("QOI image too large");
+    }
+
     m_channels = data[12];
 
     if ((m_channels < 3) or (m_channels > 4))
@@ -137,13 +153,13 @@ QoiHeader::QoiHeader(
 
 void
 checkFooter(
-    const std::array<uint8_t, QOI_FOOTER_SIZE>& data)
+    std::span<const uint8_t, QOI_FOOTER_SIZE> data)
 {
     const std::array<uint8_t, QOI_FOOTER_SIZE> expected{
         0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01
     };
 
-    if (data != expected)
+    if (not std::ranges::equal(data, expected))
     {
         throw std::invalid_argument("QOI bad footer value");
     }
@@ -157,6 +173,8 @@ struct QoiRGBA
     uint8_t g{};
     uint8_t b{};
     uint8_t a{};
+
+    friend bool operator==(const QoiRGBA& lhs, const QoiRGBA& rhs) = default;
 };
 
 //-------------------------------------------------------------------------
@@ -170,118 +188,504 @@ rgbaHashQoi(
 
 //-------------------------------------------------------------------------
 
-fb32::Image8880
+// Pixels are written in order straight into pixels, and runs are filled
+// in one go. The footer is included in data, so the bytes of an op that
+// starts before the footer can be read without checking.
+
+void
 decodeQoi(
     const QoiHeader& header,
-    const std::vector<uint8_t>& data,
-    const fb32::RGB8880& background)
+    std::span<const uint8_t> data,
+    const fb32::RGB8880& background,
+    std::span<uint32_t> pixels) noexcept
 {
-    const fb32::Dimensions8880 id
+    const bool opaque{header.getChannels() == 3};
+
+    QoiRGBA currentRGBA{ .r = 0, .g = 0, .b = 0, .a = 255 };
+    uint32_t current{};
+
+    auto toPixel = [opaque, &background](const QoiRGBA& rgba) -> uint32_t
     {
-        static_cast<int>(header.getWidth()),
-        static_cast<int>(header.getHeight())
-    };
+        const fb32::RGB8880 rgb{rgba.r, rgba.g, rgba.b};
 
-    fb32::Image8880 image(id);
+        if (opaque or (rgba.a == 255))
+        {
+            return rgb.get8880();
+        }
 
-    QoiRGBA currentRGBA{ .r = 0, .g = 0, .b = 0, .a = 255 };
+        return rgb.blend(rgba.a, background).get8880();
+    };
+
+    std::array<QoiRGBA, 64> hashTableRGBA{};
 
-    std::array<QoiRGBA, 64> hashTableRGBA;
+    auto out{pixels.begin()};
+    const auto outEnd{pixels.end()};
 
-    const auto pixels{header.getWidth() * header.getHeight()};
-    auto d{cbegin(data)};
-    int run{};
+    auto d{data.begin()};
+    const auto dEnd{data.end() - QOI_FOOTER_SIZE};
 
-    for (auto i = 0U ; (i < pixels) and (d != cend(data)) ; ++i)
+    while ((out != outEnd) and (d < dEnd))
     {
-        if (run)
+        const auto value = *d++;
+
+        if (value == QOI_OP_RGB)
+        {
+            currentRGBA.r = d[0];
+            currentRGBA.g = d[1];
+            currentRGBA.b = d[2];
+            d += 3;
+        }
+        else if (value == QOI_OP_RGBA)
         {
-            --run;
+            currentRGBA.r = d[0];
+            currentRGBA.g = d[1];
+            currentRGBA.b = d[2];
+            currentRGBA.a = d[3];
+            d += 4;
         }
         else
         {
-            const auto value = *d++;
-
-            if (value == QOI_OP_RGB)
+            switch (value & QOI_MASK_OP)
             {
-                currentRGBA.r = *d++;
-                currentRGBA.g = *d++;
-                currentRGBA.b = *d++;
+                case QOI_MASKED_OP_INDEX:
+
+                    currentRGBA = hashTableRGBA[value];
+                    current = toPixel(currentRGBA);
+                    *out++ = current;
+
+                    continue;
+
+                case QOI_MASKED_OP_DIFF:
+
+                    currentRGBA.r += ((value >> 4) & 0x03) - 2;
+                    currentRGBA.g += ((value >> 2) & 0x03) - 2;
+                    currentRGBA.b += (value & 0x03) - 2;
+
+                    break;
+
+                case QOI_MASKED_OP_LUMA:
+                {
+                    const auto diffs{*d++};
+                    const auto dg{(value & 0x3f) - 32};
+                    const auto dr_dg{(diffs >> 4) & 0x0F};
+                    const auto db_dg{diffs & 0x0F};
 
-                hashTableRGBA[rgbaHashQoi(currentRGBA)] = currentRGBA;
+                    currentRGBA.r += dg - 8 + dr_dg;
+                    currentRGBA.g += dg;
+                    currentRGBA.b += dg - 8 + db_dg;
+
+                    break;
+                }
+                case QOI_MASKED_OP_RUN:
+                {
+                    const auto run = std::min<std::ptrdiff_t>((value & QOI_UNMASK) + 1,
+                                                              outEnd - out);
+                    out = std::fill_n(out, run, current);
+
+                    continue;
+                }
             }
-            else if (value == QOI_OP_RGBA)
+        }
+
+        hashTableRGBA[rgbaHashQoi(currentRGBA)] = currentRGBA;
+        current = toPixel(currentRGBA);
+        *out++ = current;
+    }
+}
+
+//-------------------------------------------------------------------------
+
+void
+appendBigEndian(
+    std::vector<uint8_t>& data,
+    uint32_t value)
+{
+    data.push_back((value >> 24) & 0xFF);
+    data.push_back((value >> 16) & 0xFF);
+    data.push_back((value >> 8) & 0xFF);
+    data.push_back(value & 0xFF);
+}
+
+//-------------------------------------------------------------------------
+
+uint32_t
+readBigEndian(
+    std::span<const uint8_t> data,
+    std::size_t offset)
+{
+    return (data[offset] << 24) |
+           (data[offset + 1] << 16) |
+           (data[offset + 2] << 8) |
+           data[offset + 3];
+}
+
+//-------------------------------------------------------------------------
+
+template<typename Stripes>
+void
+iterateStripes(
+    int stripes,
+    Stripes function)
+{
+#ifdef WITH_BS_THREAD_POOL
+    auto& tPool = fb32::threadPool();
+    tPool.submit_blocks<int>(0, stripes, function, stripes).wait();
+#else
+    function(0, stripes);
+#endif
+}
+
+//-------------------------------------------------------------------------
+
+// Encodes an image a row at a time, appending to data. Rows can be taken
+// out of data as it grows, so an image can be written out without ever
+// holding all of it.
+
+class QoiEncoder
+{
+public:
+
+    QoiEncoder(
+        std::vector<uint8_t>& data,
+        fb32::Dimensions8880 d);
+
+    void encodeRow(std::span<const uint32_t> row);
+    void finish();
+
+private:
+
+    std::vector<uint8_t>& m_data;
+    std::array<QoiRGBA, 64> m_hashTableRGBA;
+    QoiRGBA m_previous;
+    int m_run;
+};
+
+//-------------------------------------------------------------------------
+
+QoiEncoder::QoiEncoder(
+    std::vector<uint8_t>& data,
+    fb32::Dimensions8880 d)
+:
+    m_data{data},
+    m_hashTableRGBA{},
+    m_previous{ .r = 0, .g = 0, .b = 0, .a = 255 },
+    m_run{0}
+{
+    appendBigEndian(m_data, QOI_MAGIC);
+    appendBigEndian(m_data, d.width());
+    appendBigEndian(m_data, d.height());
+    m_data.push_back(3);
+    m_data.push_back(0);
+}
+
+//-------------------------------------------------------------------------
+
+void
+QoiEncoder::encodeRow(
+    std::span<const uint32_t> row)
+{
+    for (const auto pixel : row)
+    {
+        const QoiRGBA current{
+            .r = fb32::getRed(pixel),
+            .g = fb32::getGreen(pixel),
+            .b = fb32::getBlue(pixel),
+            .a = 255
+        };
+
+        if (current == m_previous)
+        {
+            if (++m_run == QOI_MAX_RUN)
             {
-                currentRGBA.r = *d++;
-                currentRGBA.g = *d++;
-                currentRGBA.b = *d++;
-                currentRGBA.a = *d++;
+                m_data.push_back(QOI_MASKED_OP_RUN | (m_run - 1));
+                m_run = 0;
+            }
+
+            continue;
+        }
+
+        if (m_run)
+        {
+            m_data.push_back(QOI_MASKED_OP_RUN | (m_run - 1));
+            m_run = 0;
+        }
+
+        const auto hash = rgbaHashQoi(current);
+
+        if (m_hashTableRGBA[hash] == current)
+        {
+            m_data.push_back(QOI_MASKED_OP_INDEX | hash);
+        }
+        else
+        {
+            m_hashTableRGBA[hash] = current;
+
+            const int8_t dr = current.r - m_previous.r;
+            const int8_t dg = current.g - m_previous.g;
+            const int8_t db = current.b - m_previous.b;
+            const int dr_dg = dr - dg;
+            const int db_dg = db - dg;
 
-                hashTableRGBA[rgbaHashQoi(currentRGBA)] = currentRGBA;
+            if ((dr >= -2) and (dr <= 1) and
+                (dg >= -2) and (dg <= 1) and
+                (db >= -2) and (db <= 1))
+            {
+                m_data.push_back(QOI_MASKED_OP_DIFF |
+                                 ((dr + 2) << 4) |
+                                 ((dg + 2) << 2) |
+                                 (db + 2));
+            }
+            else if ((dg >= -32) and (dg <= 31) and
+                     (dr_dg >= -8) and (dr_dg <= 7) and
+                     (db_dg >= -8) and (db_dg <= 7))
+            {
+                m_data.push_back(QOI_MASKED_OP_LUMA | (dg + 32));
+                m_data.push_back(((dr_dg + 8) << 4) | (db_dg + 8));
             }
             else
             {
-                switch (value & QOI_MASK_OP)
-                {
-                    case QOI_MASKED_OP_INDEX:
+                m_data.push_back(QOI_OP_RGB);
+                m_data.push_back(current.r);
+                m_data.push_back(current.g);
+                m_data.push_back(current.b);
+            }
+        }
+
+        m_previous = current;
+    }
+}
+
+//-------------------------------------------------------------------------
 
-                        currentRGBA = hashTableRGBA[value];
+void
+QoiEncoder::finish()
+{
+    if (m_run)
+    {
+        m_data.push_back(QOI_MASKED_OP_RUN | (m_run - 1));
+        m_run = 0;
+    }
 
-                        break;
+    m_data.insert(m_data.end(), QOI_FOOTER_SIZE - 1, 0x00);
+    m_data.push_back(0x01);
+}
+
+//-------------------------------------------------------------------------
 
-                    case QOI_MASKED_OP_DIFF:
+}
+
+//=========================================================================
+
+namespace fb32
+{
+
+//-------------------------------------------------------------------------
 
-                        currentRGBA.r += ((value >> 4) & 0x03) - 2;
-                        currentRGBA.g += ((value >> 2) & 0x03) - 2;
-                        currentRGBA.b += (value & 0x03) - 2;
+Image8880
+decodeQois(
+    std::span<const uint8_t> data,
+    const fb32::RGB8880& background)
+{
+    if ((data.size() < QOIS_HEADER_SIZE) or (readBigEndian(data, 0) != QOIS_MAGIC))
+    {
+        throw std::invalid_argument("QOIS bad magic value");
+    }
 
-                        hashTableRGBA[rgbaHashQoi(currentRGBA)] = currentRGBA;
+    const auto width = readBigEndian(data, 4);
+    const auto height = readBigEndian(data, 8);
+    const auto stripeHeight = readBigEndian(data, 12);
+    const auto stripes = readBigEndian(data, 16);
+
+    if ((width == 0) or
+        (height == 0) or
+        (height > (QOI_PIXELS_MAX / width)) or
+        (stripeHeight == 0) or
+        (stripes == 0) or
+        (stripes != ((height / stripeHeight) + ((height % stripeHeight) != 0))))
+    {
+        throw std::invalid_argument("QOIS bad dimensions");
+    }
 
-                        break;
+    // stripes <= height, so none of the table arithmetic can overflow
 
-                    case QOI_MASKED_OP_LUMA:
-                    {
-                        const auto diffs{*d++};
-                        const auto dg{(value & 0x3f) - 32};
-                        const auto dr_dg{(diffs >> 4) & 0x0F};
-                        const auto db_dg{diffs & 0x0F};
+    const std::size_t tableEnd{QOIS_HEADER_SIZE +
+                               ((std::size_t{stripes} + 1) * sizeof(uint32_t))};
 
-                        currentRGBA.r += dg - 8 + dr_dg;
-                        currentRGBA.g += dg;
-                        currentRGBA.b += dg - 8 + db_dg;
+    if (data.size() < tableEnd)
+    {
+        throw std::invalid_argument("QOIS data too short");
+    }
 
-                        hashTableRGBA[rgbaHashQoi(currentRGBA)] = currentRGBA;
+    // check every stripe before decoding any, as the decoding threads
+    // can't throw
 
-                        break;
-                    }
-                    case QOI_MASKED_OP_RUN:
+    std::vector<QoiHeader> headers;
+    std::vector<std::span<const uint8_t>> chunks;
+    headers.reserve(stripes);
+    chunks.reserve(stripes);
 
-                        run = value & QOI_UNMASK;
+    for (std::size_t stripe = 0 ; stripe < stripes ; ++stripe)
+    {
+        const std::size_t offset{readBigEndian(data, QOIS_HEADER_SIZE + (stripe * sizeof(uint32_t)))};
+        const std::size_t next{readBigEndian(data, QOIS_HEADER_SIZE + ((stripe + 1) * sizeof(uint32_t)))};
 
-                        break;
-                }
-            }
+        if ((offset < tableEnd) or
+            (next < offset + QOI_HEADER_SIZE + QOI_FOOTER_SIZE) or
+            (next > data.size()))
+        {
+            throw std::invalid_argument("QOIS bad stripe offset");
         }
 
-        const int x = i % header.getWidth();
-        const int y = i / header.getWidth();
-        const fb32::RGB8880 rgb{currentRGBA.r, currentRGBA.g, currentRGBA.b};
+        const auto stripeData = data.subspan(offset, next - offset);
+        const auto& header = headers.emplace_back(stripeData.first<QOI_HEADER_SIZE>());
+        checkFooter(stripeData.last<QOI_FOOTER_SIZE>());
+
+        const auto rows = std::min<std::size_t>(stripeHeight, height - (stripe * stripeHeight));
 
-        image.setPixelRGB(fb32::Point8880{x, y},
-                          rgb.blend(currentRGBA.a, background));
+        if ((header.getWidth() != width) or (header.getHeight() != rows))
+        {
+            throw std::invalid_argument("QOIS stripe does not match image");
+        }
+
+        chunks.push_back(stripeData.subspan(QOI_HEADER_SIZE));
     }
 
+    //---------------------------------------------------------------------
+
+    Image8880 image{Dimensions8880{static_cast<int>(width),
+                                   static_cast<int>(height)}};
+    auto buffer = image.getBuffer();
+
+    iterateStripes(stripes, [&](int start, int end)
+    {
+        for (auto stripe = start ; stripe < end ; ++stripe)
+        {
+            const auto& header = headers[stripe];
+            const auto first = static_cast<std::size_t>(stripe) * stripeHeight * width;
+
+            ::decodeQoi(header,
+                        chunks[stripe],
+                        background,
+                        buffer.subspan(first, header.getWidth() * header.getHeight()));
+        }
+    });
+
     return image;
 }
 
 //-------------------------------------------------------------------------
 
+std::vector<uint8_t>
+encodeQoi(
+    const Interface8880Base& image)
+{
+    const auto id = image.getDimensions();
+
+    std::vector<uint8_t> data;
+    data.reserve(QOI_HEADER_SIZE + (id.area() * 4) + QOI_FOOTER_SIZE);
+
+    QoiEncoder encoder{data, id};
+
+    for (int j = 0 ; j < id.height() ; ++j)
+    {
+        encoder.encodeRow(image.getRow(j));
+    }
+
+    encoder.finish();
+
+    return data;
 }
 
-//=========================================================================
+//-------------------------------------------------------------------------
 
-namespace fb32
+std::vector<uint8_t>
+encodeQois(
+    const Interface8880Base& image,
+    int stripeHeight)
 {
+    if (stripeHeight <= 0)
+    {
+        throw std::invalid_argument("QOIS stripe height must be greater than zero");
+    }
+
+    const auto id = image.getDimensions();
+    const auto stripes = (id.height() + stripeHeight - 1) / stripeHeight;
+
+    std::vector<std::vector<uint8_t>> encoded(stripes);
+
+    iterateStripes(stripes, [&](int start, int end)
+    {
+        for (auto stripe = start ; stripe < end ; ++stripe)
+        {
+            const auto jStart = stripe * stripeHeight;
+            const auto jEnd = std::min(id.height(), jStart + stripeHeight);
+
+            auto& data = encoded[stripe];
+            QoiEncoder encoder{data, Dimensions8880{id.width(), jEnd - jStart}};
+
+            for (auto j = jStart ; j < jEnd ; ++j)
+            {
+                encoder.encodeRow(image.getRow(j));
+            }
+
+            encoder.finish();
+        }
+    });
+
+    //---------------------------------------------------------------------
+
+    std::vector<uint8_t> data;
+
+    appendBigEndian(data, QOIS_MAGIC);
+    appendBigEndian(data, id.width());
+    appendBigEndian(data, id.height());
+    appendBigEndian(data, stripeHeight);
+    appendBigEndian(data, stripes);
+
+    auto offset = QOIS_HEADER_SIZE + ((stripes + 1) * sizeof(uint32_t));
+
+    for (const auto& stripe : encoded)
+    {
+        appendBigEndian(data, offset);
+        offset += stripe.size();
+    }
+
+    appendBigEndian(data, offset);
+    data.reserve(offset);
+
+    for (const auto& stripe : encoded)
+    {
+        data.insert(data.end(), stripe.begin(), stripe.end());
+    }
+
+    return data;
+}
+
+//-------------------------------------------------------------------------
+
+Image8880
+decodeQoi(
+    std::span<const uint8_t> data,
+    const fb32::RGB8880& background)
+{
+    if (data.size() < (QOI_HEADER_SIZE + QOI_FOOTER_SIZE))
+    {
+        throw std::invalid_argument("QOI data too short");
+    }
+
+    const QoiHeader header(data.first<QOI_HEADER_SIZE>());
+    checkFooter(data.last<QOI_FOOTER_SIZE>());
+
+    Image8880 image{Dimensions8880{static_cast<int>(header.getWidth()),
+                                   static_cast<int>(header.getHeight())}};
+
+    ::decodeQoi(header,
+                data.subspan(QOI_HEADER_SIZE),
+                background,
+                image.getBuffer());
+
+    return image;
+}
 
 //-------------------------------------------------------------------------
 
@@ -290,22 +694,91 @@ readQoi(
     const std::string& name,
     const fb32::RGB8880& background)
 {
-    const auto length{std::filesystem::file_size(std::filesystem::path(name))};
+    const MappedFile file{name};
+
+    return decodeQoi(file.getData(), background);
+}
+
+//-------------------------------------------------------------------------
+
+Image8880
+readQois(
+    const std::string& name,
+    const fb32::RGB8880& background)
+{
+    const MappedFile file{name};
+
+    return decodeQois(file.getData(), background);
+}
+
+//-------------------------------------------------------------------------
+
+void
+writeQoi(
+    const std::string& name,
+    const Interface8880Base& image)
+{
+    std::ofstream ofs{name, std::ios_base::binary};
+
+    if (not ofs)
+    {
+        throw std::invalid_argument("cannot open " + name + " for writing");
+    }
+
+    // write out the encoded rows whenever there are enough of them
+
+    constexpr std::size_t chunkSize{64 * 1024};
+
+    const auto id = image.getDimensions();
+
+    std::vector<uint8_t> data;
+    data.reserve(chunkSize + (id.width() * 5) + QOI_FOOTER_SIZE);
+
+    auto write = [&ofs, &data]
+    {
+        ofs.write(reinterpret_cast<const char*>(data.data()), data.size());
+        data.clear();
+    };
+
+    QoiEncoder encoder{data, id};
+
+    for (int j = 0 ; j < id.height() ; ++j)
+    {
+        encoder.encodeRow(image.getRow(j));
 
-    std::ifstream ifs{name, std::ios_base::binary};
+        if (data.size() >= chunkSize)
+        {
+            write();
+        }
+    }
+
+    encoder.finish();
+    write();
 
-    std::array<uint8_t, QOI_HEADER_SIZE> rawHeader{};
-    ifs.read(reinterpret_cast<char*>(rawHeader.data()), rawHeader.size());
-    const QoiHeader header(rawHeader);
+    if (not ofs)
+    {
+        throw std::invalid_argument("cannot write " + name);
+    }
+}
 
-    std::vector<uint8_t> buffer(length - QOI_HEADER_SIZE - QOI_FOOTER_SIZE);
-    ifs.read(reinterpret_cast<char*>(buffer.data()), buffer.size());
+//-------------------------------------------------------------------------
 
-    std::array<uint8_t, QOI_FOOTER_SIZE> rawFooter{};
-    ifs.read(reinterpret_cast<char*>(rawFooter.data()), rawFooter.size());
-    checkFooter(rawFooter);
+void
+writeQois(
+    const std::string& name,
+    const Interface8880Base& image,
+    int stripeHeight)
+{
+    const auto data = encodeQois(image, stripeHeight);
+
+    std::ofstream ofs{name, std::ios_base::binary};
+
+    if (not ofs)
+    {
+        throw std::invalid_argument("cannot open " + name + " for writing");
+    }
 
-    return decodeQoi(header, buffer, background);
+    ofs.write(reinterpret_cast<const char*>(data.data()), data.size());
 }
 
 //-------------------------------------------------------------------------
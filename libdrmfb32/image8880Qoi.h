@@ -30,8 +30,12 @@
 //-------------------------------------------------------------------------
 
 #include "image8880.h"
+#include "interface8880Base.h"
 
+#include <cstdint>
+#include <span>
 #include <string>
+#include <vector>
 
 //-------------------------------------------------------------------------
 
@@ -40,11 +44,62 @@ namespace fb32
 
 //-------------------------------------------------------------------------
 
+// Decode a whole QOI file held in memory. Transparent pixels are blended
+// with the background.
+
+[[nodiscard]] Image8880
+decodeQoi(
+    std::span<const uint8_t> data,
+    const fb32::RGB8880& background = fb32::RGB8880{0, 0, 0});
+
+[[nodiscard]] std::vector<uint8_t>
+encodeQoi(
+    const Interface8880Base& image);
+
 [[nodiscard]] Image8880
 readQoi(
     const std::string& name,
     const fb32::RGB8880& background = fb32::RGB8880{0, 0, 0});
 
+void
+writeQoi(
+    const std::string& name,
+    const Interface8880Base& image);
+
+//-------------------------------------------------------------------------
+//
+// QOIS holds an image as horizontal stripes, each one a complete QOI image
+// of stripe height rows (the last may be shorter), so that the stripes can
+// be encoded and decoded in parallel on the thread pool. It starts with
+// "qois" then the width, height, stripe height and number of stripes, and
+// a table of the offset of each stripe from the start of the data followed
+// by the total length. All values are big endian 32 bit.
+//
+//-------------------------------------------------------------------------
+
+constexpr int c_qoisStripeHeight{64};
+
+[[nodiscard]] Image8880
+decodeQois(
+    std::span<const uint8_t> data,
+    const fb32::RGB8880& background = fb32::RGB8880{0, 0, 0});
+
+[[nodiscard]] std::vector<uint8_t>
+encodeQois(
+    const Interface8880Base& image,
+    int stripeHeight = c_qoisStripeHeight);
+
+[[nodiscard]] Image8880
+readQois(
+    const std::string& name,
+    const fb32::RGB8880& background = fb32::RGB8880{0, 0, 0});
+
+void
+writeQois(
+    const std::string& name,
+    const Interface8880Base& image,
+    int stripeHeight = c_qoisStripeHeight);
+
 //-------------------------------------------------------------------------
 
 } // namespace fb32
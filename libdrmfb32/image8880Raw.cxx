@@ -0,0 +1,276 @@
+//-------------------------------------------------------------------------
+//
+// The MIT License (MIT)
+//
+// Copyright (c) 2022 Andrew Duncan
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+//-------------------------------------------------------------------------
+
+#include "image8880Raw.h"
+#include "mappedFile.h"
+
+//-------------------------------------------------------------------------
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+
+//-------------------------------------------------------------------------
+
+// XRGB8888 is little endian, which lets pixels be written and read
+// without converting them.
+
+static_assert(std::endian::native == std::endian::little,
+              "raw 8880 needs a little endian host");
+
+//=========================================================================
+
+namespace
+{
+
+//-------------------------------------------------------------------------
+
+constexpr std::array<uint8_t, 4> RAW8880_MAGIC{'8', '8', '8', '0'};
+constexpr uint32_t RAW8880_VERSION{1};
+
+//-------------------------------------------------------------------------
+
+uint32_t
+readLittleEndian(
+    std::span<const uint8_t> data,
+    std::size_t offset)
+{
+    return data[offset] |
+           (data[offset + 1] << 8) |
+           (data[offset + 2] << 16) |
+           (data[offset + 3] << 24);
+}
+
+//-------------------------------------------------------------------------
+
+void
+writeLittleEndian(
+    std::span<uint8_t> data,
+    std::size_t offset,
+    uint32_t value)
+{
+    data[offset] = value & 0xFF;
+    data[offset + 1] = (value >> 8) & 0xFF;
+    data[offset + 2] = (value >> 16) & 0xFF;
+    data[offset + 3] = (value >> 24) & 0xFF;
+}
+
+//-------------------------------------------------------------------------
+
+std::array<uint8_t, fb32::c_raw8880HeaderSize>
+encodeHeader(
+    fb32::Dimensions8880 d)
+{
+    std::array<uint8_t, fb32::c_raw8880HeaderSize> header{};
+
+    std::ranges::copy(RAW8880_MAGIC, header.begin());
+    writeLittleEndian(header, 4, d.width());
+    writeLittleEndian(header, 8, d.height());
+    writeLittleEndian(header, 12, RAW8880_VERSION);
+
+    return header;
+}
+
+//-------------------------------------------------------------------------
+
+fb32::Dimensions8880
+decodeHeader(
+    std::span<const uint8_t> data)
+{
+    if (data.size() < fb32::c_raw8880HeaderSize)
+    {
+        throw std::invalid_argument("raw 8880 data too short");
+    }
+
+    if (not std::ranges::equal(data.first(RAW8880_MAGIC.size()), RAW8880_MAGIC))
+    {
+        throw std::invalid_argument("raw 8880 bad magic value");
+    }
+
+    if (readLittleEndian(data, 12) != RAW8880_VERSION)
+    {
+        throw std::invalid_argument("raw 8880 unknown version");
+    }
+
+    const auto width = readLittleEndian(data, 4);
+    const auto height = readLittleEndian(data, 8);
+
+    // Dimensions8880::area() is an int, so the pixel bytes must fit in one.
+
+    constexpr auto maxBytes = static_cast<std::size_t>(std::numeric_limits<int>::max());
+
+    if ((width == 0) or
+        (height == 0) or
+        (width > 65535) or
+        (height > 65535) or
+        ((static_cast<std::size_t>(width) * height * sizeof(uint32_t)) > maxBytes))
+    {
+        throw std::invalid_argument("raw 8880 bad width or height");
+    }
+
+    return {static_cast<int>(width), static_cast<int>(height)};
+}
+
+//-------------------------------------------------------------------------
+
+std::size_t
+pixelBytes(
+    fb32::Dimensions8880 d)
+{
+    return static_cast<std::size_t>(d.width()) * d.height() * sizeof(uint32_t);
+}
+
+//-------------------------------------------------------------------------
+
+}
+
+//=========================================================================
+
+namespace fb32
+{
+
+//-------------------------------------------------------------------------
+
+Image8880
+decodeRaw8880(
+    std::span<const uint8_t> data)
+{
+    const auto d = decodeHeader(data);
+
+    if (data.size() < (c_raw8880HeaderSize + pixelBytes(d)))
+    {
+        throw std::invalid_argument("raw 8880 data too short");
+    }
+
+    Image8880 image{d};
+    std::memcpy(image.getBuffer().data(),
+                data.data() + c_raw8880HeaderSize,
+                pixelBytes(d));
+
+    return image;
+}
+
+//-------------------------------------------------------------------------
+
+std::vector<uint8_t>
+encodeRaw8880(
+    const Interface8880Base& image)
+{
+    const auto id = image.getDimensions();
+    const auto header = encodeHeader(id);
+
+    std::vector<uint8_t> data(c_raw8880HeaderSize + pixelBytes(id));
+    std::ranges::copy(header, data.begin());
+
+    auto* pixels = data.data() + c_raw8880HeaderSize;
+
+    for (int j = 0 ; j < id.height() ; ++j)
+    {
+        const auto row = image.getRow(j);
+        std::memcpy(pixels, row.data(), row.size_bytes());
+        pixels += row.size_bytes();
+    }
+
+    return data;
+}
+
+//-------------------------------------------------------------------------
+
+Image8880
+readRaw8880(
+    const std::string& name)
+{
+    const MappedFile file{name};
+
+    return decodeRaw8880(file.getData());
+}
+
+//-------------------------------------------------------------------------
+
+Raw8880
+viewRaw8880(
+    std::span<const uint8_t> data)
+{
+    const auto d = decodeHeader(data);
+
+    if (data.size() < (c_raw8880HeaderSize + pixelBytes(d)))
+    {
+        throw std::invalid_argument("raw 8880 data too short");
+    }
+
+    const auto* pixels = data.data() + c_raw8880HeaderSize;
+
+    if ((reinterpret_cast<std::uintptr_t>(pixels) % alignof(uint32_t)) != 0)
+    {
+        throw std::invalid_argument("raw 8880 data not aligned");
+    }
+
+    return {d, {reinterpret_cast<const uint32_t*>(pixels),
+                static_cast<std::size_t>(d.area())}};
+}
+
+//-------------------------------------------------------------------------
+
+void
+writeRaw8880(
+    const std::string& name,
+    const Interface8880Base& image)
+{
+    std::ofstream ofs{name, std::ios_base::binary};
+
+    if (not ofs)
+    {
+        throw std::invalid_argument("cannot open " + name + " for writing");
+    }
+
+    const auto id = image.getDimensions();
+    const auto header = encodeHeader(id);
+
+    ofs.write(reinterpret_cast<const char*>(header.data()), header.size());
+
+    // rows are written straight from the image, so there is no copy
+
+    for (int j = 0 ; j < id.height() ; ++j)
+    {
+        const auto row = image.getRow(j);
+        ofs.write(reinterpret_cast<const char*>(row.data()), row.size_bytes());
+    }
+
+    if (not ofs)
+    {
+        throw std::invalid_argument("cannot write " + name);
+    }
+}
+
+//-------------------------------------------------------------------------
+
+}
+
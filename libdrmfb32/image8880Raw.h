@@ -0,0 +1,89 @@
+//-------------------------------------------------------------------------
+//
+// The MIT License (MIT)
+//
+// Copyright (c) 2022 Andrew Duncan
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+//-------------------------------------------------------------------------
+
+#pragma once
+
+//-------------------------------------------------------------------------
+
+#include "image8880.h"
+#include "interface8880Base.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <vector>
+
+//-------------------------------------------------------------------------
+
+namespace fb32
+{
+
+//-------------------------------------------------------------------------
+//
+// Raw 8880 is a 16 byte header, "8880" then the width, height and a
+// version (1) as little endian 32 bit values, followed by the rows of
+// pixels as little endian XRGB8888. It is as fast to write and read as
+// the disk allows and a mapped file can be used in place.
+//
+//-------------------------------------------------------------------------
+
+constexpr std::size_t c_raw8880HeaderSize{16};
+
+struct Raw8880
+{
+    Dimensions8880 m_dimensions;
+    std::span<const uint32_t> m_pixels;
+};
+
+[[nodiscard]] Image8880
+decodeRaw8880(
+    std::span<const uint8_t> data);
+
+[[nodiscard]] std::vector<uint8_t>
+encodeRaw8880(
+    const Interface8880Base& image);
+
+[[nodiscard]] Image8880
+readRaw8880(
+    const std::string& name);
+
+// The pixels point into data, which must be 4 byte aligned.
+
+[[nodiscard]] Raw8880
+viewRaw8880(
+    std::span<const uint8_t> data);
+
+void
+writeRaw8880(
+    const std::string& name,
+    const Interface8880Base& image);
+
+//-------------------------------------------------------------------------
+
+} // namespace fb32
+
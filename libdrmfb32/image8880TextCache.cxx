@@ -0,0 +1,315 @@
+//-------------------------------------------------------------------------
+//
+// The MIT License (MIT)
+//
+// Copyright (c) 2022 Andrew Duncan
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+//-------------------------------------------------------------------------
+
+#include "image8880.h"
+#include "image8880TextCache.h"
+#include "interface8880Base.h"
+#include "rgb8880.h"
+
+#include <algorithm>
+#include <functional>
+#include <iterator>
+#include <utility>
+
+//-------------------------------------------------------------------------
+
+namespace fb32
+{
+
+//-------------------------------------------------------------------------
+
+Image8880TextCache::Image8880TextCache(
+    std::unique_ptr<Interface8880Font> font,
+    std::size_t capacity)
+:
+    m_capacity{capacity},
+    m_font{std::move(font)},
+    m_pixelDimensions{m_font->getPixelDimensions()}
+{
+}
+
+//-------------------------------------------------------------------------
+
+Dimensions8880
+Image8880TextCache::getPixelDimensions() const noexcept
+{
+    return m_font->getPixelDimensions();
+}
+
+//-------------------------------------------------------------------------
+
+std::optional<char>
+Image8880TextCache::getCharacterCode(
+    CharacterCode code) const noexcept
+{
+    return m_font->getCharacterCode(code);
+}
+
+//-------------------------------------------------------------------------
+
+Dimensions8880
+Image8880TextCache::getStringDimensions(
+    std::string_view s)
+{
+    if (const auto entry = findEntry(s))
+    {
+        return entry->m_dimensions;
+    }
+
+    return m_font->getStringDimensions(s);
+}
+
+//-------------------------------------------------------------------------
+
+Point8880
+Image8880TextCache::drawChar(
+    Point8880 p,
+    uint8_t c,
+    const RGB8880& rgb,
+    Interface8880& image)
+{
+    return m_font->drawChar(p, c, rgb, image);
+}
+
+//-------------------------------------------------------------------------
+
+Point8880
+Image8880TextCache::drawChar(
+    Point8880 p,
+    uint8_t c,
+    uint32_t rgb,
+    Interface8880& image)
+{
+    return m_font->drawChar(p, c, rgb, image);
+}
+
+//-------------------------------------------------------------------------
+
+Point8880
+Image8880TextCache::drawString(
+    Point8880 p,
+    std::string_view sv,
+    const RGB8880& rgb,
+    Interface8880& image)
+{
+    return drawString(p, sv, rgb.get8880(), image);
+}
+
+//-------------------------------------------------------------------------
+
+Point8880
+Image8880TextCache::drawString(
+    Point8880 p,
+    std::string_view sv,
+    uint32_t rgb,
+    Interface8880& image)
+{
+    auto base = dynamic_cast<Interface8880Base*>(&image);
+
+    if (not base)
+    {
+        return m_font->drawString(p, sv, rgb, image);
+    }
+
+    auto entry = findEntry(sv);
+
+    if (not entry)
+    {
+        // Remember the string the first time it is drawn, and only render
+        // it into the cache when it is drawn again. A hash collision just
+        // adds a string a little early.
+
+        const auto hash = std::hash<std::string_view>{}(sv);
+
+        if (m_seen.erase(hash) == 1)
+        {
+            entry = addEntry(sv);
+        }
+        else
+        {
+            if (m_seen.size() >= c_maxSeen)
+            {
+                m_seen.clear();
+            }
+
+            m_seen.insert(hash);
+        }
+    }
+
+    if (not entry)
+    {
+        return m_font->drawString(p, sv, rgb, image);
+    }
+
+    base->blendCoverage(Point8880{p.x() + entry->m_offset.x(),
+                                  p.y() + entry->m_offset.y()},
+                        entry->m_maskDimensions,
+                        entry->m_coverage,
+                        rgb);
+
+    return Point8880{p.x() + entry->m_advance.x(),
+                     p.y() + entry->m_advance.y()};
+}
+
+//-------------------------------------------------------------------------
+
+std::size_t
+Image8880TextCache::Entry::cost() const noexcept
+{
+    return sizeof(Entry) + m_text.size() + m_coverage.size();
+}
+
+//-------------------------------------------------------------------------
+
+const Image8880TextCache::Entry*
+Image8880TextCache::addEntry(
+    std::string_view sv)
+{
+    auto entry = render(sv);
+    const auto cost = entry.cost();
+
+    if (cost > m_capacity)
+    {
+        return nullptr;
+    }
+
+    while (m_size + cost > m_capacity)
+    {
+        const auto& last = m_entries.back();
+
+        m_size -= last.cost();
+        m_index.erase(last.m_text);
+        m_entries.pop_back();
+    }
+
+    m_entries.push_front(std::move(entry));
+    m_index.emplace(m_entries.front().m_text, m_entries.begin());
+    m_size += cost;
+
+    return &m_entries.front();
+}
+
+//-------------------------------------------------------------------------
+
+// Only looks, never adds an entry. Empties the cache first if the pixel
+// size of the font has changed.
+
+const Image8880TextCache::Entry*
+Image8880TextCache::findEntry(
+    std::string_view sv)
+{
+    if (const auto d = m_font->getPixelDimensions() ; d != m_pixelDimensions)
+    {
+        m_index.clear();
+        m_entries.clear();
+        m_seen.clear();
+        m_pixelDimensions = d;
+        m_size = 0;
+    }
+
+    if (const auto it = m_index.find(sv) ; it != m_index.end())
+    {
+        m_entries.splice(m_entries.begin(), m_entries, it->second);
+
+        return &m_entries.front();
+    }
+
+    return nullptr;
+}
+
+//-------------------------------------------------------------------------
+
+Image8880TextCache::Entry
+Image8880TextCache::render(
+    std::string_view sv)
+{
+    // Draw the string in white on black with room around it for glyphs
+    // that reach outside the string dimensions, then keep the smallest
+    // rectangle that holds every pixel drawn.
+
+    const auto d = m_font->getStringDimensions(sv);
+    const auto margin = m_pixelDimensions.height();
+    const Point8880 origin{margin, margin};
+
+    Image8880 canvas{Dimensions8880{d.width() + (2 * margin),
+                                    d.height() + (2 * margin)}};
+    const auto end = m_font->drawString(origin, sv, 0x00FFFFFF, canvas);
+    const auto cd = canvas.getDimensions();
+
+    int xMin{cd.width()};
+    int xMax{-1};
+    int yMin{cd.height()};
+    int yMax{-1};
+
+    for (int j = 0 ; j < cd.height() ; ++j)
+    {
+        const auto row = canvas.getRow(j);
+        auto drawn = [](uint32_t pixel) { return pixel != 0; };
+        const auto first = std::find_if(row.begin(), row.end(), drawn);
+
+        if (first != row.end())
+        {
+            const auto last = std::find_if(row.rbegin(), row.rend(), drawn);
+
+            xMin = std::min(xMin, static_cast<int>(std::distance(row.begin(), first)));
+            xMax = std::max(xMax, static_cast<int>(std::distance(last, row.rend())) - 1);
+            yMin = std::min(yMin, j);
+            yMax = j;
+        }
+    }
+
+    Entry entry{std::string(sv),
+                d,
+                Point8880{end.x() - origin.x(), end.y() - origin.y()},
+                Point8880{0, 0},
+                Dimensions8880{},
+                {}};
+
+    if (xMax >= xMin)
+    {
+        const Dimensions8880 md{xMax - xMin + 1, yMax - yMin + 1};
+
+        entry.m_offset = Point8880{xMin - origin.x(), yMin - origin.y()};
+        entry.m_maskDimensions = md;
+        entry.m_coverage.reserve(md.area());
+
+        for (int j = yMin ; j <= yMax ; ++j)
+        {
+            for (const auto pixel : canvas.getRow(j).subspan(xMin, md.width()))
+            {
+                entry.m_coverage.push_back((pixel >> 8) & 0xFF);
+            }
+        }
+    }
+
+    return entry;
+}
+
+//-------------------------------------------------------------------------
+
+} // namespace fb32
+
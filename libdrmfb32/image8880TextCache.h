@@ -0,0 +1,166 @@
+//-------------------------------------------------------------------------
+//
+// The MIT License (MIT)
+//
+// Copyright (c) 2022 Andrew Duncan
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+//-------------------------------------------------------------------------
+
+#pragma once
+
+//-------------------------------------------------------------------------
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "interface8880.h"
+#include "interface8880Font.h"
+#include "point.h"
+
+//-------------------------------------------------------------------------
+
+namespace fb32
+{
+
+//-------------------------------------------------------------------------
+
+class RGB8880;
+
+//-------------------------------------------------------------------------
+//
+// An Image8880TextCache draws strings with another font. The second time
+// a string is drawn it is kept as a coverage mask, and from then on
+// drawing it, in any colour, is a single clipped blend of the mask.
+// Strings drawn only once, such as ones that change every frame, go
+// straight to the font. The least recently used strings are dropped once
+// the masks use more than capacity bytes, and the cache is emptied if the
+// pixel size of the font changes.
+//
+//-------------------------------------------------------------------------
+
+class Image8880TextCache final
+:
+    public Interface8880Font
+{
+public:
+
+    static constexpr std::size_t c_defaultCapacity{4 * 1024 * 1024};
+
+    explicit Image8880TextCache(
+        std::unique_ptr<Interface8880Font> font,
+        std::size_t capacity = c_defaultCapacity);
+
+    ~Image8880TextCache() final = default;
+
+    Image8880TextCache(const Image8880TextCache&) = delete;
+    Image8880TextCache(Image8880TextCache&&) = delete;
+    Image8880TextCache& operator=(const Image8880TextCache&) = delete;
+    Image8880TextCache& operator=(Image8880TextCache&&) = delete;
+
+    [[nodiscard]] std::size_t getCapacity() const noexcept { return m_capacity; }
+    [[nodiscard]] std::size_t getSize() const noexcept { return m_size; }
+
+    [[nodiscard]] Dimensions8880 getPixelDimensions() const noexcept final;
+
+    [[nodiscard]] std::optional<char> getCharacterCode(CharacterCode code) const noexcept final;
+
+    [[nodiscard]] Dimensions8880 getStringDimensions(std::string_view s) final;
+
+    Point8880
+    drawChar(
+        Point8880 p,
+        uint8_t c,
+        const RGB8880& rgb,
+        Interface8880& image) final;
+
+    Point8880
+    drawChar(
+        Point8880 p,
+        uint8_t c,
+        uint32_t rgb,
+        Interface8880& image) final;
+
+    Point8880
+    drawString(
+        Point8880 p,
+        std::string_view sv,
+        const RGB8880& rgb,
+        Interface8880& image) final;
+
+    Point8880
+    drawString(
+        Point8880 p,
+        std::string_view sv,
+        uint32_t rgb,
+        Interface8880& image) final;
+
+private:
+
+    // The mask and the end of the string are relative to where the
+    // string is drawn.
+
+    struct Entry
+    {
+        std::string m_text{};
+        Dimensions8880 m_dimensions{};
+        Point8880 m_advance{0, 0};
+        Point8880 m_offset{0, 0};
+        Dimensions8880 m_maskDimensions{};
+        std::vector<uint8_t> m_coverage{};
+
+        [[nodiscard]] std::size_t cost() const noexcept;
+    };
+
+    using Entries = std::list<Entry>;
+
+    // The number of strings drawn once that are remembered, waiting to be
+    // drawn again.
+
+    static constexpr std::size_t c_maxSeen{1024};
+
+    [[nodiscard]] const Entry* addEntry(std::string_view sv);
+    [[nodiscard]] const Entry* findEntry(std::string_view sv);
+    [[nodiscard]] Entry render(std::string_view sv);
+
+    std::size_t m_capacity;
+    Entries m_entries{};
+    std::unique_ptr<Interface8880Font> m_font;
+    std::unordered_map<std::string_view, Entries::iterator> m_index{};
+    Dimensions8880 m_pixelDimensions{};
+    std::unordered_set<std::size_t> m_seen{};
+    std::size_t m_size{};
+};
+
+//-------------------------------------------------------------------------
+
+} // namespace fb32
+
+//-------------------------------------------------------------------------
+
@@ -0,0 +1,93 @@
+//-------------------------------------------------------------------------
+//
+// The MIT License (MIT)
+//
+// Copyright (c) 2022 Andrew Duncan
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+//-------------------------------------------------------------------------
+
+#pragma once
+
+//-------------------------------------------------------------------------
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+#include "interface8880Base.h"
+
+//-------------------------------------------------------------------------
+
+namespace fb32
+{
+
+//-------------------------------------------------------------------------
+
+// An Image8880View reads and draws into pixels it doesn't own, such as
+// one of a framebuffer's buffers. Rows are stride pixels apart, which may
+// be more than the width. The pixels must outlive the view.
+
+class Image8880View final
+:
+    public Interface8880Base
+{
+public:
+
+    Image8880View(
+        Dimensions8880 d,
+        std::span<uint32_t> buffer,
+        int stride) noexcept
+    :
+        m_dimensions{d},
+        m_buffer{buffer},
+        m_stride{stride}
+    {
+    }
+
+    ~Image8880View() final = default;
+
+    [[nodiscard]] Dimensions8880 getDimensions() const noexcept final { return m_dimensions; }
+
+    [[nodiscard]] std::span<uint32_t> getBuffer() & noexcept final { return m_buffer; }
+    [[nodiscard]] std::span<const uint32_t> getBuffer() const & noexcept final { return m_buffer; }
+
+    [[nodiscard]] std::span<uint32_t> getBuffer() && noexcept = delete;
+    [[nodiscard]] std::span<const uint32_t> getBuffer() const && = delete;
+
+    [[nodiscard]] std::size_t
+    offset(
+        Point8880 p) const noexcept final
+    {
+        return p.x() + (p.y() * m_stride);
+    }
+
+private:
+
+    Dimensions8880 m_dimensions;
+    std::span<uint32_t> m_buffer;
+    int m_stride;
+};
+
+//-------------------------------------------------------------------------
+
+} // namespace fb32
+
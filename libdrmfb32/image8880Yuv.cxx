@@ -0,0 +1,585 @@
+//-------------------------------------------------------------------------
+//
+// The MIT License (MIT)
+//
+// Copyright (c) 2022 Andrew Duncan
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+//-------------------------------------------------------------------------
+
+
+#include "image8880Yuv.h"
+#include "threadPool.h"
+
+//-------------------------------------------------------------------------
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+//=========================================================================
+
+namespace
+{
+
+//-------------------------------------------------------------------------
+
+using Coefficients = fb32::YuvToRGB8880::Coefficients;
+
+constexpr int c_precisionBits{14};
+constexpr int32_t c_round{1 << (c_precisionBits - 1)};
+
+//-------------------------------------------------------------------------
+
+template<typename Row>
+void
+iterateRows(
+    int jStart,
+    int jEnd,
+    Row row)
+{
+    auto rows = [&row](int start, int end)
+    {
+        for (auto j = start ; j < end ; ++j)
+        {
+            row(j);
+        }
+    };
+
+#ifdef WITH_BS_THREAD_POOL
+    auto& tPool = fb32::threadPool();
+    tPool.submit_blocks<int>(jStart, jEnd, rows).wait();
+#else
+    rows(jStart, jEnd);
+#endif
+}
+
+//-------------------------------------------------------------------------
+
+void
+checkPlane(
+    const fb32::YuvPlane& plane,
+    int rowBytes,
+    int rows)
+{
+    const auto size = static_cast<std::size_t>(plane.m_stride) * (rows - 1) +
+                      rowBytes;
+
+    if ((plane.m_stride < rowBytes) or (plane.m_data.size() < size))
+    {
+        throw std::invalid_argument("YUV plane is too small for image");
+    }
+}
+
+//-------------------------------------------------------------------------
+
+// Kept small and branch free so that the row loops below vectorize.
+
+inline uint32_t
+toRGB8880(
+    const Coefficients& c,
+    int32_t y,
+    int32_t u,
+    int32_t v) noexcept
+{
+    const auto luma = c.m_y * (y - c.m_yOffset) + c_round;
+    u -= 128;
+    v -= 128;
+
+    const auto r = std::clamp((luma + c.m_rv * v) >> c_precisionBits, 0, 255);
+    const auto g = std::clamp((luma + c.m_gu * u + c.m_gv * v) >> c_precisionBits, 0, 255);
+    const auto b = std::clamp((luma + c.m_bu * u) >> c_precisionBits, 0, 255);
+
+    return (static_cast<uint32_t>(r) << 16) |
+           (static_cast<uint32_t>(g) << 8) |
+           static_cast<uint32_t>(b);
+}
+
+//-------------------------------------------------------------------------
+
+inline uint32_t
+toGrey8880(
+    const Coefficients& c,
+    int32_t y) noexcept
+{
+    const auto luma = std::clamp((c.m_y * (y - c.m_yOffset) + c_round) >> c_precisionBits,
+                                 0,
+                                 255);
+
+    return static_cast<uint32_t>(luma) * 0x010101;
+}
+
+//-------------------------------------------------------------------------
+
+// Convert pixels x0 to x1 of a row. A pair of pixels shares its chroma, so
+// an odd first or last pixel is converted on its own and the rest in
+// pairs.
+
+void
+yuyvRow(
+    const Coefficients& c,
+    const uint8_t* row,
+    int x0,
+    int x1,
+    uint32_t* output)
+{
+    auto x = x0;
+
+    if ((x % 2) and (x < x1))
+    {
+        const auto* yuyv = row + 2 * (x - 1);
+        *(output++) = toRGB8880(c, yuyv[2], yuyv[1], yuyv[3]);
+        ++x;
+    }
+
+    const auto pairs = (x1 - x) / 2;
+    const auto* yuyv = row + 2 * x;
+
+    for (auto k = 0 ; k < pairs ; ++k)
+    {
+        const int32_t u = yuyv[4 * k + 1];
+        const int32_t v = yuyv[4 * k + 3];
+
+        output[2 * k] = toRGB8880(c, yuyv[4 * k], u, v);
+        output[2 * k + 1] = toRGB8880(c, yuyv[4 * k + 2], u, v);
+    }
+
+    x += 2 * pairs;
+
+    if (x < x1)
+    {
+        yuyv = row + 2 * x;
+        output[2 * pairs] = toRGB8880(c, yuyv[0], yuyv[1], yuyv[3]);
+    }
+}
+
+//-------------------------------------------------------------------------
+
+// I420 has separate U and V rows (step 1). NV12 has them interleaved, so
+// u and v point into the same row and step is 2.
+
+template<int Step>
+void
+planarRow(
+    const Coefficients& c,
+    const uint8_t* y,
+    const uint8_t* u,
+    const uint8_t* v,
+    int x0,
+    int x1,
+    uint32_t* output)
+{
+    auto x = x0;
+
+    if ((x % 2) and (x < x1))
+    {
+        const auto i = Step * (x / 2);
+        *(output++) = toRGB8880(c, y[x], u[i], v[i]);
+        ++x;
+    }
+
+    const auto pairs = (x1 - x) / 2;
+    const auto* yPair = y + x;
+    const auto* uPair = u + Step * (x / 2);
+    const auto* vPair = v + Step * (x / 2);
+
+    for (auto k = 0 ; k < pairs ; ++k)
+    {
+        const int32_t uk = uPair[Step * k];
+        const int32_t vk = vPair[Step * k];
+
+        output[2 * k] = toRGB8880(c, yPair[2 * k], uk, vk);
+        output[2 * k + 1] = toRGB8880(c, yPair[2 * k + 1], uk, vk);
+    }
+
+    x += 2 * pairs;
+
+    if (x < x1)
+    {
+        const auto i = Step * (x / 2);
+        output[2 * pairs] = toRGB8880(c, y[x], u[i], v[i]);
+    }
+}
+
+//-------------------------------------------------------------------------
+
+template<int Step>
+void
+greyRow(
+    const Coefficients& c,
+    const uint8_t* y,
+    int x0,
+    int x1,
+    uint32_t* output)
+{
+    const auto* yStart = y + Step * x0;
+
+    for (auto i = 0 ; i < x1 - x0 ; ++i)
+    {
+        output[i] = toGrey8880(c, yStart[Step * i]);
+    }
+}
+
+//-------------------------------------------------------------------------
+
+// Convert each row of an image of dimensions d with row(j, x0, x1, output)
+// into rows of output that are stride pixels apart.
+
+template<typename Row>
+void
+convert(
+    fb32::Dimensions8880 d,
+    std::span<uint32_t> output,
+    int stride,
+    Row row)
+{
+    const auto size = static_cast<std::size_t>(stride) * (d.height() - 1) +
+                      d.width();
+
+    if ((stride < d.width()) or (output.size() < size))
+    {
+        throw std::invalid_argument("output is too small for YUV image");
+    }
+
+    iterateRows(0, d.height(), [&](int j)
+    {
+        row(j, 0, d.width(), output.data() + static_cast<std::size_t>(j) * stride);
+    });
+}
+
+//-------------------------------------------------------------------------
+
+// As above, but into image with the top left corner of the YUV image at
+// p, clipped to the image.
+
+template<typename Row>
+void
+convert(
+    fb32::Dimensions8880 d,
+    fb32::Interface8880Base& image,
+    fb32::Point8880 p,
+    Row row)
+{
+    const auto id = image.getDimensions();
+    const auto x0 = std::max(0, -p.x());
+    const auto x1 = std::min(d.width(), id.width() - p.x());
+    const auto y0 = std::max(0, -p.y());
+    const auto y1 = std::min(d.height(), id.height() - p.y());
+
+    if ((x0 >= x1) or (y0 >= y1))
+    {
+        return;
+    }
+
+    iterateRows(y0, y1, [&](int j)
+    {
+        row(j, x0, x1, image.getRow(p.y() + j).data() + p.x() + x0);
+    });
+
+    image.addDamage(fb32::Point8880{p.x() + x0, p.y() + y0},
+                    fb32::Dimensions8880{x1 - x0, y1 - y0});
+}
+
+//-------------------------------------------------------------------------
+
+// Chroma samples cover two pixels (and for 4:2:0, two rows), rounded up
+// for odd dimensions.
+
+int
+chromaSize(
+    int size)
+{
+    return (size + 1) / 2;
+}
+
+//-------------------------------------------------------------------------
+
+// Validate the planes and return the row converter for each format.
+
+auto
+i420Rows(
+    const Coefficients& c,
+    fb32::Dimensions8880 d,
+    const fb32::YuvPlane& y,
+    const fb32::YuvPlane& u,
+    const fb32::YuvPlane& v)
+{
+    checkPlane(y, d.width(), d.height());
+    checkPlane(u, chromaSize(d.width()), chromaSize(d.height()));
+    checkPlane(v, chromaSize(d.width()), chromaSize(d.height()));
+
+    return [&c, &y, &u, &v](int j, int x0, int x1, uint32_t* output)
+    {
+        planarRow<1>(c,
+                     y.m_data.data() + j * y.m_stride,
+                     u.m_data.data() + (j / 2) * u.m_stride,
+                     v.m_data.data() + (j / 2) * v.m_stride,
+                     x0,
+                     x1,
+                     output);
+    };
+}
+
+//-------------------------------------------------------------------------
+
+auto
+nv12Rows(
+    const Coefficients& c,
+    fb32::Dimensions8880 d,
+    const fb32::YuvPlane& y,
+    const fb32::YuvPlane& uv)
+{
+    checkPlane(y, d.width(), d.height());
+    checkPlane(uv, 2 * chromaSize(d.width()), chromaSize(d.height()));
+
+    return [&c, &y, &uv](int j, int x0, int x1, uint32_t* output)
+    {
+        const auto* uvRow = uv.m_data.data() + (j / 2) * uv.m_stride;
+
+        planarRow<2>(c,
+                     y.m_data.data() + j * y.m_stride,
+                     uvRow,
+                     uvRow + 1,
+                     x0,
+                     x1,
+                     output);
+    };
+}
+
+//-------------------------------------------------------------------------
+
+auto
+yuyvRows(
+    const Coefficients& c,
+    fb32::Dimensions8880 d,
+    const fb32::YuvPlane& yuyv)
+{
+    checkPlane(yuyv, 4 * chromaSize(d.width()), d.height());
+
+    return [&c, &yuyv](int j, int x0, int x1, uint32_t* output)
+    {
+        yuyvRow(c, yuyv.m_data.data() + j * yuyv.m_stride, x0, x1, output);
+    };
+}
+
+//-------------------------------------------------------------------------
+
+auto
+greyRows(
+    const Coefficients& c,
+    fb32::Dimensions8880 d,
+    const fb32::YuvPlane& y,
+    int step)
+{
+    if ((step != 1) and (step != 2))
+    {
+        throw std::invalid_argument("Y sample step must be 1 or 2");
+    }
+
+    checkPlane(y, step * (d.width() - 1) + 1, d.height());
+
+    return [&c, &y, step](int j, int x0, int x1, uint32_t* output)
+    {
+        const auto* row = y.m_data.data() + j * y.m_stride;
+
+        if (step == 1)
+        {
+            greyRow<1>(c, row, x0, x1, output);
+        }
+        else
+        {
+            greyRow<2>(c, row, x0, x1, output);
+        }
+    };
+}
+
+//-------------------------------------------------------------------------
+
+bool
+isEmpty(
+    fb32::Dimensions8880 d)
+{
+    return (d.width() <= 0) or (d.height() <= 0);
+}
+
+//-------------------------------------------------------------------------
+
+} // namespace
+
+//=========================================================================
+
+fb32::YuvToRGB8880::YuvToRGB8880(
+    Matrix matrix,
+    Range range)
+:
+    m_coefficients{},
+    m_matrix{matrix},
+    m_range{range}
+{
+    const auto kr = (matrix == Matrix::BT709) ? 0.2126 : 0.299;
+    const auto kb = (matrix == Matrix::BT709) ? 0.0722 : 0.114;
+    const auto kg = 1.0 - kr - kb;
+
+    const auto limited = (range == Range::LIMITED);
+    const auto yScale = limited ? (255.0 / 219.0) : 1.0;
+    const auto cScale = limited ? (255.0 / 224.0) : 1.0;
+
+    auto fixed = [](double value)
+    {
+        return static_cast<int32_t>(std::lround(value * (1 << c_precisionBits)));
+    };
+
+    m_coefficients.m_y = fixed(yScale);
+    m_coefficients.m_yOffset = limited ? 16 : 0;
+    m_coefficients.m_rv = fixed(2.0 * (1.0 - kr) * cScale);
+    m_coefficients.m_gu = fixed(-2.0 * kb * (1.0 - kb) / kg * cScale);
+    m_coefficients.m_gv = fixed(-2.0 * kr * (1.0 - kr) / kg * cScale);
+    m_coefficients.m_bu = fixed(2.0 * (1.0 - kb) * cScale);
+}
+
+//-------------------------------------------------------------------------
+
+void
+fb32::YuvToRGB8880::i420(
+    Dimensions8880 d,
+    YuvPlane y,
+    YuvPlane u,
+    YuvPlane v,
+    std::span<uint32_t> output,
+    int stride) const
+{
+    if (not isEmpty(d))
+    {
+        convert(d, output, stride, i420Rows(m_coefficients, d, y, u, v));
+    }
+}
+
+//-------------------------------------------------------------------------
+
+void
+fb32::YuvToRGB8880::i420(
+    Dimensions8880 d,
+    YuvPlane y,
+    YuvPlane u,
+    YuvPlane v,
+    Interface8880Base& image,
+    Point8880 p) const
+{
+    if (not isEmpty(d))
+    {
+        convert(d, image, p, i420Rows(m_coefficients, d, y, u, v));
+    }
+}
+
+//-------------------------------------------------------------------------
+
+void
+fb32::YuvToRGB8880::nv12(
+    Dimensions8880 d,
+    YuvPlane y,
+    YuvPlane uv,
+    std::span<uint32_t> output,
+    int stride) const
+{
+    if (not isEmpty(d))
+    {
+        convert(d, output, stride, nv12Rows(m_coefficients, d, y, uv));
+    }
+}
+
+//-------------------------------------------------------------------------
+
+void
+fb32::YuvToRGB8880::nv12(
+    Dimensions8880 d,
+    YuvPlane y,
+    YuvPlane uv,
+    Interface8880Base& image,
+    Point8880 p) const
+{
+    if (not isEmpty(d))
+    {
+        convert(d, image, p, nv12Rows(m_coefficients, d, y, uv));
+    }
+}
+
+//-------------------------------------------------------------------------
+
+void
+fb32::YuvToRGB8880::yuyv(
+    Dimensions8880 d,
+    YuvPlane yuyv,
+    std::span<uint32_t> output,
+    int stride) const
+{
+    if (not isEmpty(d))
+    {
+        convert(d, output, stride, yuyvRows(m_coefficients, d, yuyv));
+    }
+}
+
+//-------------------------------------------------------------------------
+
+void
+fb32::YuvToRGB8880::yuyv(
+    Dimensions8880 d,
+    YuvPlane yuyv,
+    Interface8880Base& image,
+    Point8880 p) const
+{
+    if (not isEmpty(d))
+    {
+        convert(d, image, p, yuyvRows(m_coefficients, d, yuyv));
+    }
+}
+
+//-------------------------------------------------------------------------
+
+void
+fb32::YuvToRGB8880::grey(
+    Dimensions8880 d,
+    YuvPlane y,
+    int step,
+    std::span<uint32_t> output,
+    int stride) const
+{
+    if (not isEmpty(d))
+    {
+        convert(d, output, stride, greyRows(m_coefficients, d, y, step));
+    }
+}
+
+//-------------------------------------------------------------------------
+
+void
+fb32::YuvToRGB8880::grey(
+    Dimensions8880 d,
+    YuvPlane y,
+    int step,
+    Interface8880Base& image,
+    Point8880 p) const
+{
+    if (not isEmpty(d))
+    {
+        convert(d, image, p, greyRows(m_coefficients, d, y, step));
+    }
+}
+
@@ -0,0 +1,180 @@
+//-------------------------------------------------------------------------
+//
+// The MIT License (MIT)
+//
+// Copyright (c) 2022 Andrew Duncan
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+//-------------------------------------------------------------------------
+
+
+#pragma once
+
+//-------------------------------------------------------------------------
+
+#include <cstdint>
+#include <span>
+
+#include "interface8880Base.h"
+#include "point.h"
+
+//-------------------------------------------------------------------------
+
+namespace fb32
+{
+
+//-------------------------------------------------------------------------
+
+// A plane of 8 bit samples, with the distance between the start of each
+// row in bytes.
+
+struct YuvPlane
+{
+    std::span<const uint8_t> m_data{};
+    int m_stride{};
+};
+
+//-------------------------------------------------------------------------
+//
+// Converts YUYV (4:2:2 packed), NV12 (4:2:0 with interleaved chroma) and
+// I420 (4:2:0 planar) images to 8880, using either BT.601 or BT.709
+// coefficients with limited (16-235) or full (0-255) range.
+//
+// Each conversion writes either to rows of output that are stride pixels
+// apart, or straight into image (e.g. the frame buffer) with its top left
+// corner at p, clipped to fit. Rows are converted in parallel when the
+// thread pool is available.
+//
+//-------------------------------------------------------------------------
+
+class YuvToRGB8880
+{
+public:
+
+    enum class Matrix
+    {
+        BT601,
+        BT709
+    };
+
+    enum class Range
+    {
+        LIMITED,
+        FULL
+    };
+
+    explicit YuvToRGB8880(
+        Matrix matrix = Matrix::BT601,
+        Range range = Range::LIMITED);
+
+    [[nodiscard]] Matrix getMatrix() const noexcept { return m_matrix; }
+    [[nodiscard]] Range getRange() const noexcept { return m_range; }
+
+    void
+    i420(
+        Dimensions8880 d,
+        YuvPlane y,
+        YuvPlane u,
+        YuvPlane v,
+        std::span<uint32_t> output,
+        int stride) const;
+
+    void
+    i420(
+        Dimensions8880 d,
+        YuvPlane y,
+        YuvPlane u,
+        YuvPlane v,
+        Interface8880Base& image,
+        Point8880 p = {0, 0}) const;
+
+    void
+    nv12(
+        Dimensions8880 d,
+        YuvPlane y,
+        YuvPlane uv,
+        std::span<uint32_t> output,
+        int stride) const;
+
+    void
+    nv12(
+        Dimensions8880 d,
+        YuvPlane y,
+        YuvPlane uv,
+        Interface8880Base& image,
+        Point8880 p = {0, 0}) const;
+
+    void
+    yuyv(
+        Dimensions8880 d,
+        YuvPlane yuyv,
+        std::span<uint32_t> output,
+        int stride) const;
+
+    void
+    yuyv(
+        Dimensions8880 d,
+        YuvPlane yuyv,
+        Interface8880Base& image,
+        Point8880 p = {0, 0}) const;
+
+    // Greyscale from the Y samples alone. step is 1 for the Y plane of
+    // NV12 and I420, and 2 for YUYV.
+
+    void
+    grey(
+        Dimensions8880 d,
+        YuvPlane y,
+        int step,
+        std::span<uint32_t> output,
+        int stride) const;
+
+    void
+    grey(
+        Dimensions8880 d,
+        YuvPlane y,
+        int step,
+        Interface8880Base& image,
+        Point8880 p = {0, 0}) const;
+
+    // Fixed point coefficients, scaled by 2^14.
+
+    struct Coefficients
+    {
+        int32_t m_y;
+        int32_t m_yOffset;
+        int32_t m_rv;
+        int32_t m_gu;
+        int32_t m_gv;
+        int32_t m_bu;
+    };
+
+private:
+
+    Coefficients m_coefficients;
+    Matrix m_matrix;
+    Range m_range;
+};
+
+//-------------------------------------------------------------------------
+
+} // namespace fb32
+
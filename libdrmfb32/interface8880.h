@@ -76,10 +76,9 @@ public:
 inline Point8880
 center(
     const Interface8880& frame,
-    const Interface8880& image) noexcept
+    Dimensions8880 id) noexcept
 {
     const auto fd = frame.getDimensions();
-    const auto id = image.getDimensions();
 
     return {(fd.width() - id.width()) / 2,
             (fd.height() - id.height()) / 2};
@@ -87,5 +86,15 @@ center(
 
 //-------------------------------------------------------------------------
 
+inline Point8880
+center(
+    const Interface8880& frame,
+    const Interface8880& image) noexcept
+{
+    return center(frame, image.getDimensions());
+}
+
+//-------------------------------------------------------------------------
+
 } // namespace fb32
 
@@ -25,24 +25,296 @@
 //
 //-------------------------------------------------------------------------
 
+#include "fixedPoint.h"
 #include "image8880.h"
 #include "interface8880Base.h"
 
 #include <algorithm>
+#include <array>
+#include <cmath>
+#include <ranges>
+#include <stdexcept>
 
 //-------------------------------------------------------------------------
 
+using Point = fb32::Point8880;
+
+//=========================================================================
+
+namespace
+{
+
+//-------------------------------------------------------------------------
+
+// Blend rgb over background, alpha runs from 0 to 256.
+
+[[nodiscard]] uint32_t
+blendAlpha(
+    uint32_t rgb,
+    uint32_t background,
+    uint32_t alpha) noexcept
+{
+    auto channel = [=](int shift) -> uint32_t
+    {
+        const int a = (rgb >> shift) & 0xFF;
+        const int b = (background >> shift) & 0xFF;
+
+        return (b + (((a - b) * static_cast<int>(alpha)) >> 8)) & 0xFF;
+    };
+
+    return (channel(16) << 16) | (channel(8) << 8) | channel(0);
+}
+
+//-------------------------------------------------------------------------
+
+// Blend rgb over background, alpha runs from 0 to 255. The red and blue
+// channels are blended together, and (t + 1 + (t >> 8)) >> 8 is exactly
+// t / 255 for the products that can occur.
+
+[[nodiscard]] uint32_t
+blendCoverageAlpha(
+    uint32_t rgb,
+    uint32_t background,
+    uint32_t alpha) noexcept
+{
+    auto divide255 = [](uint32_t t) -> uint32_t
+    {
+        return ((t + 0x00010001 + ((t >> 8) & 0x00FF00FF)) >> 8) & 0x00FF00FF;
+    };
+
+    const auto inverse = 255 - alpha;
+
+    const auto rb = divide255(((rgb & 0x00FF00FF) * alpha) +
+                              ((background & 0x00FF00FF) * inverse));
+    const auto g = divide255((((rgb >> 8) & 0xFF) * alpha) +
+                             (((background >> 8) & 0xFF) * inverse));
+
+    return rb | (g << 8);
+}
+
+//-------------------------------------------------------------------------
+
+// Samples an image at 16.16 fixed point positions, where pixel (i, j)
+// covers [i, i + 1) x [j, j + 1). Bilinear samples are taken relative to
+// pixel centres and held at the edge pixels. With a colour key, keyed
+// pixels don't contribute and the coverage (0 to 256) says how much of
+// the sample is left.
+
+class TransformSource
+{
+public:
+
+    struct Sample
+    {
+        uint32_t m_rgb;
+        uint32_t m_coverage;
+    };
+
+    explicit TransformSource(const fb32::Interface8880Base& image) noexcept
+    :
+        m_pixels{image.getBuffer().data()},
+        m_stride{static_cast<std::ptrdiff_t>(image.offset(Point{0, 1}) -
+                                             image.offset(Point{0, 0}))},
+        m_width{image.getDimensions().width()},
+        m_height{image.getDimensions().height()}
+    {
+    }
+
+    [[nodiscard]] uint32_t
+    nearest(
+        int64_t x,
+        int64_t y) const noexcept
+    {
+        return m_pixels[((y >> fb32::c_fixedPointShift) * m_stride) +
+                        (x >> fb32::c_fixedPointShift)];
+    }
+
+    template<bool KEYED>
+    [[nodiscard]] Sample
+    bilinear(
+        int64_t x,
+        int64_t y,
+        uint32_t key) const noexcept
+    {
+        const auto [ix, fx, nx] = tap(x, m_width, 1);
+        const auto [iy, fy, ny] = tap(y, m_height, m_stride);
+
+        const auto* p0 = m_pixels + (iy * m_stride) + ix;
+        const auto* p1 = p0 + ny;
+
+        if constexpr (not KEYED)
+        {
+            return {lerp(lerp(p0[0], p0[nx], fx), lerp(p1[0], p1[nx], fx), fy),
+                    1 << 8};
+        }
+
+        const std::array<uint32_t, 4> taps{p0[0], p0[nx], p1[0], p1[nx]};
+        std::array<uint32_t, 4> weights{(256 - fx) * (256 - fy),
+                                        fx * (256 - fy),
+                                        (256 - fx) * fy,
+                                        fx * fy};
+
+        uint32_t total{};
+
+        for (std::size_t t = 0 ; t < taps.size() ; ++t)
+        {
+            if (taps[t] == key)
+            {
+                weights[t] = 0;
+            }
+
+            total += weights[t];
+        }
+
+        if (total == 0)
+        {
+            return {0, 0};
+        }
+
+        auto channel = [&](int shift) -> uint32_t
+        {
+            uint32_t value{};
+
+            for (std::size_t t = 0 ; t < taps.size() ; ++t)
+            {
+                value += ((taps[t] >> shift) & 0xFF) * weights[t];
+            }
+
+            return value / total;
+        };
+
+        return {(channel(16) << 16) | (channel(8) << 8) | channel(0),
+                total >> 8};
+    }
+
+private:
+
+    // Interpolate between a and b with fraction running from 0 to 256,
+    // red and blue together and green on its own.
+
+    [[nodiscard]] static uint32_t
+    lerp(
+        uint32_t a,
+        uint32_t b,
+        uint32_t fraction) noexcept
+    {
+        const auto rb = (((a & 0xFF00FF) * (256 - fraction)) +
+                         ((b & 0xFF00FF) * fraction)) >> 8;
+        const auto g = (((a & 0x00FF00) * (256 - fraction)) +
+                        ((b & 0x00FF00) * fraction)) >> 8;
+
+        return (rb & 0xFF00FF) | (g & 0x00FF00);
+    }
+
+    struct Tap
+    {
+        std::ptrdiff_t m_index;
+        uint32_t m_fraction;
+        std::ptrdiff_t m_next;
+    };
+
+    [[nodiscard]] static Tap
+    tap(
+        int64_t position,
+        int size,
+        std::ptrdiff_t step) noexcept
+    {
+        const auto centre = position - (1 << (fb32::c_fixedPointShift - 1));
+
+        if (centre < 0)
+        {
+            return {0, 0, 0};
+        }
+
+        const auto index = static_cast<std::ptrdiff_t>(centre >> fb32::c_fixedPointShift);
+
+        if (index >= size - 1)
+        {
+            return {size - 1, 0, 0};
+        }
+
+        return {index, static_cast<uint32_t>((centre >> 8) & 0xFF), step};
+    }
+
+    const uint32_t* m_pixels;
+    std::ptrdiff_t m_stride;
+    int m_width;
+    int m_height;
+};
+
+//-------------------------------------------------------------------------
+
+} // namespace
+
+//=========================================================================
+
 namespace fb32
 {
 
 //-------------------------------------------------------------------------
 
+bool
+fb32::Interface8880Base::blendCoverage(
+    Point8880 p,
+    Dimensions8880 d,
+    std::span<const uint8_t> coverage,
+    uint32_t rgb)
+{
+    if (coverage.size() < static_cast<std::size_t>(d.area()))
+    {
+        throw std::invalid_argument("coverage smaller than its dimensions");
+    }
+
+    const auto id = getDimensions();
+
+    const int xStart = std::max(0, -p.x());
+    const int xEnd = std::min(d.width(), id.width() - p.x());
+    const int yStart = std::max(0, -p.y());
+    const int yEnd = std::min(d.height(), id.height() - p.y());
+
+    if ((xStart >= xEnd) or (yStart >= yEnd))
+    {
+        return false;
+    }
+
+    const auto width = xEnd - xStart;
+    rgb &= 0x00FFFFFF;
+
+    for (int j = yStart ; j < yEnd ; ++j)
+    {
+        const auto mask = coverage.subspan((j * d.width()) + xStart, width);
+        const auto row = getRow(p.y() + j).subspan(p.x() + xStart, width);
+
+        for (int i = 0 ; i < width ; ++i)
+        {
+            const uint32_t alpha = mask[i];
+
+            if (alpha == 255)
+            {
+                row[i] = rgb;
+            }
+            else if (alpha)
+            {
+                row[i] = blendCoverageAlpha(rgb, row[i], alpha);
+            }
+        }
+    }
+
+    addDamage(Point8880{p.x() + xStart, p.y() + yStart},
+              Dimensions8880{width, yEnd - yStart});
+
+    return true;
+}
+
+//-------------------------------------------------------------------------
+
 void
 fb32::Interface8880Base::clear(
     uint32_t rgb)
 {
     auto buffer = getBuffer();
     std::ranges::fill(buffer, rgb);
+    addDamage(Point8880{0, 0}, getDimensions());
 }
 
 //-------------------------------------------------------------------------
@@ -159,6 +431,8 @@ fb32::Interface8880Base::putImage(
         std::ranges::copy(row, cbegin(getBuffer().subspan(ost)));
     }
 
+    addDamage(p, id);
+
     return true;
 }
 
@@ -221,6 +495,191 @@ fb32::Interface8880Base::putImagePartial(
         std::ranges::copy(row, cbegin(getBuffer().subspan(ost)));
     }
 
+    addDamage(Point8880{x, y}, Dimensions8880{xLength, yEnd - yStart + 1});
+
+    return true;
+}
+
+//-------------------------------------------------------------------------
+
+bool
+fb32::Interface8880Base::putImageTransformed(
+    Point8880 p,
+    const Interface8880Base& image,
+    const Affine& affine,
+    Affine::Filter filter,
+    std::optional<uint32_t> colourKey,
+    uint8_t alpha)
+{
+    const auto inverse = affine.inverse();
+    const auto id = image.getDimensions();
+    const auto d = getDimensions();
+
+    if ((not inverse) or (alpha == 0) or (id.area() <= 0) or (d.area() <= 0))
+    {
+        return false;
+    }
+
+    //---------------------------------------------------------------------
+    // clip the bounding box of the transformed image to this one
+
+    const std::array<Point<double>, 4> corners
+    {
+        affine.map(0.0, 0.0),
+        affine.map(id.width(), 0.0),
+        affine.map(0.0, id.height()),
+        affine.map(id.width(), id.height())
+    };
+
+    auto [xMin, xMax] = std::ranges::minmax(corners | std::views::transform(&Point<double>::x));
+    auto [yMin, yMax] = std::ranges::minmax(corners | std::views::transform(&Point<double>::y));
+
+    auto clamp = [](double value, int maximum) -> int
+    {
+        return static_cast<int>(std::clamp(value, -1.0, static_cast<double>(maximum)));
+    };
+
+    const auto iStart = clamp(std::floor(xMin + p.x()), d.width());
+    const auto iEnd = clamp(std::ceil(xMax + p.x()), d.width());
+    const auto jStart = std::max(0, clamp(std::floor(yMin + p.y()), d.height()));
+    const auto jEnd = clamp(std::ceil(yMax + p.y()), d.height());
+
+    if ((std::max(iStart, 0) >= iEnd) or (jStart >= jEnd))
+    {
+        return false;
+    }
+
+    //---------------------------------------------------------------------
+    // (x, y) in the image of the centre of pixel (i, j) is
+    //
+    //   x = a * i + b * j + c
+    //   y = d * i + e * j + f
+    //
+    // and for each row the span of pixels that fall inside the image is
+    // found exactly in 16.16 fixed point and stepped through.
+
+    const auto m = *inverse * Affine::translate(0.5 - p.x(), 0.5 - p.y());
+
+    const int64_t xMaximum{(static_cast<int64_t>(id.width()) << fb32::c_fixedPointShift) - 1};
+    const int64_t yMaximum{(static_cast<int64_t>(id.height()) << fb32::c_fixedPointShift) - 1};
+    const auto xStep = std::llround(m.a() * fb32::c_fixedPointOne);
+    const auto yStep = std::llround(m.d() * fb32::c_fixedPointOne);
+
+    const TransformSource source{image};
+    auto buffer = getBuffer();
+
+    int iDrawnStart{d.width()};
+    int iDrawnEnd{-1};
+    int jDrawnStart{d.height()};
+    int jDrawnEnd{-1};
+
+    auto draw = [&](auto plot)
+    {
+        for (int j = jStart ; j < jEnd ; ++j)
+        {
+            const auto xStart = std::llround((m.b() * j + m.c()) * fb32::c_fixedPointOne);
+            const auto yStart = std::llround((m.e() * j + m.f()) * fb32::c_fixedPointOne);
+
+            int first{std::max(iStart, 0)};
+            int last{iEnd - 1};
+
+            fb32::clipFixedPointSpan(xStart, xStep, xMaximum, first, last);
+            fb32::clipFixedPointSpan(yStart, yStep, yMaximum, first, last);
+
+            if (first > last)
+            {
+                continue;
+            }
+
+            iDrawnStart = std::min(iDrawnStart, first);
+            iDrawnEnd = std::max(iDrawnEnd, last);
+            jDrawnStart = std::min(jDrawnStart, j);
+            jDrawnEnd = j;
+
+            auto x = xStart + (first * xStep);
+            auto y = yStart + (first * yStep);
+            auto* row = buffer.data() + offset(Point8880{0, j});
+
+            for (int i = first ; i <= last ; ++i)
+            {
+                plot(row[i], x, y);
+
+                x += xStep;
+                y += yStep;
+            }
+        }
+    };
+
+    //---------------------------------------------------------------------
+
+    const uint32_t opacity = alpha + (alpha >> 7);
+    const bool opaque = (alpha == 255);
+    const auto key = colourKey.value_or(0);
+
+    if (filter == Affine::Filter::NEAREST_NEIGHBOUR)
+    {
+        if (opaque and not colourKey)
+        {
+            draw([&source](uint32_t& pixel, int64_t x, int64_t y)
+            {
+                pixel = source.nearest(x, y);
+            });
+        }
+        else
+        {
+            const bool keyed = colourKey.has_value();
+
+            draw([&source, keyed, key, opacity](uint32_t& pixel, int64_t x, int64_t y)
+            {
+                const auto rgb = source.nearest(x, y);
+
+                if ((not keyed) or (rgb != key))
+                {
+                    pixel = blendAlpha(rgb, pixel, opacity);
+                }
+            });
+        }
+    }
+    else if (colourKey)
+    {
+        draw([&source, key, opacity](uint32_t& pixel, int64_t x, int64_t y)
+        {
+            const auto sample = source.bilinear<true>(x, y, key);
+
+            if (sample.m_coverage > 0)
+            {
+                pixel = blendAlpha(sample.m_rgb,
+                                   pixel,
+                                   (sample.m_coverage * opacity) >> 8);
+            }
+        });
+    }
+    else if (opaque)
+    {
+        draw([&source](uint32_t& pixel, int64_t x, int64_t y)
+        {
+            pixel = source.bilinear<false>(x, y, 0).m_rgb;
+        });
+    }
+    else
+    {
+        draw([&source, opacity](uint32_t& pixel, int64_t x, int64_t y)
+        {
+            pixel = blendAlpha(source.bilinear<false>(x, y, 0).m_rgb,
+                               pixel,
+                               opacity);
+        });
+    }
+
+    if (iDrawnEnd < iDrawnStart)
+    {
+        return false;
+    }
+
+    addDamage(Point8880{iDrawnStart, jDrawnStart},
+              Dimensions8880{iDrawnEnd - iDrawnStart + 1,
+                             jDrawnEnd - jDrawnStart + 1});
+
     return true;
 }
 
@@ -237,6 +696,7 @@ fb32::Interface8880Base::setPixel(
     {
         auto buffer = getBuffer();
         buffer[offset(p)] = rgb;
+        addDamage(p, Dimensions8880{1, 1});
     }
 
     return isValid;
@@ -33,6 +33,7 @@
 #include <optional>
 #include <span>
 
+#include "affine.h"
 #include "dimensions.h"
 #include "interface8880.h"
 #include "point.h"
@@ -55,8 +56,14 @@ public:
 
     ~Interface8880Base() override = default;
 
-    [[nodiscard]] virtual std::span<uint32_t> getBuffer() & noexcept = 0;
-    [[nodiscard]] virtual std::span<const uint32_t> getBuffer() const & noexcept = 0;
+    // Record that a region has been drawn. clear(), setPixel() and
+    // putImage() call this, as should code that writes to getBuffer() or
+    // getRow() directly. Interfaces that don't track damage ignore it.
+
+    virtual void addDamage(Point8880, Dimensions8880) noexcept {}
+
+    [[nodiscard]] virtual std::span<uint32_t> getBuffer() & = 0;
+    [[nodiscard]] virtual std::span<const uint32_t> getBuffer() const & = 0;
 
     [[nodiscard]] std::span<uint32_t> getBuffer() && noexcept = delete;
     [[nodiscard]] std::span<const uint32_t> getBuffer() const && noexcept = delete;
@@ -94,8 +101,33 @@ public:
 
     bool setPixel(Point8880 p, uint32_t rgb) override;
 
+    // Blend rgb over the d sized rectangle at p, using coverage (d.area()
+    // bytes, row after row) as the alpha of each pixel. Returns false if
+    // nothing was drawn.
+
+    bool
+    blendCoverage(
+        Point8880 p,
+        Dimensions8880 d,
+        std::span<const uint8_t> coverage,
+        uint32_t rgb);
+
     bool putImage(Point8880 p, const Interface8880Base& image);
 
+    // Draw image with affine mapping its pixel positions to positions
+    // relative to p, in a single pass. Pixels of image that match the
+    // colour key are left out, and the rest are blended with what is
+    // already there by alpha. Returns false if nothing was drawn.
+
+    bool
+    putImageTransformed(
+        Point8880 p,
+        const Interface8880Base& image,
+        const Affine& affine,
+        Affine::Filter filter = Affine::Filter::BILINEAR,
+        std::optional<uint32_t> colourKey = {},
+        uint8_t alpha = 255);
+
     [[nodiscard]] bool
     validPixel(Point8880 p) const noexcept override
     {
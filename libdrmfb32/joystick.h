@@ -94,6 +94,11 @@ public:
     [[nodiscard]] std::string configurationFile() const noexcept;
 
     [[nodiscard]] int dpadAxes() const noexcept { return m_joystickDpad; }
+
+    // The file descriptor becomes readable when there are joystick events,
+    // call read() when it does.
+
+    [[nodiscard]] int getEventFd() const noexcept { return m_joystickFd.fd(); }
     [[nodiscard]] const std::string& name() const noexcept { return m_name; }
 
     [[nodiscard]] int numberOfButtons() const noexcept;
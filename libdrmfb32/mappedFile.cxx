@@ -0,0 +1,199 @@
+//-------------------------------------------------------------------------
+//
+// The MIT License (MIT)
+//
+// Copyright (c) 2022 Andrew Duncan
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+//-------------------------------------------------------------------------
+
+#include "fileDescriptor.h"
+#include "mappedFile.h"
+
+//-------------------------------------------------------------------------
+
+#include <cerrno>
+#include <stdexcept>
+#include <system_error>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+//=========================================================================
+
+namespace
+{
+
+//-------------------------------------------------------------------------
+
+constexpr std::size_t c_readChunk{64 * 1024};
+
+//-------------------------------------------------------------------------
+
+std::vector<uint8_t>
+readAll(
+    int fd,
+    std::size_t sizeHint)
+{
+    std::vector<uint8_t> buffer;
+    buffer.reserve(sizeHint);
+
+    std::size_t length{};
+
+    for (;;)
+    {
+        if (buffer.size() - length < c_readChunk)
+        {
+            buffer.resize(length + c_readChunk);
+        }
+
+        const auto bytes = ::read(fd, buffer.data() + length, buffer.size() - length);
+
+        if (bytes == 0)
+        {
+            break;
+        }
+        else if (bytes == -1)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+
+            throw std::system_error(errno,
+                                    std::system_category(),
+                                    "reading file");
+        }
+
+        length += bytes;
+    }
+
+    buffer.resize(length);
+
+    return buffer;
+}
+
+//-------------------------------------------------------------------------
+
+}
+
+//=========================================================================
+
+fb32::MappedFile::MappedFile(
+    const std::string& name)
+{
+    fd::FileDescriptor file{::open(name.c_str(), O_RDONLY | O_CLOEXEC)};
+
+    if (file.fd() == -1)
+    {
+        throw std::invalid_argument("cannot open " + name + " for reading");
+    }
+
+    struct stat status{};
+
+    if (::fstat(file.fd(), &status) == -1)
+    {
+        throw std::system_error(errno,
+                                std::system_category(),
+                                "cannot stat " + name);
+    }
+
+    const bool regular = S_ISREG(status.st_mode) and (status.st_size > 0);
+
+    if (regular)
+    {
+        const auto length = static_cast<std::size_t>(status.st_size);
+        auto mapping = ::mmap(nullptr, length, PROT_READ, MAP_PRIVATE, file.fd(), 0);
+
+        if (mapping != MAP_FAILED)
+        {
+            // The decoders read the file once from start to end, so ask
+            // for aggressive read ahead. Failure here only costs speed.
+
+            ::madvise(mapping, length, MADV_SEQUENTIAL);
+            ::madvise(mapping, length, MADV_WILLNEED);
+
+            m_mapping = mapping;
+            m_length = length;
+            m_data = std::span<const uint8_t>(static_cast<const uint8_t*>(mapping), length);
+
+            return;
+        }
+    }
+
+    m_buffer = readAll(file.fd(), regular ? status.st_size : 0);
+    m_data = m_buffer;
+}
+
+//-------------------------------------------------------------------------
+
+fb32::MappedFile::~MappedFile()
+{
+    unmap();
+}
+
+//-------------------------------------------------------------------------
+
+fb32::MappedFile::MappedFile(
+    MappedFile&& rhs) noexcept
+:
+    m_buffer{std::move(rhs.m_buffer)},
+    m_data{std::exchange(rhs.m_data, {})},
+    m_length{std::exchange(rhs.m_length, 0)},
+    m_mapping{std::exchange(rhs.m_mapping, nullptr)}
+{
+}
+
+//-------------------------------------------------------------------------
+
+fb32::MappedFile&
+fb32::MappedFile::operator= (
+    MappedFile&& rhs) noexcept
+{
+    if (this != &rhs)
+    {
+        unmap();
+
+        m_buffer = std::move(rhs.m_buffer);
+        m_data = std::exchange(rhs.m_data, {});
+        m_length = std::exchange(rhs.m_length, 0);
+        m_mapping = std::exchange(rhs.m_mapping, nullptr);
+    }
+
+    return *this;
+}
+
+//-------------------------------------------------------------------------
+
+void
+fb32::MappedFile::unmap() noexcept
+{
+    if (m_mapping)
+    {
+        ::munmap(m_mapping, m_length);
+        m_mapping = nullptr;
+        m_length = 0;
+    }
+}
+
@@ -0,0 +1,81 @@
+//-------------------------------------------------------------------------
+//
+// The MIT License (MIT)
+//
+// Copyright (c) 2022 Andrew Duncan
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+//-------------------------------------------------------------------------
+
+#pragma once
+
+//-------------------------------------------------------------------------
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <vector>
+
+//-------------------------------------------------------------------------
+
+namespace fb32
+{
+
+//-------------------------------------------------------------------------
+//
+// A MappedFile holds the contents of a file for reading. Regular files are
+// mapped into memory, so decoders read straight from the page cache. Pipes
+// and other files that cannot be mapped are read into a buffer instead.
+//
+//-------------------------------------------------------------------------
+
+class MappedFile
+{
+public:
+
+    explicit MappedFile(const std::string& name);
+
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator= (const MappedFile&) = delete;
+
+    MappedFile(MappedFile&& rhs) noexcept;
+    MappedFile& operator= (MappedFile&& rhs) noexcept;
+
+    [[nodiscard]] std::span<const uint8_t> getData() const noexcept { return m_data; }
+    [[nodiscard]] bool isMapped() const noexcept { return m_mapping != nullptr; }
+
+private:
+
+    void unmap() noexcept;
+
+    std::vector<uint8_t> m_buffer{};
+    std::span<const uint8_t> m_data{};
+    std::size_t m_length{};
+    void* m_mapping{};
+};
+
+//-------------------------------------------------------------------------
+
+} // namespace fb32
+
@@ -0,0 +1,177 @@
+//-------------------------------------------------------------------------
+//
+// The MIT License (MIT)
+//
+// Copyright (c) 2022 Andrew Duncan
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+//-------------------------------------------------------------------------
+
+
+#pragma once
+
+//-------------------------------------------------------------------------
+
+#include <atomic>
+#include <cstddef>
+#include <optional>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+//-------------------------------------------------------------------------
+
+namespace fb32
+{
+
+//-------------------------------------------------------------------------
+//
+// A bounded lock-free queue for one producer thread and one consumer
+// thread. It holds small trivially copyable values, typically pointers to
+// buffers that are recycled through a second queue going the other way.
+//
+// pushDropOldest() never fails. When the queue is full the producer takes
+// back the oldest entry and returns it, so that a slow consumer always
+// sees the most recent entries. The consumer and producer race for that
+// entry with a compare and swap on the tail, so exactly one of them gets
+// it.
+//
+//-------------------------------------------------------------------------
+
+template<typename T>
+class SpscQueue
+{
+public:
+
+    static_assert(std::is_trivially_copyable_v<T>);
+
+    explicit SpscQueue(
+        std::size_t capacity)
+    :
+        m_slots(capacity),
+        m_head{0},
+        m_tail{0}
+    {
+        if (capacity == 0)
+        {
+            throw std::invalid_argument("queue capacity must be at least 1");
+        }
+    }
+
+    [[nodiscard]] std::size_t capacity() const noexcept { return m_slots.size(); }
+
+    [[nodiscard]] bool
+    empty() const noexcept
+    {
+        return m_head.load(std::memory_order_acquire) ==
+               m_tail.load(std::memory_order_acquire);
+    }
+
+    // Producer only. Returns false when the queue is full.
+
+    bool
+    push(
+        T value) noexcept
+    {
+        const auto head = m_head.load(std::memory_order_relaxed);
+
+        if ((head - m_tail.load(std::memory_order_acquire)) == capacity())
+        {
+            return false;
+        }
+
+        store(head, value);
+
+        return true;
+    }
+
+    // Producer only. Returns the entry that was dropped to make room.
+
+    std::optional<T>
+    pushDropOldest(
+        T value) noexcept
+    {
+        const auto head = m_head.load(std::memory_order_relaxed);
+        auto tail = m_tail.load(std::memory_order_acquire);
+        std::optional<T> dropped;
+
+        if (((head - tail) == capacity()) and
+            m_tail.compare_exchange_strong(tail,
+                                           tail + 1,
+                                           std::memory_order_acq_rel))
+        {
+            dropped = slot(tail).load(std::memory_order_relaxed);
+        }
+
+        store(head, value);
+
+        return dropped;
+    }
+
+    // Consumer only.
+
+    std::optional<T>
+    pop() noexcept
+    {
+        auto tail = m_tail.load(std::memory_order_acquire);
+
+        while (tail != m_head.load(std::memory_order_acquire))
+        {
+            const auto value = slot(tail).load(std::memory_order_relaxed);
+
+            if (m_tail.compare_exchange_weak(tail,
+                                             tail + 1,
+                                             std::memory_order_acq_rel))
+            {
+                return value;
+            }
+        }
+
+        return {};
+    }
+
+private:
+
+    [[nodiscard]] std::atomic<T>&
+    slot(
+        std::size_t index) noexcept
+    {
+        return m_slots[index % m_slots.size()];
+    }
+
+    void
+    store(
+        std::size_t head,
+        T value) noexcept
+    {
+        slot(head).store(value, std::memory_order_relaxed);
+        m_head.store(head + 1, std::memory_order_release);
+    }
+
+    std::vector<std::atomic<T>> m_slots;
+    std::atomic<std::size_t> m_head;
+    std::atomic<std::size_t> m_tail;
+};
+
+//-------------------------------------------------------------------------
+
+} // namespace fb32
+
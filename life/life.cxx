@@ -202,149 +202,22 @@ Life::init()
 //-------------------------------------------------------------------------
 
 void
-Life::createGosperGliderGun()
+Life::createPattern(
+    const LifePattern& pattern)
 {
-    const int x = (m_size - 36) / 2;
-    const int y = (m_size - 8) / 2;
+    const int x = (m_size - pattern.m_dimensions.width()) / 2;
+    const int y = (m_size - pattern.m_dimensions.height()) / 2;
 
     std::ranges::fill(m_cells, 0);
     std::ranges::fill(m_cellsNext, 0);
     m_image.clear(0);
 
-    setCell(x + 24, y + 0);
-
-    setCell(x + 22, y + 1);
-    setCell(x + 24, y + 1);
-
-    setCell(x + 12, y + 2);
-    setCell(x + 13, y + 2);
-    setCell(x + 20, y + 2);
-    setCell(x + 21, y + 2);
-    setCell(x + 34, y + 2);
-    setCell(x + 35, y + 2);
-
-    setCell(x + 11, y + 3);
-    setCell(x + 15, y + 3);
-    setCell(x + 20, y + 3);
-    setCell(x + 21, y + 3);
-    setCell(x + 34, y + 3);
-    setCell(x + 35, y + 3);
-
-    setCell(x + 0, y + 4);
-    setCell(x + 1, y + 4);
-    setCell(x + 10, y + 4);
-    setCell(x + 16, y + 4);
-    setCell(x + 20, y + 4);
-    setCell(x + 21, y + 4);
-
-    setCell(x + 0, y + 5);
-    setCell(x + 1, y + 5);
-    setCell(x + 10, y + 5);
-    setCell(x + 14, y + 5);
-    setCell(x + 16, y + 5);
-    setCell(x + 17, y + 5);
-    setCell(x + 22, y + 5);
-    setCell(x + 24, y + 5);
-
-    setCell(x + 10, y + 6);
-    setCell(x + 16, y + 6);
-    setCell(x + 24, y + 6);
-
-    setCell(x + 11, y + 7);
-    setCell(x + 15, y + 7);
-
-    setCell(x + 12, y + 8);
-    setCell(x + 13, y + 8);
-
-    m_cells = m_cellsNext;
-}
-
-//-------------------------------------------------------------------------
-
-void
-Life::createSimkinGliderGun()
-{
-    const int x = (m_size - 30) / 2;
-    const int y = (m_size - 20 ) / 2;
-    m_image.clear(0);
-
-    std::ranges::fill(m_cells, 0);
-    std::ranges::fill(m_cellsNext, 0);
-
-    setCell(x + 0, y + 0);
-    setCell(x + 1, y + 0);
-    setCell(x + 7, y + 0);
-    setCell(x + 8, y + 0);
-
-    setCell(x + 0, y + 1);
-    setCell(x + 1, y + 1);
-    setCell(x + 7, y + 1);
-    setCell(x + 8, y + 1);
-
-    setCell(x + 4, y + 3);
-    setCell(x + 5, y + 3);
-
-    setCell(x + 4, y + 4);
-    setCell(x + 5, y + 4);
-
-    setCell(x + 22, y + 9);
-    setCell(x + 23, y + 9);
-    setCell(x + 25, y + 9);
-    setCell(x + 26, y + 9);
-
-    setCell(x + 21, y + 10);
-    setCell(x + 27, y + 10);
-
-    setCell(x + 21, y + 11);
-    setCell(x + 28, y + 11);
-    setCell(x + 31, y + 11);
-    setCell(x + 32, y + 11);
-
-    setCell(x + 21, y + 12);
-    setCell(x + 22, y + 12);
-    setCell(x + 23, y + 12);
-    setCell(x + 27, y + 12);
-    setCell(x + 31, y + 12);
-    setCell(x + 32, y + 12);
-
-    setCell(x + 26, y + 13);
-
-    setCell(x + 20, y + 17);
-    setCell(x + 21, y + 17);
-
-    setCell(x + 20, y + 18);
-
-    setCell(x + 21, y + 19);
-    setCell(x + 22, y + 19);
-    setCell(x + 23, y + 19);
-
-    setCell(x + 23, y + 20);
-
-    m_cells = m_cellsNext;
-}
-
-//-------------------------------------------------------------------------
-
-void
-Life::update(
-    fb32::Joystick& js)
-{
-    if (js.buttonPressed(Joystick::BUTTON_B))
-    {
-        init();
-    }
-    else if (js.buttonPressed(Joystick::BUTTON_X))
-    {
-        createGosperGliderGun();
-    }
-    else if (js.buttonPressed(Joystick::BUTTON_Y))
-    {
-        createSimkinGliderGun();
-    }
-    else
+    for (const auto& cell : pattern.m_cells)
     {
-        iterate();
+        setCell(x + cell.x(), y + cell.y());
     }
+
+    m_cells = m_cellsNext;
 }
 
 //-------------------------------------------------------------------------
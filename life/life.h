@@ -35,7 +35,7 @@
 
 #include "framebuffer8880.h"
 #include "image8880.h"
-#include "joystick.h"
+#include "lifeEngine.h"
 
 #ifdef WITH_BS_THREAD_POOL
 #include "BS_thread_pool.hpp"
@@ -43,7 +43,12 @@
 
 //-------------------------------------------------------------------------
 
-class Life
+// The field as one byte per cell, holding whether the cell is alive and
+// a count of its live neighbours, which is updated as cells change.
+
+class Life final
+:
+    public LifeEngine
 {
 public:
 
@@ -58,19 +63,18 @@ public:
 
     explicit Life(int size);
 
-    void init();
-    void update(fb32::Joystick& js);
-    void draw(fb32::FrameBuffer8880& fb) const;
+    void init() final;
+    void draw(fb32::FrameBuffer8880& fb) const final;
 
 private:
 
+    void createPattern(const LifePattern& pattern) final;
+    void iterate() final;
+
     void updateCell(int col, int row, int value);
     void setCell( int col, int row);
     void clearCell(int col, int row);
-    void createGosperGliderGun();
-    void createSimkinGliderGun();
     void iterateRows(int start, int end);
-    void iterate();
 
     int m_size;
     std::array<uint32_t, 2> m_cellColours;
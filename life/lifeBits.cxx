@@ -0,0 +1,359 @@
+//-------------------------------------------------------------------------
+//
+// The MIT License (MIT)
+//
+// Copyright (c) 2022 Andrew Duncan
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+//-------------------------------------------------------------------------
+
+#include <algorithm>
+#include <array>
+#include <random>
+#include <span>
+#include <utility>
+
+#include "lifeBits.h"
+
+//-------------------------------------------------------------------------
+
+using namespace fb32;
+
+//=========================================================================
+
+namespace
+{
+
+//-------------------------------------------------------------------------
+
+constexpr int c_cellsPerWord{64};
+constexpr int c_topBit{c_cellsPerWord - 1};
+
+//-------------------------------------------------------------------------
+
+// The next state of 64 cells at once, given each of their eight
+// neighbours shifted into line with them.
+
+[[nodiscard]] constexpr uint64_t
+nextGeneration(
+    uint64_t nw,
+    uint64_t n,
+    uint64_t ne,
+    uint64_t w,
+    uint64_t alive,
+    uint64_t e,
+    uint64_t sw,
+    uint64_t s,
+    uint64_t se) noexcept
+{
+    // Add the three cells above and the three below as two bit numbers,
+    // and the two beside as another.
+
+    const auto above0 = nw ^ n ^ ne;
+    const auto above1 = (nw & n) | (ne & (nw ^ n));
+    const auto below0 = sw ^ s ^ se;
+    const auto below1 = (sw & s) | (se & (sw ^ s));
+    const auto beside0 = w ^ e;
+    const auto beside1 = w & e;
+
+    const auto ones = above0 ^ below0 ^ beside0;
+    const auto carry = (above0 & below0) | (beside0 & (above0 ^ below0));
+
+    // The count is ones plus two for each of above1, below1, beside1 and
+    // carry that is set. A cell lives with a count of 3, or with 2 if it
+    // is already alive, which needs exactly one of the four.
+
+    const auto p = above1 ^ below1;
+    const auto q = beside1 ^ carry;
+    const auto pairs = (above1 & below1) | (beside1 & carry) | (p & q);
+    const auto oneTwo = (p ^ q) & ~pairs;
+
+    return oneTwo & (ones | alive);
+}
+
+//-------------------------------------------------------------------------
+
+// Each byte of a word expanded to 8 pixel masks, lowest bit first, so
+// that cells are drawn 8 at a time without testing any bits.
+
+using ByteMask = std::array<uint32_t, 8>;
+
+constexpr auto c_byteMasks = []
+{
+    std::array<ByteMask, 256> masks{};
+
+    for (std::size_t byte = 0 ; byte < masks.size() ; ++byte)
+    {
+        for (std::size_t i = 0 ; i < 8 ; ++i)
+        {
+            masks[byte][i] = ((byte >> i) & 1) ? 0xFFFFFFFF : 0;
+        }
+    }
+
+    return masks;
+}();
+
+//-------------------------------------------------------------------------
+
+// Write count cells from bits into pixels, lowest bit first.
+
+void
+drawWord(
+    uint32_t* pixels,
+    uint64_t bits,
+    int count,
+    uint32_t dead,
+    uint32_t alive) noexcept
+{
+    const auto difference = dead ^ alive;
+
+    for (int x = 0 ; x < count ; x += 8, bits >>= 8)
+    {
+        const ByteMask mask = c_byteMasks[bits & 0xFF];
+        const int n = std::min(8, count - x);
+
+        for (int i = 0 ; i < n ; ++i)
+        {
+            pixels[x + i] = dead ^ (mask[i] & difference);
+        }
+    }
+}
+
+//-------------------------------------------------------------------------
+
+}
+
+//=========================================================================
+
+LifeBits::LifeBits(int size)
+:
+    m_size{size},
+    m_words{(size + c_cellsPerWord - 1) / c_cellsPerWord},
+    m_lastBit{(size - 1) % c_cellsPerWord},
+    m_lastWordMask{~uint64_t{0} >> (c_topBit - m_lastBit)},
+    m_cellColours{
+        0x00000000,
+        0x00FFFFFF
+    },
+    m_cells(m_words * size),
+    m_cellsNext(m_words * size),
+#ifdef WITH_BS_THREAD_POOL
+    m_image(fb32::Dimensions8880{size, size}),
+    m_threadPool()
+#else
+    m_image(fb32::Dimensions8880{size, size})
+#endif
+{
+}
+
+//-------------------------------------------------------------------------
+
+void
+LifeBits::drawRow(
+    int row)
+{
+    const std::span cells{m_cells.data() + (row * m_words), static_cast<std::size_t>(m_words)};
+    auto pixels = m_image.getRow(row);
+
+    for (int word = 0 ; word < m_words ; ++word)
+    {
+        const int x = word * c_cellsPerWord;
+
+        drawWord(pixels.data() + x,
+                 cells[word],
+                 std::min(c_cellsPerWord, m_size - x),
+                 m_cellColours[0],
+                 m_cellColours[1]);
+    }
+}
+
+//-------------------------------------------------------------------------
+
+void
+LifeBits::setCell(
+    int col,
+    int row)
+{
+    const int word = col / c_cellsPerWord;
+    const int bit = col % c_cellsPerWord;
+
+    m_cells[word + (row * m_words)] |= uint64_t{1} << bit;
+
+    const fb32::Point8880 p{ col, row };
+    m_image.setPixel(p, m_cellColours[1]);
+}
+
+//-------------------------------------------------------------------------
+
+void
+LifeBits::iterateRows(
+   int start,
+   int end)
+{
+    const int words = m_words;
+    const int lastBit = m_lastBit;
+
+    for (auto row = start ; row < end ; ++row)
+    {
+        const int above = (row == 0) ? m_size - 1 : row - 1;
+        const int below = (row == m_size - 1) ? 0 : row + 1;
+
+        const auto* up = m_cells.data() + (above * words);
+        const auto* middle = m_cells.data() + (row * words);
+        const auto* down = m_cells.data() + (below * words);
+        auto* next = m_cellsNext.data() + (row * words);
+
+        // The first and last words of a row wrap around to the other end
+        // of the row, so they are done apart from the rest.
+
+        auto west = [=](const uint64_t* cells, int word)
+        {
+            const auto previous = (word == 0)
+                                ? cells[words - 1] << (c_topBit - lastBit)
+                                : cells[word - 1];
+
+            return (cells[word] << 1) | (previous >> c_topBit);
+        };
+
+        auto east = [=](const uint64_t* cells, int word)
+        {
+            if (word == words - 1)
+            {
+                return (cells[word] >> 1) | ((cells[0] & 1) << lastBit);
+            }
+
+            return (cells[word] >> 1) | (cells[word + 1] << c_topBit);
+        };
+
+        auto wrapped = [&](int word)
+        {
+            next[word] = nextGeneration(west(up, word), up[word], east(up, word),
+                                        west(middle, word), middle[word], east(middle, word),
+                                        west(down, word), down[word], east(down, word));
+        };
+
+        wrapped(0);
+
+        for (int word = 1 ; word < words - 1 ; ++word)
+        {
+            next[word] = nextGeneration(
+                (up[word] << 1) | (up[word - 1] >> c_topBit),
+                up[word],
+                (up[word] >> 1) | (up[word + 1] << c_topBit),
+                (middle[word] << 1) | (middle[word - 1] >> c_topBit),
+                middle[word],
+                (middle[word] >> 1) | (middle[word + 1] << c_topBit),
+                (down[word] << 1) | (down[word - 1] >> c_topBit),
+                down[word],
+                (down[word] >> 1) | (down[word + 1] << c_topBit));
+        }
+
+        if (words > 1)
+        {
+            wrapped(words - 1);
+        }
+
+        next[words - 1] &= m_lastWordMask;
+
+        //-----------------------------------------------------------------
+
+        auto pixels = m_image.getRow(row);
+
+        for (int word = 0 ; word < words ; ++word)
+        {
+            if (next[word] != middle[word])
+            {
+                const int x = word * c_cellsPerWord;
+
+                drawWord(pixels.data() + x,
+                         next[word],
+                         std::min(c_cellsPerWord, m_size - x),
+                         m_cellColours[0],
+                         m_cellColours[1]);
+            }
+        }
+    }
+}
+
+//-------------------------------------------------------------------------
+
+void
+LifeBits::iterate()
+{
+#ifdef WITH_BS_THREAD_POOL
+    m_threadPool.detach_blocks<int>(0,
+                                    m_size,
+                                    [this](int start, int end)
+                                    {
+                                        iterateRows(start, end);
+                                    });
+    m_threadPool.wait();
+#else
+    iterateRows(0, m_size);
+#endif
+
+    std::swap(m_cells, m_cellsNext);
+}
+
+//-------------------------------------------------------------------------
+
+void
+LifeBits::init()
+{
+    std::random_device randomDevice;
+    std::mt19937_64 generator(randomDevice());
+
+    std::ranges::generate(m_cells, std::ref(generator));
+
+    for (int row = 0 ; row < m_size ; ++row)
+    {
+        m_cells[(row * m_words) + m_words - 1] &= m_lastWordMask;
+        drawRow(row);
+    }
+}
+
+//-------------------------------------------------------------------------
+
+void
+LifeBits::createPattern(
+    const LifePattern& pattern)
+{
+    const int x = (m_size - pattern.m_dimensions.width()) / 2;
+    const int y = (m_size - pattern.m_dimensions.height()) / 2;
+
+    std::ranges::fill(m_cells, 0);
+    m_image.clear(m_cellColours[0]);
+
+    for (const auto& cell : pattern.m_cells)
+    {
+        setCell(x + cell.x(), y + cell.y());
+    }
+}
+
+//-------------------------------------------------------------------------
+
+void
+LifeBits::draw(
+    fb32::FrameBuffer8880& fb) const
+{
+    fb.putImage(center(fb, m_image), m_image);
+}
+
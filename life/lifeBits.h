@@ -0,0 +1,84 @@
+//-------------------------------------------------------------------------
+//
+// The MIT License (MIT)
+//
+// Copyright (c) 2022 Andrew Duncan
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+//-------------------------------------------------------------------------
+
+#pragma once
+
+//-------------------------------------------------------------------------
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include "framebuffer8880.h"
+#include "image8880.h"
+#include "lifeEngine.h"
+
+#ifdef WITH_BS_THREAD_POOL
+#include "BS_thread_pool.hpp"
+#endif
+
+//-------------------------------------------------------------------------
+
+// The field as bits, 64 cells to a word, with the next generation worked
+// out a word at a time by adding up the neighbours with bitwise logic.
+// Only the words that change are drawn into the image.
+
+class LifeBits final
+:
+    public LifeEngine
+{
+public:
+
+    explicit LifeBits(int size);
+
+    void init() final;
+    void draw(fb32::FrameBuffer8880& fb) const final;
+
+private:
+
+    void createPattern(const LifePattern& pattern) final;
+    void iterate() final;
+
+    void drawRow(int row);
+    void iterateRows(int start, int end);
+    void setCell(int col, int row);
+
+    int m_size;
+    int m_words;
+    int m_lastBit;
+    uint64_t m_lastWordMask;
+    std::array<uint32_t, 2> m_cellColours;
+    std::vector<uint64_t> m_cells;
+    std::vector<uint64_t> m_cellsNext;
+    fb32::Image8880 m_image;
+#ifdef WITH_BS_THREAD_POOL
+    BS::thread_pool m_threadPool;
+#endif
+};
+
+//-------------------------------------------------------------------------
+
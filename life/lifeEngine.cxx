@@ -0,0 +1,102 @@
+//-------------------------------------------------------------------------
+//
+// The MIT License (MIT)
+//
+// Copyright (c) 2022 Andrew Duncan
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+//-------------------------------------------------------------------------
+
+#include <array>
+
+#include "lifeEngine.h"
+
+//-------------------------------------------------------------------------
+
+using namespace fb32;
+
+//=========================================================================
+
+namespace
+{
+
+//-------------------------------------------------------------------------
+
+constexpr std::array<Point8880, 36> c_gosperGliderGun
+{{
+    {24, 0},
+    {22, 1}, {24, 1},
+    {12, 2}, {13, 2}, {20, 2}, {21, 2}, {34, 2}, {35, 2},
+    {11, 3}, {15, 3}, {20, 3}, {21, 3}, {34, 3}, {35, 3},
+    {0, 4}, {1, 4}, {10, 4}, {16, 4}, {20, 4}, {21, 4},
+    {0, 5}, {1, 5}, {10, 5}, {14, 5}, {16, 5}, {17, 5}, {22, 5}, {24, 5},
+    {10, 6}, {16, 6}, {24, 6},
+    {11, 7}, {15, 7},
+    {12, 8}, {13, 8}
+}};
+
+//-------------------------------------------------------------------------
+
+constexpr std::array<Point8880, 36> c_simkinGliderGun
+{{
+    {0, 0}, {1, 0}, {7, 0}, {8, 0},
+    {0, 1}, {1, 1}, {7, 1}, {8, 1},
+    {4, 3}, {5, 3},
+    {4, 4}, {5, 4},
+    {22, 9}, {23, 9}, {25, 9}, {26, 9},
+    {21, 10}, {27, 10},
+    {21, 11}, {28, 11}, {31, 11}, {32, 11},
+    {21, 12}, {22, 12}, {23, 12}, {27, 12}, {31, 12}, {32, 12},
+    {26, 13},
+    {20, 17}, {21, 17},
+    {20, 18},
+    {21, 19}, {22, 19}, {23, 19},
+    {23, 20}
+}};
+
+//-------------------------------------------------------------------------
+
+}
+
+//=========================================================================
+
+void
+LifeEngine::update(
+    Joystick& js)
+{
+    if (js.buttonPressed(Joystick::BUTTON_B))
+    {
+        init();
+    }
+    else if (js.buttonPressed(Joystick::BUTTON_X))
+    {
+        createPattern({Dimensions8880{36, 8}, c_gosperGliderGun});
+    }
+    else if (js.buttonPressed(Joystick::BUTTON_Y))
+    {
+        createPattern({Dimensions8880{30, 20}, c_simkinGliderGun});
+    }
+    else
+    {
+        iterate();
+    }
+}
+
@@ -0,0 +1,79 @@
+//-------------------------------------------------------------------------
+//
+// The MIT License (MIT)
+//
+// Copyright (c) 2022 Andrew Duncan
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+//-------------------------------------------------------------------------
+
+#pragma once
+
+//-------------------------------------------------------------------------
+
+#include <span>
+
+#include "framebuffer8880.h"
+#include "joystick.h"
+#include "point.h"
+
+//-------------------------------------------------------------------------
+
+// A pattern of live cells, placed so that dimensions are centred on the
+// field.
+
+struct LifePattern
+{
+    fb32::Dimensions8880 m_dimensions;
+    std::span<const fb32::Point8880> m_cells;
+};
+
+//-------------------------------------------------------------------------
+
+class LifeEngine
+{
+public:
+
+    LifeEngine() = default;
+    virtual ~LifeEngine() = default;
+
+    LifeEngine(const LifeEngine&) = delete;
+    LifeEngine(LifeEngine&&) = delete;
+    LifeEngine& operator=(const LifeEngine&) = delete;
+    LifeEngine& operator=(LifeEngine&&) = delete;
+
+    // Create a new random arrangement with about half the cells alive.
+
+    virtual void init() = 0;
+
+    void update(fb32::Joystick& js);
+    virtual void draw(fb32::FrameBuffer8880& fb) const = 0;
+
+protected:
+
+    // Clear the field and place pattern in the middle of it.
+
+    virtual void createPattern(const LifePattern& pattern) = 0;
+    virtual void iterate() = 0;
+};
+
+//-------------------------------------------------------------------------
+
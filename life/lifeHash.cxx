@@ -0,0 +1,580 @@
+//-------------------------------------------------------------------------
+//
+// The MIT License (MIT)
+//
+// Copyright (c) 2022 Andrew Duncan
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+//-------------------------------------------------------------------------
+
+#include <algorithm>
+#include <random>
+
+#include "lifeHash.h"
+
+//-------------------------------------------------------------------------
+
+using namespace fb32;
+
+//=========================================================================
+
+namespace
+{
+
+//-------------------------------------------------------------------------
+
+// Collect garbage when there are more nodes than this. If most of them are
+// still in use afterwards, the limit is doubled.
+
+constexpr std::size_t c_nodeLimit{std::size_t{1} << 21};
+
+//-------------------------------------------------------------------------
+
+}
+
+//=========================================================================
+
+std::size_t
+LifeHash::ChildrenHash::operator()(
+    const Children& children) const noexcept
+{
+    auto hash = ((uint64_t{children[0]} << 32) | children[1]) * 0x9E3779B97F4A7C15;
+    hash ^= hash >> 32;
+    hash += ((uint64_t{children[2]} << 32) | children[3]) * 0xC2B2AE3D27D4EB4F;
+    hash ^= hash >> 29;
+
+    return hash;
+}
+
+//=========================================================================
+
+LifeHash::LifeHash(
+    int size,
+    int step)
+:
+    m_cellColours{
+        0x00000000,
+        0x00FFFFFF
+    },
+    m_empty{c_dead},
+    m_free{},
+    m_image(fb32::Dimensions8880{size, size}),
+    m_index{},
+    m_nodeLimit{c_nodeLimit},
+    m_nodes{
+        Node{ {}, 0, c_none },
+        Node{ {}, 0, c_none }
+    },
+    m_root{c_dead},
+    m_size{size},
+    m_step{step}
+{
+    m_root = empty(3);
+}
+
+//-------------------------------------------------------------------------
+
+LifeHash::Index
+LifeHash::build(
+    const std::vector<uint8_t>& cells,
+    int level,
+    int64_t x,
+    int64_t y)
+{
+    const int64_t first = -(m_size / 2);
+    const int64_t last = first + m_size;
+    const int64_t side = int64_t{1} << level;
+
+    if ((x >= last) or (y >= last) or (x + side <= first) or (y + side <= first))
+    {
+        return empty(level);
+    }
+
+    if (level == 0)
+    {
+        return cells[((y - first) * m_size) + (x - first)] ? c_alive : c_dead;
+    }
+
+    const int64_t half = side / 2;
+    const auto nw = build(cells, level - 1, x, y);
+    const auto ne = build(cells, level - 1, x + half, y);
+    const auto sw = build(cells, level - 1, x, y + half);
+    const auto se = build(cells, level - 1, x + half, y + half);
+
+    return join(nw, ne, sw, se);
+}
+
+//-------------------------------------------------------------------------
+
+// The middle half of a node, without moving on in time.
+
+LifeHash::Index
+LifeHash::centre(
+    Index index)
+{
+    const auto [nw, ne, sw, se] = m_nodes[index].m_children;
+
+    return join(m_nodes[nw].m_children[3],
+                m_nodes[ne].m_children[2],
+                m_nodes[sw].m_children[1],
+                m_nodes[se].m_children[0]);
+}
+
+//-------------------------------------------------------------------------
+
+void
+LifeHash::collectGarbage()
+{
+    auto sweep = [this](bool keepResults)
+    {
+        std::vector<bool> marks(m_nodes.size());
+        marks[c_dead] = true;
+        marks[c_alive] = true;
+
+        mark(m_root, marks, keepResults);
+
+        for (const auto index : m_empty)
+        {
+            mark(index, marks, false);
+        }
+
+        m_free.clear();
+        m_index.clear();
+
+        for (Index index = 0 ; index < m_nodes.size() ; ++index)
+        {
+            auto& node = m_nodes[index];
+
+            if (not marks[index])
+            {
+                m_free.push_back(index);
+            }
+            else if (node.m_level > 0)
+            {
+                if (not keepResults)
+                {
+                    node.m_result = c_none;
+                }
+
+                m_index.emplace(node.m_children, index);
+            }
+        }
+    };
+
+    // Try to keep the remembered results first, as they are what makes
+    // repeating patterns fast. If they hold on to too much, forget them.
+
+    sweep(true);
+
+    if (m_index.size() > m_nodeLimit / 2)
+    {
+        sweep(false);
+    }
+
+    if (m_index.size() > m_nodeLimit / 2)
+    {
+        m_nodeLimit *= 2;
+    }
+}
+
+//-------------------------------------------------------------------------
+
+LifeHash::Index
+LifeHash::empty(
+    int level)
+{
+    while (std::ssize(m_empty) <= level)
+    {
+        const auto index = m_empty.back();
+        m_empty.push_back(join(index, index, index, index));
+    }
+
+    return m_empty[level];
+}
+
+//-------------------------------------------------------------------------
+
+// A node twice the size, with the original in the middle.
+
+LifeHash::Index
+LifeHash::expand(
+    Index index)
+{
+    const auto [nw, ne, sw, se] = m_nodes[index].m_children;
+    const auto e = empty(m_nodes[index].m_level - 1);
+
+    return join(join(e, e, e, nw),
+                join(e, e, ne, e),
+                join(e, sw, e, e),
+                join(se, e, e, e));
+}
+
+//-------------------------------------------------------------------------
+
+// Are all the live cells in the middle half of the node?
+
+bool
+LifeHash::isCentred(
+    Index index)
+{
+    const auto e = empty(m_nodes[index].m_level - 2);
+    const auto children = m_nodes[index].m_children;
+
+    for (std::size_t quarter = 0 ; quarter < children.size() ; ++quarter)
+    {
+        const auto& grandchildren = m_nodes[children[quarter]].m_children;
+
+        for (std::size_t i = 0 ; i < grandchildren.size() ; ++i)
+        {
+            if ((i != 3 - quarter) and (grandchildren[i] != e))
+            {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+//-------------------------------------------------------------------------
+
+LifeHash::Index
+LifeHash::join(
+    Index nw,
+    Index ne,
+    Index sw,
+    Index se)
+{
+    const Children children{nw, ne, sw, se};
+
+    if (const auto it = m_index.find(children) ; it != m_index.end())
+    {
+        return it->second;
+    }
+
+    const Node node{children, m_nodes[nw].m_level + 1, c_none};
+    Index index{};
+
+    if (m_free.empty())
+    {
+        index = static_cast<Index>(m_nodes.size());
+        m_nodes.push_back(node);
+    }
+    else
+    {
+        index = m_free.back();
+        m_free.pop_back();
+        m_nodes[index] = node;
+    }
+
+    m_index.emplace(children, index);
+
+    return index;
+}
+
+//-------------------------------------------------------------------------
+
+void
+LifeHash::mark(
+    Index index,
+    std::vector<bool>& marks,
+    bool results) const
+{
+    if (marks[index])
+    {
+        return;
+    }
+
+    marks[index] = true;
+
+    const auto& node = m_nodes[index];
+
+    if (node.m_level > 0)
+    {
+        for (const auto child : node.m_children)
+        {
+            mark(child, marks, results);
+        }
+
+        if (results and (node.m_result != c_none))
+        {
+            mark(node.m_result, marks, results);
+        }
+    }
+}
+
+//-------------------------------------------------------------------------
+
+void
+LifeHash::render()
+{
+    m_image.clear(m_cellColours[0]);
+
+    const auto level = m_nodes[m_root].m_level;
+
+    if (m_root == empty(level))
+    {
+        return;
+    }
+
+    const int64_t half = int64_t{1} << (level - 1);
+    renderNode(m_root, (m_size / 2) - half, (m_size / 2) - half);
+}
+
+//-------------------------------------------------------------------------
+
+// Draw the live cells of a node whose top left corner is at (x, y) on the
+// image, skipping any part of it that is empty or off the image.
+
+void
+LifeHash::renderNode(
+    Index index,
+    int64_t x,
+    int64_t y)
+{
+    const auto& node = m_nodes[index];
+
+    if (node.m_level == 0)
+    {
+        if (index == c_alive)
+        {
+            const Point8880 p{static_cast<int>(x), static_cast<int>(y)};
+            m_image.setPixel(p, m_cellColours[1]);
+        }
+
+        return;
+    }
+
+    const int64_t side = int64_t{1} << node.m_level;
+
+    if ((index == m_empty[node.m_level]) or
+        (x >= m_size) or
+        (y >= m_size) or
+        (x + side <= 0) or
+        (y + side <= 0))
+    {
+        return;
+    }
+
+    const int64_t half = side / 2;
+    const auto [nw, ne, sw, se] = node.m_children;
+
+    renderNode(nw, x, y);
+    renderNode(ne, x + half, y);
+    renderNode(sw, x, y + half);
+    renderNode(se, x + half, y + half);
+}
+
+//-------------------------------------------------------------------------
+
+// The middle half of a node of level k, 2^min(k - 2, step) generations
+// on. It is worked out from the nine overlapping nodes of level k - 1 that
+// make it up: either moved on half the time or just their middles, then
+// the four of level k - 1 made from those are moved on the rest.
+
+LifeHash::Index
+LifeHash::result(
+    Index index)
+{
+    const auto node = m_nodes[index];
+
+    if (node.m_result != c_none)
+    {
+        return node.m_result;
+    }
+
+    if (node.m_level == 2)
+    {
+        const auto next = resultLevel2(index);
+        m_nodes[index].m_result = next;
+
+        return next;
+    }
+
+    const auto [nw, ne, sw, se] = node.m_children;
+    const auto a = m_nodes[nw].m_children;
+    const auto b = m_nodes[ne].m_children;
+    const auto c = m_nodes[sw].m_children;
+    const auto d = m_nodes[se].m_children;
+
+    std::array<Index, 9> parts
+    {
+        nw,
+        join(a[1], b[0], a[3], b[2]),
+        ne,
+        join(a[2], a[3], c[0], c[1]),
+        join(a[3], b[2], c[1], d[0]),
+        join(b[2], b[3], d[0], d[1]),
+        sw,
+        join(c[1], d[0], c[3], d[2]),
+        se
+    };
+
+    const bool fullStep = (node.m_level - 2 <= m_step);
+
+    for (auto& part : parts)
+    {
+        part = (fullStep) ? result(part) : centre(part);
+    }
+
+    const auto next = join(result(join(parts[0], parts[1], parts[3], parts[4])),
+                           result(join(parts[1], parts[2], parts[4], parts[5])),
+                           result(join(parts[3], parts[4], parts[6], parts[7])),
+                           result(join(parts[4], parts[5], parts[7], parts[8])));
+
+    m_nodes[index].m_result = next;
+
+    return next;
+}
+
+//-------------------------------------------------------------------------
+
+// The middle 2x2 cells of a 4x4 node, one generation on.
+
+LifeHash::Index
+LifeHash::resultLevel2(
+    Index index)
+{
+    std::array<std::array<int, 4>, 4> cells{};
+    const auto children = m_nodes[index].m_children;
+
+    for (std::size_t quarter = 0 ; quarter < children.size() ; ++quarter)
+    {
+        const auto& leaves = m_nodes[children[quarter]].m_children;
+
+        for (std::size_t i = 0 ; i < leaves.size() ; ++i)
+        {
+            const auto x = ((quarter & 1) * 2) + (i & 1);
+            const auto y = ((quarter >> 1) * 2) + (i >> 1);
+
+            cells[y][x] = (leaves[i] == c_alive) ? 1 : 0;
+        }
+    }
+
+    auto next = [&cells](int x, int y)
+    {
+        int neighbours = -cells[y][x];
+
+        for (int j = y - 1 ; j <= y + 1 ; ++j)
+        {
+            for (int i = x - 1 ; i <= x + 1 ; ++i)
+            {
+                neighbours += cells[j][i];
+            }
+        }
+
+        return ((neighbours == 3) or ((neighbours == 2) and cells[y][x]))
+             ? c_alive
+             : c_dead;
+    };
+
+    return join(next(1, 1), next(2, 1), next(1, 2), next(2, 2));
+}
+
+//-------------------------------------------------------------------------
+
+// Replace the field with the size x size cells, which are centred on the
+// middle of the universe.
+
+void
+LifeHash::setField(
+    const std::vector<uint8_t>& cells)
+{
+    int level{3};
+
+    while ((int64_t{1} << (level - 1)) < m_size - (m_size / 2))
+    {
+        ++level;
+    }
+
+    const int64_t half = int64_t{1} << (level - 1);
+    m_root = build(cells, level, -half, -half);
+
+    collectGarbage();
+    render();
+}
+
+//-------------------------------------------------------------------------
+
+// Make sure nothing can move out of the middle of the root before the
+// step is done, then the root becomes its own result.
+
+void
+LifeHash::iterate()
+{
+    while ((m_nodes[m_root].m_level < m_step + 2) or (not isCentred(m_root)))
+    {
+        m_root = expand(m_root);
+    }
+
+    m_root = result(expand(m_root));
+
+    if (m_index.size() > m_nodeLimit)
+    {
+        collectGarbage();
+    }
+
+    render();
+}
+
+//-------------------------------------------------------------------------
+
+void
+LifeHash::init()
+{
+    std::random_device randomDevice;
+    std::mt19937 generator(randomDevice());
+    std::uniform_int_distribution<> distribution(0, 1);
+
+    std::vector<uint8_t> cells(m_size * m_size);
+    std::ranges::generate(cells, [&]{ return distribution(generator); });
+
+    setField(cells);
+}
+
+//-------------------------------------------------------------------------
+
+void
+LifeHash::createPattern(
+    const LifePattern& pattern)
+{
+    const int x = (m_size - pattern.m_dimensions.width()) / 2;
+    const int y = (m_size - pattern.m_dimensions.height()) / 2;
+
+    std::vector<uint8_t> cells(m_size * m_size);
+
+    for (const auto& cell : pattern.m_cells)
+    {
+        cells[((y + cell.y()) * m_size) + x + cell.x()] = 1;
+    }
+
+    setField(cells);
+}
+
+//-------------------------------------------------------------------------
+
+void
+LifeHash::draw(
+    fb32::FrameBuffer8880& fb) const
+{
+    fb.putImage(center(fb, m_image), m_image);
+}
+
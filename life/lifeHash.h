@@ -0,0 +1,117 @@
+//-------------------------------------------------------------------------
+//
+// The MIT License (MIT)
+//
+// Copyright (c) 2022 Andrew Duncan
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+//-------------------------------------------------------------------------
+
+#pragma once
+
+//-------------------------------------------------------------------------
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "framebuffer8880.h"
+#include "image8880.h"
+#include "lifeEngine.h"
+
+//-------------------------------------------------------------------------
+
+// An unbounded field held as a quadtree, where identical nodes are shared
+// and each node remembers its future, so regular patterns can be advanced
+// by huge numbers of generations at once (Gosper's HashLife). Each update
+// advances 2^step generations. Only the part of the field that fits on the
+// screen, centred on where the field started, is drawn.
+
+class LifeHash final
+:
+    public LifeEngine
+{
+public:
+
+    static constexpr int c_maxStep{48};
+
+    LifeHash(int size, int step);
+
+    void init() final;
+    void draw(fb32::FrameBuffer8880& fb) const final;
+
+private:
+
+    using Index = uint32_t;
+    using Children = std::array<Index, 4>;
+
+    static constexpr Index c_dead{0};
+    static constexpr Index c_alive{1};
+    static constexpr Index c_none{~Index{0}};
+
+    // The children are north west, north east, south west and south east,
+    // each of level - 1. Level 0 nodes are single cells.
+
+    struct Node
+    {
+        Children m_children;
+        int m_level;
+        Index m_result;
+    };
+
+    struct ChildrenHash
+    {
+        [[nodiscard]] std::size_t operator()(const Children& children) const noexcept;
+    };
+
+    void createPattern(const LifePattern& pattern) final;
+    void iterate() final;
+
+    [[nodiscard]] Index build(const std::vector<uint8_t>& cells, int level, int64_t x, int64_t y);
+    [[nodiscard]] Index centre(Index index);
+    void collectGarbage();
+    [[nodiscard]] Index empty(int level);
+    [[nodiscard]] Index expand(Index index);
+    [[nodiscard]] bool isCentred(Index index);
+    [[nodiscard]] Index join(Index nw, Index ne, Index sw, Index se);
+    void mark(Index index, std::vector<bool>& marks, bool results) const;
+    void render();
+    void renderNode(Index index, int64_t x, int64_t y);
+    [[nodiscard]] Index result(Index index);
+    [[nodiscard]] Index resultLevel2(Index index);
+    void setField(const std::vector<uint8_t>& cells);
+
+    std::array<uint32_t, 2> m_cellColours;
+    std::vector<Index> m_empty;
+    std::vector<Index> m_free;
+    fb32::Image8880 m_image;
+    std::unordered_map<Children, Index, ChildrenHash> m_index;
+    std::size_t m_nodeLimit;
+    std::vector<Node> m_nodes;
+    Index m_root;
+    int m_size;
+    int m_step;
+};
+
+//-------------------------------------------------------------------------
+
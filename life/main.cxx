@@ -32,11 +32,14 @@
 #include <csignal>
 #include <cstring>
 #include <iostream>
+#include <memory>
 #include <print>
 
 #include "framebuffer8880.h"
 #include "joystick.h"
 #include "life.h"
+#include "lifeBits.h"
+#include "lifeHash.h"
 
 //-------------------------------------------------------------------------
 
@@ -78,8 +81,11 @@ printUsage(
     std::println(stream, "");
     std::println(stream, "    --connector,-c - dri connector to use");
     std::println(stream, "    --device,-d - dri device to use");
+    std::println(stream, "    --engine,-e - life engine cells, bits or hash (default cells)");
     std::println(stream, "    --help,-h - print usage and exit");
     std::println(stream, "    --joystick,-j - joystick device");
+    std::println(stream, "    --stats,-s - write frame timing to CSV file and print summary");
+    std::println(stream, "    --step,-S - hash engine advances 2^step generations each frame (default 0)");
     std::println(stream, "");
 }
 
@@ -92,18 +98,24 @@ main(
 {
     uint32_t connector{0};
     std::string device{""};
+    std::string engine{"cells"};
     const std::string program{basename(argv[0])};
     std::string joystick{defaultJoystick};
+    std::string statsFile{""};
+    int step{0};
 
     //---------------------------------------------------------------------
 
-    static const char* sopts = "c:d:hj:";
+    static const char* sopts = "c:d:e:hj:s:S:";
     static option lopts[] =
     {
         { "connector", required_argument, nullptr, 'c' },
         { "device", required_argument, nullptr, 'd' },
+        { "engine", required_argument, nullptr, 'e' },
         { "help", no_argument, nullptr, 'h' },
         { "joystick", required_argument, nullptr, 'j' },
+        { "stats", required_argument, nullptr, 's' },
+        { "step", required_argument, nullptr, 'S' },
         { nullptr, no_argument, nullptr, 0 }
     };
 
@@ -123,6 +135,18 @@ main(
             device = optarg;
             break;
 
+        case 'e':
+
+            engine = optarg;
+
+            if ((engine != "cells") and (engine != "bits") and (engine != "hash"))
+            {
+                std::println(std::cerr, "Error: unknown engine \"{}\"", engine);
+                ::exit(EXIT_FAILURE);
+            }
+
+            break;
+
         case 'h':
 
             printUsage(std::cout, program);
@@ -134,6 +158,23 @@ main(
             joystick = optarg;
             break;
 
+        case 's':
+
+            statsFile = optarg;
+            break;
+
+        case 'S':
+
+            step = std::stoi(optarg);
+
+            if ((step < 0) or (step > LifeHash::c_maxStep))
+            {
+                std::println(std::cerr, "Error: step must be 0 to {}", LifeHash::c_maxStep);
+                ::exit(EXIT_FAILURE);
+            }
+
+            break;
+
         default:
 
             printUsage(std::cerr, program);
@@ -166,13 +207,28 @@ main(
         Joystick js{joystick};
         FrameBuffer8880 fb{device, connector};
         fb.clearBuffers(grey);
+        fb.getStatistics().logCsv(statsFile);
 
         const auto fbd = fb.getDimensions();
         std::println("width = {} height = {}", fbd.width(), fbd.height());
 
-        Life life(fbd.height());
-        life.init();
-        life.draw(fb);
+        std::unique_ptr<LifeEngine> life;
+
+        if (engine == "bits")
+        {
+            life = std::make_unique<LifeBits>(fbd.height());
+        }
+        else if (engine == "hash")
+        {
+            life = std::make_unique<LifeHash>(fbd.height(), step);
+        }
+        else
+        {
+            life = std::make_unique<Life>(fbd.height());
+        }
+
+        life->init();
+        life->draw(fb);
 
         //-----------------------------------------------------------------
 
@@ -186,11 +242,16 @@ main(
             }
             else
             {
-                life.update(js);
-                life.draw(fb);
+                life->update(js);
+                life->draw(fb);
                 fb.update();
             }
         }
+
+        if (not statsFile.empty())
+        {
+            fb.getStatistics().writeSummary(std::cout);
+        }
     }
     catch (std::exception& error)
     {
@@ -28,8 +28,6 @@
 #include <algorithm>
 #include <random>
 
-#include "image8880Process.h"
-
 #include "images.h"
 #include "puzzle.h"
 
@@ -222,14 +220,14 @@ Puzzle::draw(Interface8880Base& fb)
 
     if ((zoom > 1) and m_fitToScreen)
     {
-        const auto zoomed = scaleUp(m_image, zoom);
-        const auto zd = zoomed.getDimensions();
-
-        const int xOffset = (fbd.width() - zd.width()) / 2;
-        const int yOffset = (fbd.height() - zd.height()) / 2;
+        const int xOffset = (fbd.width() - (zoom * id.width())) / 2;
+        const int yOffset = (fbd.height() - (zoom * id.height())) / 2;
 
         const Point8880 p{ xOffset, yOffset };
-        fb.putImage(p, zoomed);
+        fb.putImageTransformed(p,
+                               m_image,
+                               Affine::scale(zoom),
+                               Affine::Filter::NEAREST_NEIGHBOUR);
     }
     else
     {
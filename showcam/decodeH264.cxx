@@ -25,102 +25,10 @@
 //
 //-------------------------------------------------------------------------
 
-#include <algorithm>
 #include <stdexcept>
 
 #include "decodeH264.h"
-
-#ifdef WITH_BS_THREAD_POOL
-#include "BS_thread_pool.hpp"
-#endif
-
-//=========================================================================
-
-namespace {
-
-//-------------------------------------------------------------------------
-
-#ifdef WITH_BS_THREAD_POOL
-
-BS::thread_pool& threadPool()
-{
-    static BS::thread_pool s_threadPool;
-
-    return s_threadPool;
-}
-
-#endif
-
-//-------------------------------------------------------------------------
-
-void
-rowsYuvyToGrey(
-    std::span<const uint8_t> yData,
-    fb32::Image8880& image,
-    std::size_t start,
-    std::size_t end)
-{
-    auto buffer = begin(image.getBuffer()) + start;
-
-    for (std::size_t i = start ; i < end ; ++i)
-    {
-        const auto y = yData[i];
-        const fb32::RGB8880 rgb{ y, y, y };
-        *(buffer++) = rgb.get8880();
-    }
-}
-
-//-------------------------------------------------------------------------
-
-void
-rowsYuvyToRGB(
-    AVFrame* frame,
-    std::span<const uint8_t> yData,
-    std::span<const uint8_t> uData,
-    std::span<const uint8_t> vData,
-    fb32::Image8880& image,
-    std::size_t start,
-    std::size_t end)
-{
-        auto buffer = begin(image.getBuffer()) + start;
-
-        for (std::size_t i = start ; i < end ; i += 2)
-        {
-            const int y1 = yData[i] - 16;
-            const int y2 = yData[i + 1] - 16;
-
-            const auto x = static_cast<std::size_t>(i % frame->width);
-            const auto y = static_cast<std::size_t>(i / frame->width);
-            const std::size_t uvIndex = (x / 2) + (y / 2) * frame->linesize[1];
-            const int u = uData[uvIndex] - 128;
-            const int v = vData[uvIndex] - 128;
-
-            const int y1Part = 1192 * y1;
-            const int y2Part = 1192 * y2;
-
-            const int rPart = 1634 * v;
-            const int gPart = -832 * v - 400 * u;
-            const int bPart = 2066 * u;
-
-            const fb32::RGB8880 rgb1{
-                static_cast<uint8_t>(std::clamp((y1Part + rPart) / 1024, 0, 255)),
-                static_cast<uint8_t>(std::clamp((y1Part + gPart) / 1024, 0, 255)),
-                static_cast<uint8_t>(std::clamp((y1Part + bPart) / 1024, 0, 255))};
-
-            const fb32::RGB8880 rgb2{
-                static_cast<uint8_t>(std::clamp((y2Part + rPart) / 1024, 0, 255)),
-                static_cast<uint8_t>(std::clamp((y2Part + gPart) / 1024, 0, 255)),
-                static_cast<uint8_t>(std::clamp((y2Part + bPart) / 1024, 0, 255))};
-
-            *(buffer++) = rgb1.get8880();
-            *(buffer++) = rgb2.get8880();
-        }
-
-}
-
-//-------------------------------------------------------------------------
-
-};
+#include "image8880Yuv.h"
 
 //=========================================================================
 
@@ -179,7 +87,8 @@ bool
 fb32::DecodeH264::decode(
     const uint8_t* data,
     int length,
-    fb32::Image8880& image,
+    Interface8880Base& image,
+    Point8880 p,
     bool greyscale)
 {
     if (not m_codecContext)
@@ -208,51 +117,51 @@ fb32::DecodeH264::decode(
         return false;
     }
 
-    std::span<const uint8_t> yData{m_frame->data[0], static_cast<std::size_t>(m_frame->linesize[0] * m_frame->height)};
+    const auto format = m_frame->format;
 
-    if (greyscale)
+    if ((format != AV_PIX_FMT_YUV420P) and
+        (format != AV_PIX_FMT_YUVJ420P) and
+        (format != AV_PIX_FMT_NV12))
     {
-#ifdef WITH_BS_THREAD_POOL
-
-        auto& tPool = threadPool();
-
-        auto iterateRows = [&image, &yData](int start, int end)
-        {
-            rowsYuvyToGrey(yData, image, start, end);
-        };
+        return false;
+    }
 
-        tPool.detach_blocks<int>(0, yData.size(), iterateRows);
-        tPool.wait();
+    const auto matrix = (m_frame->colorspace == AVCOL_SPC_BT709)
+                      ? YuvToRGB8880::Matrix::BT709
+                      : YuvToRGB8880::Matrix::BT601;
+    const auto range = ((m_frame->color_range == AVCOL_RANGE_JPEG) or
+                        (format == AV_PIX_FMT_YUVJ420P))
+                     ? YuvToRGB8880::Range::FULL
+                     : YuvToRGB8880::Range::LIMITED;
+    const YuvToRGB8880 yuvToRGB{matrix, range};
 
-#else
+    const Dimensions8880 d{m_frame->width, m_frame->height};
+    const auto chromaHeight = static_cast<std::size_t>((m_frame->height + 1) / 2);
 
-        rowsYuvyToGrey(yData, image, 0, yData.size());
+    auto plane = [this](int index, std::size_t rows) -> YuvPlane
+    {
+        const auto stride = m_frame->linesize[index];
+        return {{m_frame->data[index], stride * rows}, stride};
+    };
 
-#endif
+    const auto yPlane = plane(0, m_frame->height);
 
+    if (greyscale)
+    {
+        yuvToRGB.grey(d, yPlane, 1, image, p);
+    }
+    else if (format == AV_PIX_FMT_NV12)
+    {
+        yuvToRGB.nv12(d, yPlane, plane(1, chromaHeight), image, p);
     }
     else
     {
-        std::span<const uint8_t> uData{m_frame->data[1], static_cast<std::size_t>(m_frame->linesize[1] * (m_frame->height / 2))};
-        std::span<const uint8_t> vData{m_frame->data[2], static_cast<std::size_t>(m_frame->linesize[2] * (m_frame->height / 2))};
-
-#ifdef WITH_BS_THREAD_POOL
-
-        auto& tPool = threadPool();
-
-        auto iterateRows = [this, &image, &uData, &vData, &yData](int start, int end)
-        {
-            rowsYuvyToRGB(m_frame.get(), yData, uData, vData, image, start, end);
-        };
-
-        tPool.detach_blocks<int>(0, yData.size(), iterateRows);
-        tPool.wait();
-
-#else
-
-        rowsYuvyToRGB(m_frame.get(), yData, uData, vData, image, 0, yData.size());
-
-#endif
+        yuvToRGB.i420(d,
+                      yPlane,
+                      plane(1, chromaHeight),
+                      plane(2, chromaHeight),
+                      image,
+                      p);
     }
 
     return true;
@@ -37,7 +37,8 @@ extern "C"
 #include <libavformat/avformat.h>
 }
 
-#include "image8880.h"
+#include "interface8880Base.h"
+#include "point.h"
 
 //-------------------------------------------------------------------------
 
@@ -73,7 +74,8 @@ public:
     bool decode(
         const uint8_t* data,
         int length,
-        Image8880& image,
+        Interface8880Base& image,
+        Point8880 p,
         bool greyscale);
 
     static std::unique_ptr<DecodeH264> create()
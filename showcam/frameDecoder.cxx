@@ -0,0 +1,174 @@
+//-------------------------------------------------------------------------
+//
+// The MIT License (MIT)
+//
+// Copyright (c) 2022 Andrew Duncan
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+//-------------------------------------------------------------------------
+
+
+#include <linux/videodev2.h>
+
+#include <stdexcept>
+
+#include "frameDecoder.h"
+#include "image8880Jpeg.h"
+
+//=========================================================================
+
+namespace
+{
+
+//-------------------------------------------------------------------------
+
+// The largest size with the same aspect ratio as the camera that fits on
+// the screen.
+
+fb32::Dimensions8880
+fit(
+    fb32::Dimensions8880 camera,
+    fb32::Dimensions8880 screen)
+{
+    auto width = (camera.width() * screen.height()) / camera.height();
+    auto height = screen.height();
+
+    if (width > screen.width())
+    {
+        width = screen.width();
+        height = (camera.height() * screen.width()) / camera.width();
+    }
+
+    return {width, height};
+}
+
+//-------------------------------------------------------------------------
+
+} // namespace
+
+//=========================================================================
+
+fb32::FrameDecoder::FrameDecoder(
+    const FrameFormat& format,
+    bool greyscale,
+    bool fitToScreen,
+    Dimensions8880 screen)
+:
+    m_decodeH264{},
+    m_format{format},
+    m_greyscale{greyscale},
+    m_image{},
+    m_output{format.m_dimensions},
+    m_resizePlan{},
+    m_yuvToRGB{format.m_matrix, format.m_range}
+{
+    if (m_format.m_pixelFormat == V4L2_PIX_FMT_H264)
+    {
+        m_decodeH264 = DecodeH264::create();
+    }
+
+    if (fitToScreen and (m_format.m_dimensions != screen))
+    {
+        m_output = fit(m_format.m_dimensions, screen);
+        m_image = Image8880{m_format.m_dimensions};
+        m_resizePlan.emplace(m_format.m_dimensions,
+                             m_output,
+                             ResizePlan::Filter::NEAREST_NEIGHBOUR);
+    }
+}
+
+//-------------------------------------------------------------------------
+
+bool
+fb32::FrameDecoder::decode(
+    const CapturedFrame& frame,
+    Image8880& image)
+{
+    if (image.getDimensions() != m_output)
+    {
+        throw std::invalid_argument("image does not match decoder output");
+    }
+
+    // Without resizing, decode straight into the output image.
+
+    Image8880& target = m_resizePlan ? m_image : image;
+    const std::span<const uint8_t> data{frame.m_data};
+
+    try
+    {
+        switch (m_format.m_pixelFormat)
+        {
+            case V4L2_PIX_FMT_H264:
+
+                if (not m_decodeH264->decode(data.data(),
+                                             data.size(),
+                                             target,
+                                             Point8880{0, 0},
+                                             m_greyscale))
+                {
+                    return false;
+                }
+                break;
+
+            case V4L2_PIX_FMT_MJPEG:
+
+                if (m_greyscale)
+                {
+                    decodeJpegToGrey(target, data);
+                }
+                else
+                {
+                    decodeJpeg(target, data);
+                }
+                break;
+
+            case V4L2_PIX_FMT_YUYV:
+            {
+                const YuvPlane yuyv{data, m_format.m_bytesPerLine};
+
+                if (m_greyscale)
+                {
+                    m_yuvToRGB.grey(m_format.m_dimensions, yuyv, 2, target);
+                }
+                else
+                {
+                    m_yuvToRGB.yuyv(m_format.m_dimensions, yuyv, target);
+                }
+                break;
+            }
+            default:
+
+                return false;
+        }
+    }
+    catch (const std::exception&)
+    {
+        return false;
+    }
+
+    if (m_resizePlan)
+    {
+        m_resizePlan->resize(m_image, image);
+    }
+
+    return true;
+}
+
@@ -0,0 +1,86 @@
+//-------------------------------------------------------------------------
+//
+// The MIT License (MIT)
+//
+// Copyright (c) 2022 Andrew Duncan
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+//-------------------------------------------------------------------------
+
+
+#pragma once
+
+//-------------------------------------------------------------------------
+
+#include <memory>
+#include <optional>
+
+#include "decodeH264.h"
+#include "frameSource.h"
+#include "image8880.h"
+#include "image8880Process.h"
+#include "image8880Yuv.h"
+
+//-------------------------------------------------------------------------
+
+namespace fb32
+{
+
+//-------------------------------------------------------------------------
+
+// Turns captured frames into images, resized to fit the screen when
+// requested. Owned and used by a single thread.
+
+class FrameDecoder
+{
+public:
+
+    FrameDecoder(
+        const FrameFormat& format,
+        bool greyscale,
+        bool fitToScreen,
+        Dimensions8880 screen);
+
+    [[nodiscard]] Dimensions8880 getOutputDimensions() const noexcept
+    {
+        return m_output;
+    }
+
+    // image must have the output dimensions.
+
+    bool decode(const CapturedFrame& frame, Image8880& image);
+
+private:
+
+    std::unique_ptr<DecodeH264> m_decodeH264;
+    FrameFormat m_format;
+    bool m_greyscale;
+    Image8880 m_image;
+    Dimensions8880 m_output;
+    std::optional<ResizePlan> m_resizePlan;
+    YuvToRGB8880 m_yuvToRGB;
+};
+
+//-------------------------------------------------------------------------
+
+} // namespace fb32
+
+//-------------------------------------------------------------------------
@@ -0,0 +1,108 @@
+//-------------------------------------------------------------------------
+//
+// The MIT License (MIT)
+//
+// Copyright (c) 2022 Andrew Duncan
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+//-------------------------------------------------------------------------
+
+
+#pragma once
+
+//-------------------------------------------------------------------------
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "image8880Yuv.h"
+#include "interface8880.h"
+
+//-------------------------------------------------------------------------
+
+namespace fb32
+{
+
+//-------------------------------------------------------------------------
+
+// What a frame source produces: a V4L2 pixel format (YUYV, MJPG or H264),
+// the frame rate if known and, for YUYV, the row length and colour
+// encoding.
+
+struct FrameFormat
+{
+    uint32_t m_pixelFormat{};
+    std::string m_name{};
+    Dimensions8880 m_dimensions{};
+    int m_bytesPerLine{};
+    int m_fps{};
+    YuvToRGB8880::Matrix m_matrix{YuvToRGB8880::Matrix::BT601};
+    YuvToRGB8880::Range m_range{YuvToRGB8880::Range::LIMITED};
+};
+
+//-------------------------------------------------------------------------
+
+struct CapturedFrame
+{
+    std::vector<uint8_t> m_data{};
+    std::chrono::steady_clock::time_point m_captured{};
+};
+
+//-------------------------------------------------------------------------
+
+class FrameSource
+{
+public:
+
+    FrameSource() = default;
+    virtual ~FrameSource() = default;
+
+    FrameSource(const FrameSource&) = delete;
+    FrameSource(FrameSource&&) = delete;
+    FrameSource& operator=(const FrameSource&) = delete;
+    FrameSource& operator=(FrameSource&&) = delete;
+
+    enum class Result
+    {
+        FRAME,
+        TIMEOUT,
+        FINISHED
+    };
+
+    [[nodiscard]] virtual const FrameFormat& getFormat() const noexcept = 0;
+
+    // Wait up to timeout for the next frame and copy it into frame.
+
+    virtual Result
+    capture(
+        CapturedFrame& frame,
+        std::chrono::milliseconds timeout) = 0;
+
+    virtual bool startStream() = 0;
+    virtual bool stopStream() = 0;
+};
+
+//-------------------------------------------------------------------------
+
+} // namespace fb32
+
@@ -0,0 +1,408 @@
+//-------------------------------------------------------------------------
+//
+// The MIT License (MIT)
+//
+// Copyright (c) 2022 Andrew Duncan
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+//-------------------------------------------------------------------------
+
+
+#include <print>
+
+#include "pipeline.h"
+
+//=========================================================================
+
+void
+fb32::StageStatistics::addFrame(
+    Clock::duration busy) noexcept
+{
+    const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(busy).count();
+
+    m_busyNs += ns;
+    ++m_frames;
+
+    auto maximum = m_maximumNs.load();
+
+    while ((ns > maximum) and not m_maximumNs.compare_exchange_weak(maximum, ns))
+    {
+    }
+}
+
+//-------------------------------------------------------------------------
+
+std::chrono::microseconds
+fb32::StageStatistics::getMaximum() const noexcept
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::nanoseconds(m_maximumNs.load()));
+}
+
+//-------------------------------------------------------------------------
+
+std::chrono::microseconds
+fb32::StageStatistics::getMean() const noexcept
+{
+    const auto frames = m_frames.load();
+
+    if (frames == 0)
+    {
+        return std::chrono::microseconds{0};
+    }
+
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::nanoseconds(m_busyNs.load() / static_cast<int64_t>(frames)));
+}
+
+//=========================================================================
+
+fb32::Pipeline::Pipeline(
+    FrameSource& source,
+    FrameDecoder& decoder,
+    const std::string& recording)
+:
+    m_source{source},
+    m_decoder{decoder},
+    m_recorder{},
+    m_capturedFrames(c_queueLength + 2),
+    m_captured{c_queueLength},
+    m_capturedFree{m_capturedFrames.size()},
+    m_capturedReady{0},
+    m_decodedFrames{},
+    m_decoded{c_queueLength},
+    m_decodedFree{c_queueLength + 2},
+    m_decodedReady{0},
+    m_captureFinished{false},
+    m_decodeFinished{false},
+    m_captureError{},
+    m_decodeError{},
+    m_captureStatistics{},
+    m_decodeStatistics{},
+    m_presentStatistics{},
+    m_latencyStatistics{},
+    m_captureThread{},
+    m_decodeThread{}
+{
+    if (not recording.empty())
+    {
+        m_recorder.emplace(recording, m_source.getFormat());
+    }
+
+    // Each stage holds one buffer and each queue at most c_queueLength,
+    // so there is always a free buffer for a stage to fill next.
+
+    for (auto& frame : m_capturedFrames)
+    {
+        m_capturedFree.push(&frame);
+    }
+
+    const auto d = m_decoder.getOutputDimensions();
+    m_decodedFrames.reserve(c_queueLength + 2);
+
+    for (std::size_t i = 0 ; i < c_queueLength + 2 ; ++i)
+    {
+        auto& frame = m_decodedFrames.emplace_back(Image8880{d}, Clock::time_point{});
+        m_decodedFree.push(&frame);
+    }
+}
+
+//-------------------------------------------------------------------------
+
+fb32::Pipeline::~Pipeline()
+{
+    stop();
+}
+
+//-------------------------------------------------------------------------
+
+void
+fb32::Pipeline::start()
+{
+    m_source.startStream();
+
+    m_captureThread = std::jthread([this](std::stop_token stopToken)
+    {
+        captureLoop(stopToken);
+    });
+
+    m_decodeThread = std::jthread([this](std::stop_token stopToken)
+    {
+        decodeLoop(stopToken);
+    });
+}
+
+//-------------------------------------------------------------------------
+
+void
+fb32::Pipeline::stop()
+{
+    if (not m_captureThread.joinable())
+    {
+        return;
+    }
+
+    m_captureThread.request_stop();
+    m_decodeThread.request_stop();
+    m_capturedReady.release();
+
+    m_captureThread.join();
+    m_decodeThread.join();
+
+    m_source.stopStream();
+}
+
+//-------------------------------------------------------------------------
+
+bool
+fb32::Pipeline::present(
+    FrameBuffer8880& fb)
+{
+    // Take the newest decoded frame, returning any older ones unshown.
+
+    auto newest = [this]() -> DecodedFrame*
+    {
+        DecodedFrame* frame{nullptr};
+
+        while (auto next = m_decoded.pop())
+        {
+            if (frame)
+            {
+                m_decodedFree.push(frame);
+                m_decodeStatistics.addDropped();
+            }
+
+            frame = *next;
+        }
+
+        return frame;
+    };
+
+    auto* frame = newest();
+
+    if (frame == nullptr)
+    {
+        if (m_decodeFinished)
+        {
+            if (m_decodeError)
+            {
+                std::rethrow_exception(m_decodeError);
+            }
+
+            if (m_captureError)
+            {
+                std::rethrow_exception(m_captureError);
+            }
+
+            return not m_decoded.empty();
+        }
+
+        (void)m_decodedReady.try_acquire_for(c_timeout);
+        frame = newest();
+
+        if (frame == nullptr)
+        {
+            return true;
+        }
+    }
+
+    const auto start = Clock::now();
+
+    fb.acquireBackBuffer();
+    fb.putImage(center(fb, frame->m_image), frame->m_image);
+    fb.present();
+
+    const auto end = Clock::now();
+    m_presentStatistics.addFrame(end - start);
+    m_latencyStatistics.addFrame(end - frame->m_captured);
+
+    m_decodedFree.push(frame);
+
+    return true;
+}
+
+//-------------------------------------------------------------------------
+
+void
+fb32::Pipeline::writeSummary(
+    std::ostream& stream) const
+{
+    auto line = [&stream](std::string_view name, const StageStatistics& stage)
+    {
+        std::println(stream,
+                     "{:<8} {:>8} frames {:>6} dropped {:>6} failed"
+                     " {:>8.2f} ms mean {:>8.2f} ms max",
+                     name,
+                     stage.getFrames(),
+                     stage.getDropped(),
+                     stage.getFailed(),
+                     stage.getMean().count() / 1000.0,
+                     stage.getMaximum().count() / 1000.0);
+    };
+
+    line("capture", m_captureStatistics);
+    line("decode", m_decodeStatistics);
+    line("present", m_presentStatistics);
+    line("latency", m_latencyStatistics);
+}
+
+//-------------------------------------------------------------------------
+
+template<typename T>
+T*
+fb32::Pipeline::takeFree(
+    SpscQueue<T*>& free,
+    std::stop_token stopToken)
+{
+    // There is always a free buffer once the other stage has finished
+    // with it, so this only spins briefly if at all.
+
+    while (not stopToken.stop_requested())
+    {
+        if (auto buffer = free.pop())
+        {
+            return *buffer;
+        }
+
+        std::this_thread::yield();
+    }
+
+    return nullptr;
+}
+
+//-------------------------------------------------------------------------
+
+void
+fb32::Pipeline::captureLoop(
+    std::stop_token stopToken)
+{
+    try
+    {
+        auto* frame = takeFree(m_capturedFree, stopToken);
+
+        while (frame and not stopToken.stop_requested())
+        {
+            const auto start = Clock::now();
+            const auto result = m_source.capture(*frame, c_timeout);
+
+            if (result == FrameSource::Result::FINISHED)
+            {
+                break;
+            }
+
+            if (result == FrameSource::Result::TIMEOUT)
+            {
+                continue;
+            }
+
+            if (m_recorder)
+            {
+                m_recorder->write(*frame);
+            }
+
+            m_captureStatistics.addFrame(Clock::now() - start);
+
+            const auto dropped = m_captured.pushDropOldest(frame);
+            m_capturedReady.release();
+
+            if (dropped)
+            {
+                m_captureStatistics.addDropped();
+                frame = *dropped;
+            }
+            else
+            {
+                frame = takeFree(m_capturedFree, stopToken);
+            }
+        }
+    }
+    catch (...)
+    {
+        m_captureError = std::current_exception();
+    }
+
+    m_captureFinished = true;
+    m_capturedReady.release();
+}
+
+//-------------------------------------------------------------------------
+
+void
+fb32::Pipeline::decodeLoop(
+    std::stop_token stopToken)
+{
+    try
+    {
+        auto* image = takeFree(m_decodedFree, stopToken);
+
+        while (image and not stopToken.stop_requested())
+        {
+            const auto captured = m_captured.pop();
+
+            if (not captured)
+            {
+                if (m_captureFinished)
+                {
+                    break;
+                }
+
+                (void)m_capturedReady.try_acquire_for(c_timeout);
+                continue;
+            }
+
+            const auto start = Clock::now();
+            auto* frame = *captured;
+            const auto decoded = m_decoder.decode(*frame, image->m_image);
+            image->m_captured = frame->m_captured;
+
+            m_capturedFree.push(frame);
+
+            if (not decoded)
+            {
+                m_decodeStatistics.addFailed();
+                continue;
+            }
+
+            m_decodeStatistics.addFrame(Clock::now() - start);
+
+            const auto dropped = m_decoded.pushDropOldest(image);
+            m_decodedReady.release();
+
+            if (dropped)
+            {
+                m_decodeStatistics.addDropped();
+                image = *dropped;
+            }
+            else
+            {
+                image = takeFree(m_decodedFree, stopToken);
+            }
+        }
+    }
+    catch (...)
+    {
+        m_decodeError = std::current_exception();
+    }
+
+    m_decodeFinished = true;
+    m_decodedReady.release();
+}
+
@@ -0,0 +1,180 @@
+//-------------------------------------------------------------------------
+//
+// The MIT License (MIT)
+//
+// Copyright (c) 2022 Andrew Duncan
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+//-------------------------------------------------------------------------
+
+
+#pragma once
+
+//-------------------------------------------------------------------------
+
+#include <atomic>
+#include <chrono>
+#include <exception>
+#include <optional>
+#include <ostream>
+#include <semaphore>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "frameDecoder.h"
+#include "frameSource.h"
+#include "framebuffer8880.h"
+#include "image8880.h"
+#include "replay.h"
+#include "spscQueue.h"
+
+//-------------------------------------------------------------------------
+
+namespace fb32
+{
+
+//-------------------------------------------------------------------------
+
+// Counters for one stage, updated by the stage's thread and read by any.
+
+class StageStatistics
+{
+public:
+
+    using Clock = std::chrono::steady_clock;
+
+    void addFrame(Clock::duration busy) noexcept;
+    void addDropped() noexcept { ++m_dropped; }
+    void addFailed() noexcept { ++m_failed; }
+
+    [[nodiscard]] uint64_t getFrames() const noexcept { return m_frames; }
+    [[nodiscard]] uint64_t getDropped() const noexcept { return m_dropped; }
+    [[nodiscard]] uint64_t getFailed() const noexcept { return m_failed; }
+    [[nodiscard]] std::chrono::microseconds getMaximum() const noexcept;
+    [[nodiscard]] std::chrono::microseconds getMean() const noexcept;
+
+private:
+
+    std::atomic<int64_t> m_busyNs{};
+    std::atomic<uint64_t> m_dropped{};
+    std::atomic<uint64_t> m_failed{};
+    std::atomic<uint64_t> m_frames{};
+    std::atomic<int64_t> m_maximumNs{};
+};
+
+//-------------------------------------------------------------------------
+//
+// Runs capture and decode on their own threads, with the caller presenting
+// the decoded images. The stages are connected by lock-free queues of
+// recycled buffers. When a stage falls behind, the oldest queued frame is
+// dropped, and the presenter always shows the newest decoded frame, so
+// that the displayed latency stays bounded.
+//
+//   capture thread -> captured queue -> decode thread -> decoded queue -> present()
+//
+//-------------------------------------------------------------------------
+
+class Pipeline
+{
+public:
+
+    using Clock = std::chrono::steady_clock;
+
+    static constexpr std::size_t c_queueLength{2};
+
+    Pipeline(
+        FrameSource& source,
+        FrameDecoder& decoder,
+        const std::string& recording = "");
+
+    ~Pipeline();
+
+    Pipeline(const Pipeline&) = delete;
+    Pipeline(Pipeline&&) = delete;
+    Pipeline& operator=(const Pipeline&) = delete;
+    Pipeline& operator=(Pipeline&&) = delete;
+
+    void start();
+    void stop();
+
+    // Show the newest decoded frame, waiting a short while for one if
+    // necessary. Returns false once the source has finished and every
+    // frame has been shown. Rethrows any exception from the other stages.
+
+    bool present(FrameBuffer8880& fb);
+
+    [[nodiscard]] const StageStatistics& getCapture() const noexcept { return m_captureStatistics; }
+    [[nodiscard]] const StageStatistics& getDecode() const noexcept { return m_decodeStatistics; }
+    [[nodiscard]] const StageStatistics& getPresent() const noexcept { return m_presentStatistics; }
+    [[nodiscard]] const StageStatistics& getLatency() const noexcept { return m_latencyStatistics; }
+
+    void writeSummary(std::ostream& stream) const;
+
+private:
+
+    struct DecodedFrame
+    {
+        Image8880 m_image;
+        Clock::time_point m_captured;
+    };
+
+    void captureLoop(std::stop_token stopToken);
+    void decodeLoop(std::stop_token stopToken);
+
+    template<typename T>
+    T* takeFree(SpscQueue<T*>& free, std::stop_token stopToken);
+
+    static constexpr std::chrono::milliseconds c_timeout{100};
+
+    FrameSource& m_source;
+    FrameDecoder& m_decoder;
+    std::optional<FrameRecorder> m_recorder;
+
+    std::vector<CapturedFrame> m_capturedFrames;
+    SpscQueue<CapturedFrame*> m_captured;
+    SpscQueue<CapturedFrame*> m_capturedFree;
+    std::counting_semaphore<> m_capturedReady;
+
+    std::vector<DecodedFrame> m_decodedFrames;
+    SpscQueue<DecodedFrame*> m_decoded;
+    SpscQueue<DecodedFrame*> m_decodedFree;
+    std::counting_semaphore<> m_decodedReady;
+
+    std::atomic<bool> m_captureFinished;
+    std::atomic<bool> m_decodeFinished;
+    std::exception_ptr m_captureError;
+    std::exception_ptr m_decodeError;
+
+    StageStatistics m_captureStatistics;
+    StageStatistics m_decodeStatistics;
+    StageStatistics m_presentStatistics;
+    StageStatistics m_latencyStatistics;
+
+    std::jthread m_captureThread;
+    std::jthread m_decodeThread;
+};
+
+//-------------------------------------------------------------------------
+
+} // namespace fb32
+
+//-------------------------------------------------------------------------
@@ -0,0 +1,238 @@
+//-------------------------------------------------------------------------
+//
+// The MIT License (MIT)
+//
+// Copyright (c) 2022 Andrew Duncan
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+//-------------------------------------------------------------------------
+
+
+#include <algorithm>
+#include <array>
+#include <optional>
+#include <stdexcept>
+#include <string_view>
+#include <thread>
+
+#include "replay.h"
+
+//=========================================================================
+
+namespace
+{
+
+//-------------------------------------------------------------------------
+
+constexpr std::string_view c_signature{"SHOWCAM1"};
+constexpr int c_defaultFPS{30};
+
+//-------------------------------------------------------------------------
+
+void
+writeUint32(
+    std::ostream& stream,
+    uint32_t value)
+{
+    const std::array<char, 4> bytes{static_cast<char>(value & 0xFF),
+                                    static_cast<char>((value >> 8) & 0xFF),
+                                    static_cast<char>((value >> 16) & 0xFF),
+                                    static_cast<char>((value >> 24) & 0xFF)};
+
+    stream.write(bytes.data(), bytes.size());
+}
+
+//-------------------------------------------------------------------------
+
+std::optional<uint32_t>
+readUint32(
+    std::istream& stream)
+{
+    std::array<unsigned char, 4> bytes{};
+
+    if (not stream.read(reinterpret_cast<char*>(bytes.data()), bytes.size()))
+    {
+        return {};
+    }
+
+    return bytes[0] | (bytes[1] << 8) | (bytes[2] << 16) | (bytes[3] << 24);
+}
+
+//-------------------------------------------------------------------------
+
+} // namespace
+
+//=========================================================================
+
+fb32::FrameRecorder::FrameRecorder(
+    const std::string& name,
+    const FrameFormat& format)
+:
+    m_stream{name, std::ios_base::binary}
+{
+    if (not m_stream)
+    {
+        throw std::invalid_argument("cannot create recording " + name);
+    }
+
+    m_stream.write(c_signature.data(), c_signature.size());
+
+    for (const auto value : { format.m_pixelFormat,
+                              static_cast<uint32_t>(format.m_dimensions.width()),
+                              static_cast<uint32_t>(format.m_dimensions.height()),
+                              static_cast<uint32_t>(format.m_bytesPerLine),
+                              static_cast<uint32_t>(format.m_fps),
+                              static_cast<uint32_t>(format.m_matrix),
+                              static_cast<uint32_t>(format.m_range) })
+    {
+        writeUint32(m_stream, value);
+    }
+}
+
+//-------------------------------------------------------------------------
+
+void
+fb32::FrameRecorder::write(
+    const CapturedFrame& frame)
+{
+    writeUint32(m_stream, frame.m_data.size());
+    m_stream.write(reinterpret_cast<const char*>(frame.m_data.data()),
+                   frame.m_data.size());
+}
+
+//=========================================================================
+
+fb32::ReplaySource::ReplaySource(
+    const std::string& name,
+    int requestedFPS)
+:
+    m_format{},
+    m_next{},
+    m_period{},
+    m_stream{name, std::ios_base::binary}
+{
+    if (not m_stream)
+    {
+        throw std::invalid_argument("cannot open recording " + name);
+    }
+
+    std::array<char, c_signature.size()> signature{};
+    m_stream.read(signature.data(), signature.size());
+
+    if (std::string_view{signature.data(), signature.size()} != c_signature)
+    {
+        throw std::invalid_argument(name + " is not a showcam recording");
+    }
+
+    std::array<uint32_t, 7> header{};
+
+    for (auto& value : header)
+    {
+        const auto read = readUint32(m_stream);
+
+        if (not read)
+        {
+            throw std::invalid_argument(name + " has a truncated header");
+        }
+
+        value = *read;
+    }
+
+    const auto [pixelFormat, width, height, bytesPerLine, fps, matrix, range] = header;
+
+    if ((width == 0) or (height == 0) or (matrix > 1) or (range > 1))
+    {
+        throw std::invalid_argument(name + " has an invalid header");
+    }
+
+    m_format.m_pixelFormat = pixelFormat;
+    m_format.m_name = std::string{static_cast<char>(pixelFormat & 0xFF),
+                                  static_cast<char>((pixelFormat >> 8) & 0xFF),
+                                  static_cast<char>((pixelFormat >> 16) & 0xFF),
+                                  static_cast<char>((pixelFormat >> 24) & 0xFF)} +
+                      " replay";
+    m_format.m_dimensions = Dimensions8880(width, height);
+    m_format.m_bytesPerLine = bytesPerLine;
+    m_format.m_fps = (requestedFPS > 0) ? requestedFPS
+                   : (fps > 0) ? static_cast<int>(fps)
+                   : c_defaultFPS;
+    m_format.m_matrix = static_cast<YuvToRGB8880::Matrix>(matrix);
+    m_format.m_range = static_cast<YuvToRGB8880::Range>(range);
+
+    m_period = std::chrono::duration_cast<Clock::duration>(std::chrono::seconds(1)) /
+               m_format.m_fps;
+}
+
+//-------------------------------------------------------------------------
+
+fb32::FrameSource::Result
+fb32::ReplaySource::capture(
+    CapturedFrame& frame,
+    std::chrono::milliseconds timeout)
+{
+    const auto now = Clock::now();
+
+    if ((m_next - now) > timeout)
+    {
+        std::this_thread::sleep_for(timeout);
+        return Result::TIMEOUT;
+    }
+
+    std::this_thread::sleep_until(m_next);
+
+    const auto length = readUint32(m_stream);
+
+    if (not length)
+    {
+        return Result::FINISHED;
+    }
+
+    frame.m_data.resize(*length);
+
+    if (not m_stream.read(reinterpret_cast<char*>(frame.m_data.data()),
+                          frame.m_data.size()))
+    {
+        return Result::FINISHED;
+    }
+
+    frame.m_captured = Clock::now();
+    m_next = std::max(m_next + m_period, frame.m_captured - m_period);
+
+    return Result::FRAME;
+}
+
+//-------------------------------------------------------------------------
+
+bool
+fb32::ReplaySource::startStream()
+{
+    m_next = Clock::now();
+    return true;
+}
+
+//-------------------------------------------------------------------------
+
+bool
+fb32::ReplaySource::stopStream()
+{
+    return true;
+}
+
@@ -0,0 +1,110 @@
+//-------------------------------------------------------------------------
+//
+// The MIT License (MIT)
+//
+// Copyright (c) 2022 Andrew Duncan
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+//-------------------------------------------------------------------------
+
+
+#pragma once
+
+//-------------------------------------------------------------------------
+
+#include <chrono>
+#include <fstream>
+#include <string>
+
+#include "frameSource.h"
+
+//-------------------------------------------------------------------------
+
+namespace fb32
+{
+
+//-------------------------------------------------------------------------
+//
+// A recording is the 8 byte signature "SHOWCAM1", then the frame format
+// as seven little endian 32 bit values (V4L2 pixel format, width, height,
+// bytes per line, frames per second, matrix and range), then each frame
+// as a 32 bit length followed by the frame data as captured.
+//
+//-------------------------------------------------------------------------
+
+class FrameRecorder
+{
+public:
+
+    FrameRecorder(
+        const std::string& name,
+        const FrameFormat& format);
+
+    void write(const CapturedFrame& frame);
+
+private:
+
+    std::ofstream m_stream;
+};
+
+//-------------------------------------------------------------------------
+
+// Plays back a recording at its recorded frame rate (or the one asked
+// for), so that showcam can be run without a camera.
+
+class ReplaySource
+:
+    public FrameSource
+{
+public:
+
+    ReplaySource(
+        const std::string& name,
+        int requestedFPS);
+
+    [[nodiscard]] const FrameFormat& getFormat() const noexcept override
+    {
+        return m_format;
+    }
+
+    Result
+    capture(
+        CapturedFrame& frame,
+        std::chrono::milliseconds timeout) override;
+
+    bool startStream() override;
+    bool stopStream() override;
+
+private:
+
+    using Clock = std::chrono::steady_clock;
+
+    FrameFormat m_format;
+    Clock::time_point m_next;
+    Clock::duration m_period;
+    std::ifstream m_stream;
+};
+
+//-------------------------------------------------------------------------
+
+} // namespace fb32
+
+//-------------------------------------------------------------------------
@@ -33,10 +33,14 @@
 #include <csignal>
 #include <cstring>
 #include <iostream>
+#include <memory>
 #include <print>
 #include <thread>
 
+#include "frameDecoder.h"
 #include "framebuffer8880.h"
+#include "pipeline.h"
+#include "replay.h"
 #include "webcam.h"
 
 //-------------------------------------------------------------------------
@@ -84,6 +88,9 @@ printUsage(
     std::println(stream,"    --greyscale,-g - convert to greyscale");
     std::println(stream,"    --help,-h - print usage and exit");
     std::println(stream,"    --pixelFormat,-p - pixel format to use (YUYV, MJPG or H264)");
+    std::println(stream,"    --record,-R - record the captured frames to a file");
+    std::println(stream,"    --replay,-r - replay frames from a recorded file");
+    std::println(stream,"    --stats,-s - write frame timing to CSV file and print summary");
     std::println(stream,"    --videodevice,-v - video device to use");
     std::println(stream, "");
 }
@@ -101,12 +108,15 @@ main(
     bool fitToScreen{false};
     bool greyscale{false};
     std::string pixelFormat{""};
+    std::string recordFile{""};
+    std::string replayFile{""};
     int requestedFPS{0};
+    std::string statsFile{""};
     std::string videoDevice{"/dev/video0"};
 
     //---------------------------------------------------------------------
 
-    static const char* sopts = "F:c:d:fhv:gp:";
+    static const char* sopts = "F:R:c:d:fhv:gp:r:s:";
     static option lopts[] =
     {
         { "FPS", no_argument, NULL, 'F' },
@@ -117,6 +127,9 @@ main(
         { "videodevice", required_argument, NULL, 'v' },
         { "greyscale", no_argument, NULL, 'g' },
         { "pixelFormat", required_argument, NULL, 'p' },
+        { "record", required_argument, nullptr, 'R' },
+        { "replay", required_argument, nullptr, 'r' },
+        { "stats", required_argument, nullptr, 's' },
         { nullptr, no_argument, nullptr, 0 }
     };
 
@@ -131,6 +144,11 @@ main(
             requestedFPS = std::stol(optarg);
             break;
 
+        case 'R':
+
+            recordFile = optarg;
+            break;
+
         case 'c':
 
             connector = std::stol(optarg);
@@ -162,6 +180,16 @@ main(
             pixelFormat = optarg;
             break;
 
+        case 'r':
+
+            replayFile = optarg;
+            break;
+
+        case 's':
+
+            statsFile = optarg;
+            break;
+
         case 'v':
 
             videoDevice = optarg;
@@ -198,25 +226,51 @@ main(
 
     try
     {
-        FrameBuffer8880 fb(device, connector);
-        Webcam wc(videoDevice, fitToScreen, greyscale, requestedFPS, fb, pixelFormat);
+        // a third buffer lets the next frame be decoded while the last
+        // one waits for the vertical blank
+
+        constexpr int bufferCount{3};
+        FrameBuffer8880 fb(device, connector, bufferCount);
+
+        std::unique_ptr<FrameSource> source;
+
+        if (replayFile.empty())
+        {
+            source = std::make_unique<Webcam>(videoDevice,
+                                              requestedFPS,
+                                              fb,
+                                              pixelFormat);
+        }
+        else
+        {
+            source = std::make_unique<ReplaySource>(replayFile, requestedFPS);
+        }
 
         //-----------------------------------------------------------------
 
-        const auto d = wc.dimensions();
-        std::println("{} [{} x {}]", wc.formatName(), d.width(), d.height());
+        const auto& format = source->getFormat();
+        const auto d = format.m_dimensions;
+        std::println("{} [{} x {}]", format.m_name, d.width(), d.height());
 
         //-----------------------------------------------------------------
 
-        wc.startStream();
+        FrameDecoder decoder(format, greyscale, fitToScreen, fb.getDimensions());
+        Pipeline pipeline(*source, decoder, recordFile);
+
+        fb.getStatistics().logCsv(statsFile);
+        pipeline.start();
 
-        while (run)
+        while (run and pipeline.present(fb))
         {
-            wc.showFrame(fb);
-            fb.update();
         }
 
-        wc.stopStream();
+        pipeline.stop();
+
+        if (not statsFile.empty())
+        {
+            fb.getStatistics().writeSummary(std::cout);
+            pipeline.writeSummary(std::cout);
+        }
     }
     catch (std::exception& error)
     {
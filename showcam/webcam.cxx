@@ -27,138 +27,27 @@
 
 #include <fcntl.h>
 #include <linux/videodev2.h>
+#include <poll.h>
 #include <sys/ioctl.h>
 #include <sys/mman.h>
 
 #include <algorithm>
+#include <cstring>
 #include <map>
 #include <system_error>
 
-#include "decodeH264.h"
-#include "image8880Jpeg.h"
-#include "image8880Process.h"
 #include "webcam.h"
 
-#ifdef WITH_BS_THREAD_POOL
-#include "BS_thread_pool.hpp"
-#endif
-
 //=========================================================================
 
-namespace {
-
-//-------------------------------------------------------------------------
-
-#ifdef WITH_BS_THREAD_POOL
-
-BS::thread_pool& threadPool()
-{
-    static BS::thread_pool s_threadPool;
-
-    return s_threadPool;
-}
-
-#endif
-
-//-------------------------------------------------------------------------
-
-void
-rowsYuvyToGrey(
-    const uint8_t* data,
-    fb32::Image8880& image,
-    std::size_t start,
-    std::size_t end)
-{
-    constexpr std::size_t BytesPerY{2};
-    auto buffer = begin(image.getBuffer()) + (start / BytesPerY);
-    data += start;
-
-    for (std::size_t i = start; i < end; i += BytesPerY)
-    {
-        const auto y = *data;
-        const fb32::RGB8880 rgb{y, y, y};
-        *(buffer++) = rgb.get8880();
-        data += BytesPerY;
-    }
-}
-
-//-------------------------------------------------------------------------
-//
-// R = 1.164 (Y - 16) + 1.596 (V - 128)
-// G = 1.164 (Y - 16) - 0.813 (V - 128) - 0.391 (U - 128)
-// B = 1.164 (Y - 16) + 2.018 (U - 128)
-//
-// R = (1192 (Y - 16) + 1634 (V - 128)) / 1024
-// G = (1192 (Y - 16) -  832 (V - 128) -  400 (U - 128)) / 1024
-// B = (1992 (Y - 16) + 2066 (U - 128)) / 1024
-//
-
-void
-rowsYuvyToRGB(
-    const uint8_t* data,
-    fb32::Image8880& image,
-    std::size_t start,
-    std::size_t end)
-{
-    constexpr std::size_t BytesPerYuyv{4};
-    auto buffer = begin(image.getBuffer()) + (start / (BytesPerYuyv / 2));
-    data += start;
-
-    for (std::size_t i = start; i < end; i += BytesPerYuyv)
-    {
-        const int y1 = data[0] - 16;
-        const int u = data[1] - 128;
-        const int y2 = data[2] - 16;
-        const int v = data[3] - 128;
-
-        const int y1Part = 1192 * y1;
-        const int y2Part = 1192 * y2;
-
-        const int rPart = 1634 * v;
-        const int gPart = -832 * v - 400 * u;
-        const int bPart = 2066 * u;
-
-        const fb32::RGB8880 rgb1{
-            static_cast<uint8_t>(std::clamp((y1Part + rPart) / 1024, 0, 255)),
-            static_cast<uint8_t>(std::clamp((y1Part + gPart) / 1024, 0, 255)),
-            static_cast<uint8_t>(std::clamp((y1Part + bPart) / 1024, 0, 255))};
-
-        const fb32::RGB8880 rgb2{
-            static_cast<uint8_t>(std::clamp((y2Part + rPart) / 1024, 0, 255)),
-            static_cast<uint8_t>(std::clamp((y2Part + gPart) / 1024, 0, 255)),
-            static_cast<uint8_t>(std::clamp((y2Part + bPart) / 1024, 0, 255))};
-
-        *(buffer++) = rgb1.get8880();
-        *(buffer++) = rgb2.get8880();
-
-        data += BytesPerYuyv;
-    }
-}
-
-//-------------------------------------------------------------------------
-
-};
-
-//=========================================================================
-
-
 fb32::Webcam::Webcam(
     const std::string& device,
-    bool fitToScreen,
-    bool greyscale,
     int requestedFPS,
     const Interface8880& interface,
     const std::string& pixelFormat)
 :
-    m_decodeH264{nullptr},
-    m_dimensions{ 0, 0 },
     m_fd{::open(device.c_str(), O_RDWR)},
-    m_fitToScreen{fitToScreen},
-    m_format{0},
-    m_formatName{},
-    m_greyscale{greyscale},
-    m_image{},
-    m_resizedImage{},
+    m_format{},
     m_videoBuffers{}
 {
     if (m_fd.fd() == -1)
@@ -189,11 +78,6 @@ fb32::Webcam::Webcam(
                                     " no frame sizes found");
     }
 
-    if (m_fitToScreen)
-    {
-        initResizedImage(interface);
-    }
-
     if (not initVideo())
     {
         throw std::invalid_argument("Device " +
@@ -202,8 +86,7 @@ fb32::Webcam::Webcam(
     }
 
     setFPS(requestedFPS);
-
-    m_image = Image8880(m_dimensions);
+    m_format.m_fps = getFPS();
 
     if (not initBuffers())
     {
@@ -227,86 +110,68 @@ fb32::Webcam::~Webcam()
 
 //-------------------------------------------------------------------------
 
-bool
-fb32::Webcam::showFrame(
-    Interface8880Base& interface)
+fb32::FrameSource::Result
+fb32::Webcam::capture(
+    CapturedFrame& frame,
+    std::chrono::milliseconds timeout)
 {
-    v4l2_buffer buffer;
-    buffer.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
-    buffer.memory = V4L2_MEMORY_MMAP;
+    pollfd pfd{m_fd.fd(), POLLIN, 0};
+    const auto ready = ::poll(&pfd, 1, static_cast<int>(timeout.count()));
 
-    if (::ioctl(m_fd.fd(), VIDIOC_DQBUF, &buffer) == -1)
+    if (ready == -1)
     {
-        return false;
-    }
-
-    auto vbuffer = m_videoBuffers[buffer.index].buffer;
-    const uint8_t* data = static_cast<uint8_t*>(vbuffer);
-
-    //-----------------------------------------------------------------
+        if (errno == EINTR)
+        {
+            return Result::TIMEOUT;
+        }
 
-    bool result = false;
+        throw std::system_error{errno,
+                                std::system_category(),
+                                "polling video device"};
+    }
 
-    switch (m_format)
+    if (ready == 0)
     {
-        case V4L2_PIX_FMT_H264:
-
-            if (m_decodeH264)
-            {
-                result = m_decodeH264->decode(data,
-                                              buffer.length,
-                                              m_image,
-                                              m_greyscale);
-            }
-            break;
-
-        case V4L2_PIX_FMT_MJPEG:
-
-            if (m_greyscale)
-            {
-                result = convertMjpegToGrey(data, buffer.length);
-            }
-            else
-            {
-                result = convertMjpegToRGB(data, buffer.length);
-            }
-            break;
-
-        case V4L2_PIX_FMT_YUYV:
-
-            if (m_greyscale)
-            {
-                result = convertYuyvToGrey(data, buffer.length);
-            }
-            else
-            {
-                result = convertYuyvToRGB(data, buffer.length);
-            }
-            break;
+        return Result::TIMEOUT;
     }
 
-    if (result)
+    v4l2_buffer buffer{};
+    buffer.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    buffer.memory = V4L2_MEMORY_MMAP;
+
+    if (::ioctl(m_fd.fd(), VIDIOC_DQBUF, &buffer) == -1)
     {
-        if (m_fitToScreen)
-        {
-            resizeToNearestNeighbour(m_image, m_resizedImage);
-            interface.putImage(center(interface, m_resizedImage), m_resizedImage);
-        }
-        else
+        if ((errno == EAGAIN) or (errno == EINTR))
         {
-            interface.putImage(center(interface, m_image), m_image);
+            return Result::TIMEOUT;
         }
+
+        throw std::system_error{errno,
+                                std::system_category(),
+                                "dequeuing video buffer"};
     }
 
+    // Copy the frame out so that the buffer can go straight back to the
+    // driver, rather than waiting for the decoder.
+
+    const auto& vb = m_videoBuffers[buffer.index];
+    const auto length = (buffer.bytesused > 0)
+                      ? static_cast<std::size_t>(buffer.bytesused)
+                      : static_cast<std::size_t>(vb.length);
+    const auto* data = static_cast<const uint8_t*>(vb.buffer);
+
+    frame.m_captured = std::chrono::steady_clock::now();
+    frame.m_data.assign(data, data + length);
+
     ::ioctl(m_fd.fd(), VIDIOC_QBUF, &buffer);
 
-    return result;
+    return Result::FRAME;
 }
 
 //-------------------------------------------------------------------------
 
 bool
-fb32::Webcam::startStream() const noexcept
+fb32::Webcam::startStream()
 {
     enum v4l2_buf_type buf_type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
 
@@ -321,7 +186,7 @@ fb32::Webcam::startStream() const noexcept
 //-------------------------------------------------------------------------
 
 bool
-fb32::Webcam::stopStream() const noexcept
+fb32::Webcam::stopStream()
 {
     enum v4l2_buf_type buf_type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
 
@@ -344,7 +209,7 @@ fb32::Webcam::chooseBestFit(
 
     v4l2_frmsizeenum frmsize;
     frmsize.index = 0;
-    frmsize.pixel_format = m_format;
+    frmsize.pixel_format = m_format.m_pixelFormat;
 
     while (::ioctl(m_fd.fd(), VIDIOC_ENUM_FRAMESIZES, &frmsize) == 0)
     {
@@ -363,7 +228,7 @@ fb32::Webcam::chooseBestFit(
         ++frmsize.index;
     }
 
-    m_dimensions.set(0, 0);
+    m_format.m_dimensions.set(0, 0);
     bool result = false;
 
     if (dim.size() > 0)
@@ -380,8 +245,8 @@ fb32::Webcam::chooseBestFit(
         {
             if ((d.width() <= id.width()) and
                 (d.height() <= id.height()) and
-                (d.width() > m_dimensions.width()) and
-                (d.height() > m_dimensions.height()))
+                (d.width() > m_format.m_dimensions.width()) and
+                (d.height() > m_format.m_dimensions.height()))
             {
                 return true;
             }
@@ -393,11 +258,11 @@ fb32::Webcam::chooseBestFit(
 
         if (found == end(dim))
         {
-            m_dimensions = dim.back();
+            m_format.m_dimensions = dim.back();
         }
         else
         {
-            m_dimensions = *found;
+            m_format.m_dimensions = *found;
         }
 
         result = true;
@@ -410,16 +275,16 @@ fb32::Webcam::chooseBestFit(
         if ((id.width() < static_cast<int>(sw.min_width)) or
             (id.height() < static_cast<int>(sw.min_height)))
         {
-            m_dimensions.set(sw.min_width, sw.min_height);
+            m_format.m_dimensions.set(sw.min_width, sw.min_height);
         }
         else if ((id.width() > static_cast<int>(sw.max_width)) or
                  (id.height() > static_cast<int>(sw.max_height)))
         {
-            m_dimensions.set(sw.max_width, sw.max_height);
+            m_format.m_dimensions.set(sw.max_width, sw.max_height);
         }
         else
         {
-            m_dimensions.set(
+            m_format.m_dimensions.set(
                 id.width() - (id.width() % sw.step_width),
                 id.height() - (id.height() % sw.step_height));
         }
@@ -456,13 +321,8 @@ fb32::Webcam::chooseFormat(
 
         if (formats.find(fourcc) != formats.end())
         {
-            m_format = fourcc;
-            m_formatName = formats[fourcc];
-
-            if (m_format == V4L2_PIX_FMT_H264)
-            {
-                m_decodeH264 = DecodeH264::create();
-            }
+            m_format.m_pixelFormat = fourcc;
+            m_format.m_name = formats[fourcc];
 
             return true;
         }
@@ -470,23 +330,22 @@ fb32::Webcam::chooseFormat(
 
     if (formats.find(V4L2_PIX_FMT_H264) != formats.end())
     {
-        m_format = V4L2_PIX_FMT_H264;
-        m_formatName = formats[V4L2_PIX_FMT_H264];
-        m_decodeH264 = DecodeH264::create();
+        m_format.m_pixelFormat = V4L2_PIX_FMT_H264;
+        m_format.m_name = formats[V4L2_PIX_FMT_H264];
         return true;
     }
 
     if (formats.find(V4L2_PIX_FMT_MJPEG) != formats.end())
     {
-        m_format = V4L2_PIX_FMT_MJPEG;
-        m_formatName = formats[V4L2_PIX_FMT_MJPEG];
+        m_format.m_pixelFormat = V4L2_PIX_FMT_MJPEG;
+        m_format.m_name = formats[V4L2_PIX_FMT_MJPEG];
         return true;
     }
 
     if (formats.find(V4L2_PIX_FMT_YUYV) != formats.end())
     {
-        m_format = V4L2_PIX_FMT_YUYV;
-        m_formatName = formats[V4L2_PIX_FMT_YUYV];
+        m_format.m_pixelFormat = V4L2_PIX_FMT_YUYV;
+        m_format.m_name = formats[V4L2_PIX_FMT_YUYV];
         return true;
     }
 
@@ -495,100 +354,21 @@ fb32::Webcam::chooseFormat(
 
 //-------------------------------------------------------------------------
 
-bool
-fb32::Webcam::convertMjpegToGrey(
-    const uint8_t* data,
-    std::size_t length)
-{
-    bool result = false;
-
-    try
-    {
-        decodeJpegToGrey(m_image, std::span<const uint8_t>{data, length});
-        result = true;
-    }
-    catch(const std::exception& e)
-    {
-        // do nothing
-    }
-
-    return result;
-}
-
-//-------------------------------------------------------------------------
-
-bool
-fb32::Webcam::convertYuyvToGrey(
-    const uint8_t* data,
-    std::size_t length)
-{
-#if WITH_BS_THREAD_POOL
-
-    auto& tPool = threadPool();
-    auto iterateRows = [data, this](int start, int end)
-    {
-        rowsYuvyToGrey(data, m_image, start, end);
-    };
-
-    tPool.detach_blocks<int>(0, length, iterateRows);
-    tPool.wait();
-
-#else
-
-    rowsYuvyToGrey(data, m_image, 0, length);
-
-#endif
-
-    return true;
-}
-
-//-------------------------------------------------------------------------
-
-bool
-fb32::Webcam::convertMjpegToRGB(
-    const uint8_t* data,
-    std::size_t length)
+int
+fb32::Webcam::getFPS() const noexcept
 {
-    bool result = false;
+    v4l2_streamparm streamparm{};
+    streamparm.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
 
-    try
-    {
-        decodeJpeg(m_image, std::span<const uint8_t>{data, length});
-        result = true;
-    }
-    catch(const std::exception& e)
+    if ((::ioctl(m_fd.fd(), VIDIOC_G_PARM, &streamparm) == -1) or
+        (streamparm.parm.capture.timeperframe.numerator == 0))
     {
-        // do nothing
+        return 0;
     }
 
-    return result;
-}
+    const auto& tpf = streamparm.parm.capture.timeperframe;
 
-//-------------------------------------------------------------------------
-
-bool
-fb32::Webcam::convertYuyvToRGB(
-    const uint8_t* data,
-    std::size_t length)
-{
-#if WITH_BS_THREAD_POOL
-
-    auto& tPool = threadPool();
-    auto iterateRows = [data, this](int start, int end)
-    {
-        rowsYuvyToRGB(data, m_image, start, end);
-    };
-
-    tPool.detach_blocks<int>(0, length, iterateRows);
-    tPool.wait();
-
-#else
-
-    rowsYuvyToRGB(data, m_image, 0, length);
-
-#endif
-
-    return true;
+    return tpf.denominator / tpf.numerator;
 }
 
 //-------------------------------------------------------------------------
@@ -682,57 +462,54 @@ bool fb32::Webcam::initBuffers() noexcept
 
 //-------------------------------------------------------------------------
 
-void
-fb32::Webcam::initResizedImage(
-    const Interface8880& interface)
-{
-    const auto id = interface.getDimensions();
-
-    if ((m_dimensions.width() == id.width()) and (m_dimensions.height() == id.height()))
-    {
-        m_fitToScreen = false;
-        return;
-    }
-
-    auto width = (m_dimensions.width() * id.height()) /
-                  m_dimensions.height();
-    auto height = id.height();
-
-    if (width > id.width())
-    {
-        width = id.width();
-        height = (m_dimensions.height() * id.width()) /
-                  m_dimensions.width();
-    }
-
-    const fb32::Dimensions8880 d{width, height};
-    m_resizedImage = Image8880{d};
-}
-
-//-------------------------------------------------------------------------
-
 bool
 fb32::Webcam::initVideo() noexcept
 {
     v4l2_format fmt{};
 
     fmt.type = V4L2_BUF_TYPE_VIDEO_CAPTURE,
-    fmt.fmt.pix.width = m_dimensions.width(),
-    fmt.fmt.pix.height = m_dimensions.height(),
+    fmt.fmt.pix.width = m_format.m_dimensions.width(),
+    fmt.fmt.pix.height = m_format.m_dimensions.height(),
     fmt.fmt.pix.field = V4L2_FIELD_ANY;
-    fmt.fmt.pix.pixelformat = m_format;
+    fmt.fmt.pix.pixelformat = m_format.m_pixelFormat;
 
     if (::ioctl(m_fd.fd(), VIDIOC_S_FMT, &fmt) == -1)
     {
         return false;
     }
 
-    if (fmt.fmt.pix.pixelformat != m_format)
+    if (fmt.fmt.pix.pixelformat != m_format.m_pixelFormat)
     {
         return false;
     }
 
-    m_dimensions.set(fmt.fmt.pix.width, fmt.fmt.pix.height);
+    m_format.m_dimensions.set(fmt.fmt.pix.width, fmt.fmt.pix.height);
+    m_format.m_bytesPerLine = fmt.fmt.pix.bytesperline;
+
+    if (m_format.m_bytesPerLine == 0)
+    {
+        m_format.m_bytesPerLine = 2 * fmt.fmt.pix.width;
+    }
+
+    // The driver reports the YUV encoding and range, or leaves them to be
+    // derived from the colour space.
+
+    auto& pix = fmt.fmt.pix;
+    const uint32_t encoding = (pix.ycbcr_enc == V4L2_YCBCR_ENC_DEFAULT)
+                            ? static_cast<uint32_t>(V4L2_MAP_YCBCR_ENC_DEFAULT(pix.colorspace))
+                            : pix.ycbcr_enc;
+    const uint32_t quantization = (pix.quantization == V4L2_QUANTIZATION_DEFAULT)
+                                ? static_cast<uint32_t>(V4L2_MAP_QUANTIZATION_DEFAULT(false,
+                                                                                      pix.colorspace,
+                                                                                      encoding))
+                                : pix.quantization;
+
+    m_format.m_matrix = (encoding == V4L2_YCBCR_ENC_709)
+                      ? YuvToRGB8880::Matrix::BT709
+                      : YuvToRGB8880::Matrix::BT601;
+    m_format.m_range = (quantization == V4L2_QUANTIZATION_FULL_RANGE)
+                     ? YuvToRGB8880::Range::FULL
+                     : YuvToRGB8880::Range::LIMITED;
 
     return true;
 }
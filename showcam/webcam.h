@@ -32,9 +32,8 @@
 #include <string>
 #include <vector>
 
-#include "decodeH264.h"
 #include "fileDescriptor.h"
-#include "image8880.h"
+#include "frameSource.h"
 #include "interface8880.h"
 
 //-------------------------------------------------------------------------
@@ -45,6 +44,8 @@ namespace fb32
 //-------------------------------------------------------------------------
 
 class Webcam
+:
+    public FrameSource
 {
 public:
 
@@ -56,13 +57,11 @@ public:
 
     explicit Webcam(
         const std::string& device,
-        bool fitToScreen,
-        bool greyscale,
         int requestedFPS,
         const Interface8880& interface,
         const std::string& pixelFormat);
 
-    ~Webcam();
+    ~Webcam() override;
 
     Webcam(const Webcam& wc) = delete;
     Webcam& operator=(const Webcam& wc) = delete;
@@ -70,43 +69,31 @@ public:
     Webcam(Webcam&& wc) = delete;
     Webcam& operator=(Webcam&& wc) = delete;
 
-    [[nodiscard]] const fb32::Dimensions8880 dimensions() const noexcept
+    [[nodiscard]] const FrameFormat& getFormat() const noexcept override
     {
-        return m_dimensions;
+        return m_format;
     }
 
-    [[nodiscard]] const std::string& formatName() const noexcept
-    {
-        return m_formatName;
-    }
+    Result
+    capture(
+        CapturedFrame& frame,
+        std::chrono::milliseconds timeout) override;
 
-    bool showFrame(Interface8880Base& interface);
-    bool startStream() const noexcept;
-    bool stopStream() const noexcept;
+    bool startStream() override;
+    bool stopStream() override;
 
 private:
 
     bool chooseBestFit(const Interface8880& interface);
     bool chooseFormat(const std::string& pixelFormat) noexcept;
-    bool convertMjpegToGrey(const uint8_t* data, std::size_t length);
-    bool convertYuyvToGrey(const uint8_t* data, std::size_t length);
-    bool convertMjpegToRGB(const uint8_t* data, std::size_t length);
-    bool convertYuyvToRGB(const uint8_t* data, std::size_t length);
+    int getFPS() const noexcept;
     bool hasVideoCapabilities() const noexcept;
     bool initBuffers() noexcept;
-    void initResizedImage(const Interface8880& interface);
     bool initVideo() noexcept;
     bool setFPS(int fps) const noexcept;
 
-    std::unique_ptr<DecodeH264> m_decodeH264;
-    fb32::Dimensions8880 m_dimensions;
     fd::FileDescriptor m_fd;
-    bool m_fitToScreen;
-    uint32_t m_format;
-    std::string m_formatName;
-    bool m_greyscale;
-    Image8880 m_image;
-    Image8880 m_resizedImage;
+    FrameFormat m_format;
     std::vector<VideoBuffer> m_videoBuffers;
 };
 
@@ -211,7 +211,8 @@ main(
         FrameBuffer8880 fb(device, connector);
         fb.clearBuffers(background);
 
-        auto image = readQoi(qoi, background);
+        auto image = qoi.ends_with(".qois") ? readQois(qoi, background)
+                                             : readQoi(qoi, background);
         const auto fbd = fb.getDimensions();
         const auto id = image.getDimensions();
 
@@ -0,0 +1,285 @@
+//-------------------------------------------------------------------------
+//
+// The MIT License (MIT)
+//
+// Copyright (c) 2022 Andrew Duncan
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+//-------------------------------------------------------------------------
+
+#pragma once
+
+//-------------------------------------------------------------------------
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stop_token>
+#include <thread>
+#include <vector>
+
+//-------------------------------------------------------------------------
+//
+// A least recently used cache of loaded values, bounded by the number of
+// bytes they hold (Value::getBytes()), with a worker thread that loads
+// the values most likely to be wanted next.
+//
+// prefetch() replaces any prefetches still queued, so jumping around
+// cancels the ones no longer needed. A value already being loaded is
+// finished, but is only kept if it is still wanted. Prefetched values
+// never push out the current value or the other wanted values, so a small
+// budget limits how far ahead is loaded rather than thrashing.
+//
+//-------------------------------------------------------------------------
+
+template<typename Key, typename Value>
+class PrefetchCache
+{
+public:
+
+    using Loader = std::function<std::optional<Value>(const Key&)>;
+
+    PrefetchCache(
+        Loader loader,
+        std::size_t budget)
+    :
+        m_loader{std::move(loader)},
+        m_budget{budget},
+        m_worker{[this](std::stop_token stopToken) { work(stopToken); }}
+    {
+    }
+
+    ~PrefetchCache() = default;
+
+    PrefetchCache(const PrefetchCache&) = delete;
+    PrefetchCache(PrefetchCache&&) = delete;
+    PrefetchCache& operator=(const PrefetchCache&) = delete;
+    PrefetchCache& operator=(PrefetchCache&&) = delete;
+
+    [[nodiscard]] std::size_t getBytes() const
+    {
+        std::lock_guard lock{m_mutex};
+        return m_bytes;
+    }
+
+    [[nodiscard]] std::size_t getHits() const
+    {
+        std::lock_guard lock{m_mutex};
+        return m_hits;
+    }
+
+    [[nodiscard]] std::size_t getMisses() const
+    {
+        std::lock_guard lock{m_mutex};
+        return m_misses;
+    }
+
+    // Return the value for key, waiting for the worker if it is loading it
+    // or loading it on this thread if not. Returns nullptr if the loader
+    // fails.
+
+    std::shared_ptr<const Value>
+    get(
+        const Key& key)
+    {
+        std::unique_lock lock{m_mutex};
+
+        while (m_loading == key)
+        {
+            m_condition.wait(lock);
+        }
+
+        if (auto item = find(key); item != m_items.end())
+        {
+            ++m_hits;
+            m_items.splice(m_items.begin(), m_items, item);
+
+            return m_items.front().m_value;
+        }
+
+        ++m_misses;
+        std::erase(m_pending, key);
+
+        lock.unlock();
+        auto value = m_loader(key);
+        lock.lock();
+
+        if (not value)
+        {
+            return nullptr;
+        }
+
+        auto shared = std::make_shared<const Value>(std::move(*value));
+        insert(key, shared, true);
+
+        return shared;
+    }
+
+    // Load keys, most important first, in the background. Together with
+    // current they are the values that are wanted.
+
+    void
+    prefetch(
+        const Key& current,
+        const std::vector<Key>& keys)
+    {
+        {
+            std::lock_guard lock{m_mutex};
+
+            m_wanted = keys;
+            m_wanted.push_back(current);
+            m_pending.clear();
+
+            for (const auto& key : keys)
+            {
+                if ((key != current) and
+                    (find(key) == m_items.end()) and
+                    (std::ranges::find(m_pending, key) == m_pending.end()))
+                {
+                    m_pending.push_back(key);
+                }
+            }
+        }
+
+        m_condition.notify_all();
+    }
+
+private:
+
+    struct Item
+    {
+        Key m_key;
+        std::shared_ptr<const Value> m_value;
+    };
+
+    using Items = std::list<Item>;
+
+    [[nodiscard]] typename Items::iterator
+    find(
+        const Key& key)
+    {
+        return std::ranges::find(m_items, key, &Item::m_key);
+    }
+
+    // Add a value, evicting from the least recently used end until it
+    // fits. Only a demanded value may evict values that are wanted.
+    // Returns false if a prefetched value would not fit.
+
+    bool
+    insert(
+        const Key& key,
+        std::shared_ptr<const Value> value,
+        bool demanded)
+    {
+        const auto bytes = value->getBytes();
+        auto item = m_items.end();
+
+        while ((item != m_items.begin()) and (m_bytes + bytes > m_budget))
+        {
+            --item;
+
+            const bool wanted = std::ranges::find(m_wanted, item->m_key) != m_wanted.end();
+
+            if (demanded or not wanted)
+            {
+                m_bytes -= item->m_value->getBytes();
+                item = m_items.erase(item);
+            }
+        }
+
+        if (not demanded and (m_bytes + bytes > m_budget))
+        {
+            return false;
+        }
+
+        m_items.emplace_front(key, std::move(value));
+        m_bytes += bytes;
+
+        return true;
+    }
+
+    void
+    work(
+        std::stop_token stopToken)
+    {
+        std::unique_lock lock{m_mutex};
+
+        while (m_condition.wait(lock, stopToken, [this] { return not m_pending.empty(); }))
+        {
+            const auto key = m_pending.front();
+            m_pending.pop_front();
+
+            if (find(key) != m_items.end())
+            {
+                continue;
+            }
+
+            m_loading = key;
+            lock.unlock();
+
+            auto value = m_loader(key);
+
+            lock.lock();
+            m_loading.reset();
+
+            const bool wanted = std::ranges::find(m_wanted, key) != m_wanted.end();
+
+            if (value and wanted)
+            {
+                auto shared = std::make_shared<const Value>(std::move(*value));
+
+                if (not insert(key, std::move(shared), false))
+                {
+                    // The rest are less important, so would not fit either.
+
+                    m_pending.clear();
+                }
+            }
+
+            m_condition.notify_all();
+        }
+    }
+
+    Loader m_loader;
+    std::size_t m_budget;
+    std::size_t m_bytes{0};
+    std::size_t m_hits{0};
+    std::size_t m_misses{0};
+    Items m_items{};
+    std::optional<Key> m_loading{};
+    std::deque<Key> m_pending{};
+    std::vector<Key> m_wanted{};
+
+    mutable std::mutex m_mutex{};
+    std::condition_variable_any m_condition{};
+
+    // last, so that it is stopped before the members it uses are destroyed
+
+    std::jthread m_worker;
+};
+
+//-------------------------------------------------------------------------
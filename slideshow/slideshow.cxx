@@ -27,12 +27,15 @@
 
 #include <getopt.h>
 #include <libgen.h>
+#include <poll.h>
 
+#include <array>
 #include <atomic>
 #include <csignal>
 #include <cstring>
 #include <iostream>
 #include <print>
+#include <system_error>
 
 #include "fontConfig.h"
 #include "framebuffer8880.h"
@@ -81,12 +84,15 @@ printUsage(
     std::println(stream, "Usage: {} <options>", name);
     std::println(stream, "");
     std::println(stream, "    --background,-b - background colour");
+    std::println(stream, "    --cache,-C - memory for decoded images in megabytes (default 256)");
     std::println(stream, "    --connector,-c - dri connector to use");
     std::println(stream, "    --device,-d - dri device to use");
     std::println(stream, "    --folder,-f - folder containing images");
     std::println(stream, "    --help,-h - print usage and exit");
     std::println(stream, "    --joystick,-j - joystick device");
+    std::println(stream, "    --prefetch,-p - images to decode ahead in each direction (default 2)");
     std::println(stream, "    --quality,-q - resize qualitylow, medium or high");
+    std::println(stream, "    --stats,-s - write frame timing to CSV file and print summary");
     std::println(stream, "    --truetype,-t - use truetype font file");
     std::println(stream, "");;
 }
@@ -99,26 +105,32 @@ main(
     char *argv[])
 {
     fb32::RGB8880 background{fb32::RGB8{0, 0, 0}};
+    std::size_t cacheMegabytes{256};
     uint32_t connector{0};
     std::string device{};
     const std::string program{basename(argv[0])};
     std::string folder{};
     FontConfig fontConfig;
     std::string joystick{defaultJoystick};
+    int prefetch{2};
     Viewer::Quality quality{Viewer::QUALITY_MEDIUM};
+    std::string statsFile{};
 
     //---------------------------------------------------------------------
 
-    static const char* sopts = "b:c:d:f:hj:q:t:";
+    static const char* sopts = "C:b:c:d:f:hj:p:q:s:t:";
     static option lopts[] =
     {
         { "background", required_argument, nullptr, 'b' },
+        { "cache", required_argument, nullptr, 'C' },
         { "connector", required_argument, nullptr, 'c' },
         { "device", required_argument, nullptr, 'd' },
         { "folder", required_argument, nullptr, 'f' },
         { "help", no_argument, nullptr, 'h' },
         { "joystick", required_argument, nullptr, 'j' },
+        { "prefetch", required_argument, nullptr, 'p' },
         { "quality", required_argument, nullptr, 'q' },
+        { "stats", required_argument, nullptr, 's' },
         { nullptr, no_argument, nullptr, 0 }
     };
 
@@ -128,6 +140,11 @@ main(
     {
         switch (opt)
         {
+        case 'C':
+
+            cacheMegabytes = std::stoul(optarg);
+            break;
+
         case 'b':
         {
             auto bg = parseRGB8880(optarg);
@@ -174,11 +191,21 @@ main(
             joystick = optarg;
             break;
 
+        case 'p':
+
+            prefetch = std::stoi(optarg);
+            break;
+
         case 'q':
 
             quality = Viewer::qualityFromString(optarg);
             break;
 
+        case 's':
+
+            statsFile = optarg;
+            break;
+
         case 't':
 
             fontConfig = fb32::parseFontConfig(optarg, 16);
@@ -225,37 +252,77 @@ main(
 
     try
     {
-        FrameBuffer8880 fb(device, connector);
+        // a third buffer lets the next image be processed while the last
+        // one waits for the vertical blank
+
+        constexpr int bufferCount{3};
+        FrameBuffer8880 fb(device, connector, bufferCount);
         fb.clearBuffers(background);
+        fb.getStatistics().logCsv(statsFile);
 
-        Joystick js{joystick, Joystick::ReadType::BLOCKING};
+        Joystick js{joystick};
         Viewer viewer
         {
             background,
             fb,
             folder,
             quality,
-            fontConfig
+            fontConfig,
+            cacheMegabytes * 1024 * 1024,
+            prefetch
         };
 
         viewer.draw(fb);
-        fb.update();
+        fb.present();
+
+        // wait for the joystick and for page flips together, so that a
+        // queued frame is flipped as soon as the one before it is shown
+
+        std::array pfds
+        {
+            pollfd{ .fd = js.getEventFd(), .events = POLLIN, .revents = 0 },
+            pollfd{ .fd = fb.getEventFd(), .events = POLLIN, .revents = 0 }
+        };
 
         while (run)
         {
-            js.read();
+            if (::poll(pfds.data(), pfds.size(), -1) == -1)
+            {
+                if (errno == EINTR)
+                {
+                    continue;
+                }
+
+                throw std::system_error(errno, std::system_category(), "poll");
+            }
 
-            if (js.buttonPressed(Joystick::BUTTON_START))
+            if (pfds[1].revents & POLLIN)
             {
-                run = false;
+                fb.handleEvents();
             }
-            else if (viewer.update(js))
+
+            if (pfds[0].revents & POLLIN)
             {
-                viewer.draw(fb);
-                fb.update();
+                js.read();
+
+                if (js.buttonPressed(Joystick::BUTTON_START))
+                {
+                    run = false;
+                }
+                else if (viewer.update(js))
+                {
+                    fb.acquireBackBuffer();
+                    viewer.draw(fb);
+                    fb.present();
+                }
             }
         }
 
+        if (not statsFile.empty())
+        {
+            fb.getStatistics().writeSummary(std::cout);
+        }
+
     }
     catch (std::exception& error)
     {
@@ -43,6 +43,7 @@
 #include "image8880Jpeg.h"
 #include "image8880Png.h"
 #include "image8880Qoi.h"
+#include "image8880TextCache.h"
 #include "viewer.h"
 
 //-------------------------------------------------------------------------
@@ -114,7 +115,8 @@ isImageFile(
         ".jpg",
         ".jpeg",
         ".png",
-        ".qoi"
+        ".qoi",
+        ".qois"
     };
 
     return std::ranges::find(extensions, ext) != std::end(extensions);
@@ -157,6 +159,38 @@ panStep() noexcept
 
 //-------------------------------------------------------------------------
 
+// Run a processing stage unless its input and parameter are the same as
+// last time, recording how long it took (zero if it was not run).
+
+template<typename Memo, typename Parameter, typename Function>
+[[nodiscard]] std::shared_ptr<const fb32::Image8880>
+memoize(
+    Memo& memo,
+    const std::shared_ptr<const fb32::Image8880>& input,
+    const Parameter& parameter,
+    std::chrono::microseconds& time,
+    Function function)
+{
+    if (memo.m_output and (memo.m_input == input) and (memo.m_parameter == parameter))
+    {
+        time = std::chrono::microseconds{0};
+        return memo.m_output;
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+
+    memo.m_output = function(input, parameter);
+    memo.m_input = input;
+    memo.m_parameter = parameter;
+
+    time = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - start);
+
+    return memo.m_output;
+}
+
+//-------------------------------------------------------------------------
+
 [[nodiscard]] std::vector<std::string>
 panStepStrings() noexcept
 {
@@ -203,6 +237,30 @@ qualityStrings()
 
 //-------------------------------------------------------------------------
 
+[[nodiscard]] fb32::ResizePlan::Filter
+resizeFilter(
+    Viewer::Quality quality) noexcept
+{
+    switch (quality)
+    {
+    case Viewer::QUALITY_LOW:
+
+        return fb32::ResizePlan::Filter::NEAREST_NEIGHBOUR;
+
+    case Viewer::QUALITY_MEDIUM:
+
+        return fb32::ResizePlan::Filter::BILINEAR;
+
+    case Viewer::QUALITY_HIGH:
+
+        return fb32::ResizePlan::Filter::LANCZOS3;
+    }
+
+    return fb32::ResizePlan::Filter::NEAREST_NEIGHBOUR;
+}
+
+//-------------------------------------------------------------------------
+
 [[nodiscard]] std::vector<std::string>
 zoomStrings(
     int maximum)
@@ -223,6 +281,23 @@ zoomStrings(
 
 // ========================================================================
 
+std::size_t
+Viewer::Picture::getBytes() const noexcept
+{
+    auto bytes = [](const fb32::Image8880& image)
+    {
+        return image.getBuffer().size_bytes();
+    };
+
+    // The processed image is the one read if no stage changed it.
+
+    const auto processed = (m_processed == m_image) ? 0 : bytes(*m_processed);
+
+    return bytes(*m_image) + bytes(*m_histogram) + processed;
+}
+
+//-------------------------------------------------------------------------
+
 Viewer::Annotate
 Viewer::annotateFromString(
     std::string_view string) noexcept
@@ -373,12 +448,50 @@ Viewer::qualityToString(
 
 //-------------------------------------------------------------------------
 
+std::string
+Viewer::stageToString(
+    Viewer::Stage stage) noexcept
+{
+    switch (stage)
+    {
+    case STAGE_GREY:
+
+        return "grey";
+
+    case STAGE_ENLIGHTEN:
+
+        return "enlighten";
+
+    case STAGE_STRETCH:
+
+        return "stretch";
+
+    case STAGE_HISTOGRAM:
+
+        return "histogram";
+
+    case STAGE_RESIZE:
+
+        return "resize";
+
+    case STAGE_COUNT:
+
+        break;
+    }
+
+    return "";
+}
+
+//-------------------------------------------------------------------------
+
 Viewer::Viewer(
     fb32::RGB8880 background,
     fb32::Interface8880& interface,
     const std::string& folder,
     Viewer::Quality quality,
-    const fb32::FontConfig& fontConfig)
+    const fb32::FontConfig& fontConfig,
+    std::size_t cacheBytes,
+    int prefetch)
 :
     m_annotate{ANNOTATE_SHORT},
     m_background{background},
@@ -390,18 +503,16 @@ Viewer::Viewer(
         {".jpg", Type::JPEG},
         {".jpeg", Type::JPEG},
         {".png", Type::PNG},
-        {".qoi", Type::QOI}
+        {".qoi", Type::QOI},
+        {".qois", Type::QOIS}
     },
     m_files{},
     m_fileStep{1},
     m_fitToScreen{true},
-    m_font{createFont(fontConfig)},
+    m_font{std::make_shared<fb32::Image8880TextCache>(createFont(fontConfig))},
     m_greyscale{false},
     m_histogram{HISTOGRAM_OFF},
     m_histogramStretch{false},
-    m_image{},
-    m_imageHistogram{},
-    m_imageProcessed{},
     m_isBlank{false},
     m_menu{
         fb32::RGB8880{0x00FFFFFF},
@@ -422,11 +533,14 @@ Viewer::Viewer(
         }
     },
     m_menuShow{false},
+    m_memos{},
     m_offset{0, 0},
     m_panStep{10},
-    m_percent{100},
+    m_picture{std::make_shared<const Picture>()},
+    m_prefetch{prefetch},
     m_quality{quality},
-    m_zoom{0}
+    m_zoom{0},
+    m_cache{[this](const PictureKey& key) { return loadPicture(key); }, cacheBytes}
 {
     readDirectory();
 
@@ -529,14 +643,14 @@ Viewer::annotate()
 
     auto [name, type] = m_files[m_current];
     auto annotation = fs::path(name).filename().string();
-    const auto d = m_image.getDimensions();
+    const auto d = m_picture->m_dimensions;
 
     annotation += std::format(" ({}x{})", d.width(), d.height());
     annotation += std::format(" [{}/{}]", m_current + 1, m_files.size());
 
     if (m_annotate == ANNOTATE_LONG)
     {
-        annotation += std::format(" {}%", m_percent);
+        annotation += std::format(" {}%", m_picture->m_percent);
         annotation += std::format(" [{}]", qualityToString(m_quality));
     }
 
@@ -570,6 +684,49 @@ Viewer::annotate()
 
     fb32::boxFilled(m_buffer, p1, p2, black, 127);
     m_font->drawString(Point{padding, padding}, annotation, green, m_buffer);
+
+    if (m_annotate == ANNOTATE_LONG)
+    {
+        // Time taken by each processing stage, zero if it was reused.
+
+        std::string times;
+
+        for (int stage = 0 ; stage < STAGE_COUNT ; ++stage)
+        {
+            const auto& time = m_picture->m_times[stage];
+
+            times += std::format("{}{} {:.1f}",
+                                 (stage == 0) ? "" : " ",
+                                 stageToString(static_cast<Stage>(stage)),
+                                 time.count() / 1000.0);
+        }
+
+        times += " ms";
+
+        const auto timesDimensions = m_font->getStringDimensions(times);
+        const Point p3{0, p2.y()};
+        const Point p4{timesDimensions.width() + padding2,
+                       p2.y() + timesDimensions.height() + padding2};
+
+        fb32::boxFilled(m_buffer, p3, p4, black, 127);
+        m_font->drawString(Point{padding, p2.y() + padding}, times, green, m_buffer);
+    }
+}
+
+//-------------------------------------------------------------------------
+
+Viewer::Settings
+Viewer::currentSettings() const noexcept
+{
+    return Settings
+    {
+        m_fitToScreen,
+        m_greyscale,
+        m_histogram,
+        m_histogramStretch,
+        m_quality,
+        m_zoom
+    };
 }
 
 //-------------------------------------------------------------------------
@@ -647,13 +804,7 @@ Viewer::imageNext()
 {
     if (haveImages())
     {
-        m_current += m_fileStep;
-
-        if (m_current >= m_files.size())
-        {
-            m_current = 0;
-        }
-
+        m_current = nextIndex(m_current);
         openImage();
     }
 }
@@ -665,51 +816,76 @@ Viewer::imagePrevious()
 {
     if (haveImages())
     {
-        if (static_cast<int>(m_current) < m_fileStep)
-        {
-            m_current = m_files.size() - 1;
-        }
-        else
-        {
-            m_current -= m_fileStep;
-        }
-
+        m_current = previousIndex(m_current);
         openImage();
     }
 }
 
 //-------------------------------------------------------------------------
 
-void
-Viewer::openImage()
+std::optional<Viewer::Picture>
+Viewer::loadPicture(
+    const PictureKey& key) const
 {
-    auto [name, type] = m_files[m_current];
+    // Called by the cache, possibly on its worker thread, so this only
+    // reads members that do not change once the files are found.
+
+    const auto& settings = key.m_settings;
+    const bool reduced = settings.m_fitToScreen and
+                         (settings.m_zoom == SCALE_OVERSIZED);
 
     try
     {
-        switch (type)
-        {
-        case Type::JPEG:
-            m_image = fb32::readJpeg(name);
-            break;
-        case Type::PNG:
-            m_image = fb32::readPng(name, m_background);
-            break;
-        case Type::QOI:
-            m_image = fb32::readQoi(name, m_background);
-            break;
-        }
+        Memos memos;
+
+        return process(readImage(m_files[key.m_index], reduced),
+                       settings,
+                       0,
+                       memos);
     }
     catch (std::invalid_argument& e)
     {
-        std::println(std::cerr, "{} {}", name, e.what());
+        std::println(std::cerr, "{} {}", m_files[key.m_index].m_filename, e.what());
     }
 
+    return std::nullopt;
+}
+
+//-------------------------------------------------------------------------
+
+std::size_t
+Viewer::nextIndex(
+    std::size_t index) const noexcept
+{
+    index += m_fileStep;
+
+    if (index >= m_files.size())
+    {
+        index = 0;
+    }
+
+    return index;
+}
+
+//-------------------------------------------------------------------------
+
+void
+Viewer::openImage()
+{
     m_enlighten = 0;
     m_offset.center();
 
-    processImage();
+    // The memos are of the previous image, so only the plan is worth keeping.
+
+    m_memos = Memos{.m_resizePlan = std::move(m_memos.m_resizePlan)};
+
+    if (auto picture = m_cache.get({m_current, currentSettings()}))
+    {
+        m_picture = std::move(picture);
+    }
+
     paint();
+    prefetch();
 }
 
 //-------------------------------------------------------------------------
@@ -747,7 +923,8 @@ Viewer::paint()
         m_offset.center();
     }
 
-    m_buffer.putImage(placeImage(m_imageProcessed), m_imageProcessed);
+    const auto& processed = *m_picture->m_processed;
+    m_buffer.putImage(placeImage(processed), processed);
     annotate();
     showHistogram();
 }
@@ -778,80 +955,156 @@ Viewer::placeImage(
 //-------------------------------------------------------------------------
 
 void
-Viewer::processHistogram()
+Viewer::prefetch()
 {
-    switch (m_histogram)
+    if (not haveImages())
     {
-    case HISTOGRAM_OFF:
-
-        m_imageHistogram = fb32::Image8880();
-        break;
-
-    case HISTOGRAM_RGB:
+        return;
+    }
 
-        m_imageHistogram = histogramRGB(m_imageProcessed);
-        break;
+    // Alternate forwards and backwards, nearest first.
 
-    case HISTOGRAM_INTENSITY:
+    const auto settings = currentSettings();
+    std::vector<PictureKey> keys;
+    auto next = m_current;
+    auto previous = m_current;
 
-        m_imageHistogram = histogramIntensity(m_imageProcessed);
-        break;
+    for (int i = 0 ; i < m_prefetch ; ++i)
+    {
+        next = nextIndex(next);
+        previous = previousIndex(previous);
 
+        keys.push_back({next, settings});
+        keys.push_back({previous, settings});
     }
+
+    m_cache.prefetch({m_current, settings}, keys);
 }
 
 //-------------------------------------------------------------------------
 
-void
-Viewer::processHistogramStretch()
+std::size_t
+Viewer::previousIndex(
+    std::size_t index) const noexcept
 {
-    if (m_histogramStretch)
+    if (static_cast<int>(index) < m_fileStep)
     {
-        m_imageProcessed = histogramStretch(10, m_imageProcessed);
+        return m_files.size() - 1;
     }
+
+    return index - m_fileStep;
 }
 
 //-------------------------------------------------------------------------
 
-void
-Viewer::processImage()
+Viewer::Picture
+Viewer::process(
+    Picture picture,
+    const Settings& settings,
+    int enlighten,
+    Memos& memos) const
 {
-    const auto id = m_image.getDimensions();
+    // grey -> enlighten -> stretch -> resize, with the histogram taken
+    // from the stretched image. Each stage is only run if its input or
+    // parameter has changed, so for example turning on the histogram
+    // does not enlighten the image again.
+
+    const auto id = picture.m_dimensions;
+    picture.m_percent = 100;
+    picture.m_times = {};
 
     if (id.width() == 0 or id.height() == 0)
     {
-        m_imageProcessed = m_image;
-        return;
+        picture.m_processed = picture.m_image;
+        return picture;
     }
 
-    if (m_greyscale)
-    {
-        m_imageProcessed = fb32::toGrey(m_image);
-    }
-    else
-    {
-        m_imageProcessed = m_image;
-    }
+    auto& times = picture.m_times;
 
-    if (m_enlighten)
-    {
-        m_imageProcessed = enlighten(m_imageProcessed, m_enlighten / 10.0);
-    }
+    auto grey = memoize(
+        memos.m_grey,
+        picture.m_image,
+        settings.m_greyscale,
+        times[STAGE_GREY],
+        [](const ImagePtr& input, bool greyscale)
+        {
+            return greyscale ? std::make_shared<const fb32::Image8880>(fb32::toGrey(*input))
+                             : input;
+        });
+
+    auto enlightened = memoize(
+        memos.m_enlighten,
+        grey,
+        enlighten,
+        times[STAGE_ENLIGHTEN],
+        [](const ImagePtr& input, int enlighten)
+        {
+            return (enlighten)
+                 ? std::make_shared<const fb32::Image8880>(fb32::enlighten(*input, enlighten / 10.0))
+                 : input;
+        });
+
+    auto stretched = memoize(
+        memos.m_stretch,
+        enlightened,
+        settings.m_histogramStretch,
+        times[STAGE_STRETCH],
+        [](const ImagePtr& input, bool stretch)
+        {
+            return (stretch)
+                 ? std::make_shared<const fb32::Image8880>(histogramStretch(10, *input))
+                 : input;
+        });
+
+    picture.m_histogram = memoize(
+        memos.m_histogram,
+        stretched,
+        settings.m_histogram,
+        times[STAGE_HISTOGRAM],
+        [](const ImagePtr& input, Histogram histogram)
+        {
+            switch (histogram)
+            {
+            case HISTOGRAM_RGB:
 
-    processHistogramStretch();
-    processHistogram();
+                return std::make_shared<const fb32::Image8880>(histogramRGB(*input));
 
-    if (((m_zoom == SCALE_OVERSIZED) and
-         not oversize() and
-         not m_fitToScreen) or (m_zoom == 1))
-    {
-        m_percent = 100;
-    }//-------------------------------------------------------------------------
-    else
-    {
-        if (m_zoom == SCALE_OVERSIZED)
+            case HISTOGRAM_INTENSITY:
+
+                return std::make_shared<const fb32::Image8880>(histogramIntensity(*input));
+
+            case HISTOGRAM_OFF:
+
+                break;
+            }
+
+            return std::make_shared<const fb32::Image8880>();
+        });
+
+    const ResizeParameters resize{settings.m_fitToScreen, settings.m_quality, settings.m_zoom};
+    const auto bd = m_buffer.getDimensions();
+
+    picture.m_processed = memoize(
+        memos.m_resize,
+        stretched,
+        resize,
+        times[STAGE_RESIZE],
+        [&memos, id, bd](const ImagePtr& input, const ResizeParameters& resize)
         {
-            const auto bd = m_buffer.getDimensions();
+            const bool oversize = (id.width() > bd.width()) or (id.height() > bd.height());
+
+            if (((resize.m_zoom == SCALE_OVERSIZED) and
+                 not oversize and
+                 not resize.m_fitToScreen) or (resize.m_zoom == 1))
+            {
+                return input;
+            }
+
+            if (resize.m_zoom != SCALE_OVERSIZED)
+            {
+                return std::make_shared<const fb32::Image8880>(scaleUp(*input, resize.m_zoom));
+            }
+
             fb32::Dimensions8880 d
             {
                 (bd.height() * id.width()) / id.height(),
@@ -865,42 +1118,54 @@ Viewer::processImage()
                     (bd.width() * id.height()) / id.width());
             }
 
-            processResize(d);
+            const auto filter = resizeFilter(resize.m_quality);
+            const auto pd = input->getDimensions();
+            auto& resizePlan = memos.m_resizePlan;
 
-            auto percent = (100.0 * m_imageProcessed.getDimensions().width()) / id.width();
-            m_percent = static_cast<int>(0.5 + percent);
-        }
-        else
-        {
-            m_imageProcessed = scaleUp(m_imageProcessed, m_zoom);
-            m_percent = m_zoom * 100;
-        }
-    }
+            if (not resizePlan or not resizePlan->matches(pd, d, filter))
+            {
+                resizePlan.emplace(pd, d, filter);
+            }
+
+            auto resized = std::make_shared<fb32::Image8880>(d);
+            resizePlan->resize(*input, *resized);
+
+            return ImagePtr{std::move(resized)};
+        });
+
+    auto percent = (100.0 * picture.m_processed->getDimensions().width()) / id.width();
+    picture.m_percent = static_cast<int>(0.5 + percent);
+
+    return picture;
 }
 
 //-------------------------------------------------------------------------
 
 void
-Viewer::processResize(
-    fb32::Dimensions8880 d)
+Viewer::processImage()
 {
-    switch (m_quality)
-    {
-    case QUALITY_LOW:
+    Picture picture{m_picture->m_image, m_picture->m_dimensions};
 
-        m_imageProcessed = resizeNearestNeighbour(m_imageProcessed, d);
-        break;
+    const bool reduced = picture.m_image->getDimensions() != picture.m_dimensions;
 
-    case QUALITY_MEDIUM:
+    if (reduced and (not m_fitToScreen or (m_zoom != SCALE_OVERSIZED)))
+    {
+        try
+        {
+            picture = readImage(m_files[m_current], false);
+        }
+        catch (std::invalid_argument& e)
+        {
+            std::println(std::cerr, "{} {}", m_files[m_current].m_filename, e.what());
+        }
+    }
 
-        m_imageProcessed = resizeBilinearInterpolation(m_imageProcessed, d);
-        break;
+    m_picture = std::make_shared<const Picture>(
+        process(std::move(picture), currentSettings(), m_enlighten, m_memos));
 
-    case QUALITY_HIGH:
+    // The neighbouring images are wanted with the new settings.
 
-        m_imageProcessed = resizeLanczos3Interpolation(m_imageProcessed, d);
-        break;
-    }
+    prefetch();
 }
 
 //-------------------------------------------------------------------------
@@ -947,6 +1212,60 @@ Viewer::readDirectory()
 
 //-------------------------------------------------------------------------
 
+Viewer::Picture
+Viewer::readImage(
+    const ImageFile& file,
+    bool reduced) const
+{
+    const auto& [name, type] = file;
+    Picture picture;
+
+    switch (type)
+    {
+    case Type::JPEG:
+
+        // When fitting to the screen a reduced size decode is enough,
+        // processImage() reads the image again in full if zoomed.
+
+        if (reduced)
+        {
+            fb32::Dimensions8880 d;
+            picture.m_image = std::make_shared<const fb32::Image8880>(
+                fb32::readJpeg(name, m_buffer.getDimensions(), &d));
+            picture.m_dimensions = d;
+
+            return picture;
+        }
+
+        picture.m_image = std::make_shared<const fb32::Image8880>(fb32::readJpeg(name));
+        break;
+
+    case Type::PNG:
+
+        picture.m_image = std::make_shared<const fb32::Image8880>(
+            fb32::readPng(name, m_background));
+        break;
+
+    case Type::QOI:
+
+        picture.m_image = std::make_shared<const fb32::Image8880>(
+            fb32::readQoi(name, m_background));
+        break;
+
+    case Type::QOIS:
+
+        picture.m_image = std::make_shared<const fb32::Image8880>(
+            fb32::readQois(name, m_background));
+        break;
+    }
+
+    picture.m_dimensions = picture.m_image->getDimensions();
+
+    return picture;
+}
+
+//-------------------------------------------------------------------------
+
 void
 Viewer::readValuesFromMenu()
 {
@@ -1018,11 +1337,11 @@ Viewer::showHistogram()
     constexpr int padding{4};
     fb32::Point8880 p
     {
-        m_buffer.getDimensions().width() - m_imageHistogram.getDimensions().width() - padding,
-        m_buffer.getDimensions().height() - m_imageHistogram.getDimensions().height() - padding
+        m_buffer.getDimensions().width() - m_picture->m_histogram->getDimensions().width() - padding,
+        m_buffer.getDimensions().height() - m_picture->m_histogram->getDimensions().height() - padding
     };
 
-    m_buffer.putImage(p, m_imageHistogram);
+    m_buffer.putImage(p, *m_picture->m_histogram);
 }
 
 //-------------------------------------------------------------------------
@@ -1030,7 +1349,7 @@ Viewer::showHistogram()
 fb32::Dimensions8880
 Viewer::zoomedDimensions() const noexcept
 {
-    const auto d = m_image.getDimensions();
+    const auto d = m_picture->m_dimensions;
     const auto zoom = (m_zoom == 0) ? 1 : m_zoom;
 
     return {d.width() * zoom, d.height() * zoom};
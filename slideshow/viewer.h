@@ -29,18 +29,25 @@
 
 //-------------------------------------------------------------------------
 
+#include <array>
+#include <chrono>
+#include <cstddef>
 #include <limits>
 #include <map>
+#include <memory>
+#include <optional>
 #include <string>
 #include <vector>
 
 #include "fontConfig.h"
 #include "framebuffer8880.h"
 #include "image8880.h"
+#include "image8880Process.h"
 #include "interface8880.h"
 #include "interface8880Font.h"
 #include "interface8880Menu.h"
 #include "joystick.h"
+#include "prefetchCache.h"
 
 //-------------------------------------------------------------------------
 
@@ -75,7 +82,18 @@ public:
     {
         JPEG,
         PNG,
-        QOI
+        QOI,
+        QOIS
+    };
+
+    enum Stage
+    {
+        STAGE_GREY,
+        STAGE_ENLIGHTEN,
+        STAGE_STRETCH,
+        STAGE_HISTOGRAM,
+        STAGE_RESIZE,
+        STAGE_COUNT
     };
 
     enum MenuIds
@@ -116,6 +134,8 @@ public:
     [[nodiscard]] static Quality qualityFromString(std::string_view string) noexcept;
     [[nodiscard]] static std::string qualityToString(Quality quality) noexcept;
 
+    [[nodiscard]] static std::string stageToString(Stage stage) noexcept;
+
     //---------------------------------------------------------------------
 
     class Offset
@@ -172,7 +192,9 @@ public:
         fb32::Interface8880& interface,
         const std::string& folder,
         Quality quality,
-        const fb32::FontConfig& fontConfig);
+        const fb32::FontConfig& fontConfig,
+        std::size_t cacheBytes,
+        int prefetch);
 
     ~Viewer();
 
@@ -187,23 +209,107 @@ public:
 
 private:
 
+    // Everything that processing an image depends on, apart from enlighten
+    // which is reset when an image is opened.
+
+    struct Settings
+    {
+        bool m_fitToScreen;
+        bool m_greyscale;
+        Histogram m_histogram;
+        bool m_histogramStretch;
+        Quality m_quality;
+        int m_zoom;
+
+        bool operator==(const Settings&) const = default;
+    };
+
+    struct PictureKey
+    {
+        std::size_t m_index;
+        Settings m_settings;
+
+        bool operator==(const PictureKey&) const = default;
+    };
+
+    using ImagePtr = std::shared_ptr<const fb32::Image8880>;
+    using StageTimes = std::array<std::chrono::microseconds, STAGE_COUNT>;
+
+    // An image as read (possibly reduced in size) and as processed for
+    // display. m_dimensions is the full size of the image. m_times is
+    // the time each processing stage took, zero if it was reused.
+
+    struct Picture
+    {
+        ImagePtr m_image{std::make_shared<const fb32::Image8880>()};
+        fb32::Dimensions8880 m_dimensions{};
+        ImagePtr m_histogram{std::make_shared<const fb32::Image8880>()};
+        ImagePtr m_processed{std::make_shared<const fb32::Image8880>()};
+        int m_percent{100};
+        StageTimes m_times{};
+
+        [[nodiscard]] std::size_t getBytes() const noexcept;
+    };
+
+    // The output of a processing stage with the input and parameter it was
+    // made from. A stage whose input and parameter are unchanged is not
+    // run again.
+
+    template<typename Parameter>
+    struct Memo
+    {
+        ImagePtr m_input{};
+        Parameter m_parameter{};
+        ImagePtr m_output{};
+    };
+
+    struct ResizeParameters
+    {
+        bool m_fitToScreen;
+        Quality m_quality;
+        int m_zoom;
+
+        bool operator==(const ResizeParameters&) const = default;
+    };
+
+    struct Memos
+    {
+        Memo<bool> m_grey{};
+        Memo<int> m_enlighten{};
+        Memo<bool> m_stretch{};
+        Memo<Histogram> m_histogram{};
+        Memo<ResizeParameters> m_resize{};
+        std::optional<fb32::ResizePlan> m_resizePlan{};
+    };
+
     [[nodiscard]] bool haveImages() const noexcept { return m_current != INVALID_INDEX; }
-    [[nodiscard]] bool originalSize() const noexcept { return m_percent == 100; }
+    [[nodiscard]] bool originalSize() const noexcept { return m_picture->m_percent == 100; }
 
     void annotate();
+    [[nodiscard]] Settings currentSettings() const noexcept;
     bool handleImageViewing(fb32::Joystick& js);
     void imageNext();
     void imagePrevious();
+    [[nodiscard]] std::optional<Picture> loadPicture(const PictureKey& key) const;
+    [[nodiscard]] std::size_t nextIndex(std::size_t index) const noexcept;
     void openImage();
     [[nodiscard]] bool oversize() const noexcept;
     void paint();
     void pan(int dx, int dy) noexcept;
     [[nodiscard]] fb32::Point8880 placeImage(const fb32::Image8880& image) const noexcept;
-    void processHistogram();
-    void processHistogramStretch();
+    void prefetch();
+    [[nodiscard]] std::size_t previousIndex(std::size_t index) const noexcept;
+
+    [[nodiscard]] Picture
+    process(
+        Picture picture,
+        const Settings& settings,
+        int enlighten,
+        Memos& memos) const;
+
     void processImage();
-    void processResize(fb32::Dimensions8880 d);
     void readDirectory();
+    [[nodiscard]] Picture readImage(const ImageFile& file, bool reduced) const;
     void readValuesFromMenu();
     void setMenuValues();
     void showHistogram();
@@ -227,15 +333,19 @@ private:
     bool m_greyscale;
     Histogram m_histogram;
     bool m_histogramStretch;
-    fb32::Image8880 m_image;
-    fb32::Image8880 m_imageHistogram;
-    fb32::Image8880 m_imageProcessed;
     bool m_isBlank;
     fb32::Interface8880Menu m_menu;
     bool m_menuShow;
+    Memos m_memos;
     Offset m_offset;
     int m_panStep;
-    int m_percent;
+    std::shared_ptr<const Picture> m_picture;
+    int m_prefetch;
     Quality m_quality;
     int m_zoom;
+
+    // last, so that its worker thread stops before the members it reads
+    // are destroyed
+
+    PrefetchCache<PictureKey, Picture> m_cache;
 };
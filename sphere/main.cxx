@@ -80,6 +80,7 @@ printUsage(
     std::println(stream, "    --connector,-c - dri connector to use");
     std::println(stream, "    --device,-d - dri device to use");
     std::println(stream, "    --help,-h - print usage and exit");
+    std::println(stream, "    --stats,-s - write frame timing to CSV file and print summary");
     std::println(stream, "");
 }
 
@@ -93,15 +94,17 @@ main(
     uint32_t connector{0};
     std::string device = "";
     const std::string program = basename(argv[0]);
+    std::string statsFile = "";
 
     //---------------------------------------------------------------------
 
-    static const char* sopts = "c:d:h";
+    static const char* sopts = "c:d:hs:";
     static option lopts[] =
     {
         { "connector", required_argument, nullptr, 'c' },
         { "device", required_argument, nullptr, 'd' },
         { "help", no_argument, nullptr, 'h' },
+        { "stats", required_argument, nullptr, 's' },
         { nullptr, no_argument, nullptr, 0 }
     };
 
@@ -127,6 +130,11 @@ main(
             ::exit(EXIT_SUCCESS);
             break;
 
+        case 's':
+
+            statsFile = optarg;
+            break;
+
         default:
 
             printUsage(std::cerr, program);
@@ -163,6 +171,7 @@ main(
         FrameBuffer8880 fb(device, connector);
         Sphere sphere(fb.getDimensions().height() - 10);
         sphere.setAmbient(0.1);
+        fb.getStatistics().logCsv(statsFile);
 
         //-----------------------------------------------------------------
 
@@ -178,6 +187,11 @@ main(
 
             bearing = (bearing + 1) % 360;
         }
+
+        if (not statsFile.empty())
+        {
+            fb.getStatistics().writeSummary(std::cout);
+        }
     }
     catch (std::exception& error)
     {
@@ -0,0 +1,230 @@
+//-------------------------------------------------------------------------
+//
+// The MIT License (MIT)
+//
+// Copyright (c) 2025 Andrew Duncan
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+//-------------------------------------------------------------------------
+
+#include <getopt.h>
+#include <libgen.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <numbers>
+#include <print>
+#include <system_error>
+#include <thread>
+
+#include "framebuffer8880.h"
+#include "image8880.h"
+#include "image8880Font8x16.h"
+#include "image8880Graphics.h"
+#include "point.h"
+
+//-------------------------------------------------------------------------
+
+using namespace fb32;
+
+//-------------------------------------------------------------------------
+
+namespace
+{
+std::atomic<bool> run{true};
+}
+
+//-------------------------------------------------------------------------
+
+static void
+signalHandler(
+    int signalNumber)
+{
+    switch (signalNumber)
+    {
+    case SIGINT:
+    case SIGTERM:
+
+        run = false;
+        break;
+    };
+}
+
+//-------------------------------------------------------------------------
+
+void
+printUsage(
+    std::ostream& stream,
+    const std::string& name)
+{
+    std::println(stream, "");
+    std::println(stream, "Usage: {} <options>", name);
+    std::println(stream, "");
+    std::println(stream, "    --connector,-c - dri connector to use");
+    std::println(stream, "    --device,-d - dri device to use");
+    std::println(stream, "    --help,-h - print usage and exit");
+    std::println(stream, "");
+}
+
+//-------------------------------------------------------------------------
+
+int
+main(
+    int argc,
+    char *argv[])
+{
+    uint32_t connector{0};
+    std::string device{};
+    const std::string program = basename(argv[0]);
+
+    //---------------------------------------------------------------------
+
+    static const char* sopts = "c:d:h";
+    static option lopts[] =
+    {
+        { "connector", required_argument, nullptr, 'c' },
+        { "device", required_argument, nullptr, 'd' },
+        { "help", no_argument, nullptr, 'h' },
+        { nullptr, no_argument, nullptr, 0 }
+    };
+
+    int opt{};
+
+    while ((opt = ::getopt_long(argc, argv, sopts, lopts, nullptr)) != -1)
+    {
+        switch (opt)
+        {
+        case 'c':
+
+            connector = std::stol(optarg);
+            break;
+
+        case 'd':
+
+            device = optarg;
+            break;
+
+        case 'h':
+
+            printUsage(std::cout, program);
+            ::exit(EXIT_SUCCESS);
+            break;
+
+        default:
+
+            printUsage(std::cerr, program);
+            ::exit(EXIT_FAILURE);
+            break;
+        }
+    }
+
+    //---------------------------------------------------------------------
+
+    for (auto signal : { SIGINT, SIGTERM })
+    {
+        struct sigaction sa{};
+
+        sa.sa_handler = signalHandler;
+        sa.sa_flags = 0;
+
+        if (sigaction(signal, &sa, nullptr) == -1)
+        {
+            std::println(
+                std::cerr,
+                "Error: installing {} signal handler : {}",
+                strsignal(signal),
+                strerror(errno));
+
+            ::exit(EXIT_FAILURE);
+        }
+    }
+
+    //---------------------------------------------------------------------
+
+    try
+    {
+        constexpr RGB8880 darkGrey{63, 63, 63};
+        constexpr RGB8880 magenta{255, 0, 255};
+        constexpr RGB8880 white{255, 255, 255};
+
+        FrameBuffer8880 fb{device, connector};
+        fb.clearBuffers(darkGrey);
+        const auto fbd = fb.getDimensions();
+
+        constexpr fb32::Dimensions8880 d{88, 16};
+
+        // magenta is the colour key, so only the text and its border are drawn
+
+        Image8880 image(d);
+        image.clear(magenta);
+        box(image, Point8880{0, 0}, Point8880{d.width() - 1, d.height() - 1}, white);
+
+        //-----------------------------------------------------------------
+
+        Image8880Font8x16 font;
+
+        font.drawString(
+            Point8880{4, 0},
+            "transform",
+            white,
+            image);
+
+        //-----------------------------------------------------------------
+
+        const Point8880 centre{fbd.width() / 2, fbd.height() / 2};
+        const auto toCentre = Affine::translate(-d.width() / 2.0, -d.height() / 2.0);
+
+        for (int frame = 0; (frame < 3600) and run; ++frame)
+        {
+            const auto angle = frame / 10.0;
+            const auto zoom = 3.0 + 2.0 * std::sin(angle * std::numbers::pi / 180.0);
+            const auto alpha = static_cast<uint8_t>(128 + 127 * std::cos(angle * std::numbers::pi / 90.0));
+
+            fb.clear(darkGrey);
+
+            font.drawString(
+                Point8880{4, 0},
+                std::format("Angle: {:5.1f} Zoom: {:4.2f} Alpha: {:3d}", angle, zoom, alpha),
+                white,
+                fb);
+
+            fb.putImageTransformed(
+                centre,
+                image,
+                Affine::rotate(angle) * Affine::scale(zoom) * toCentre,
+                Affine::Filter::BILINEAR,
+                magenta.get8880(),
+                alpha);
+
+            fb.update();
+        }
+    }
+    catch (std::exception& error)
+    {
+        std::println(std::cerr, "Error: {}", error.what());
+        exit(EXIT_FAILURE);
+    }
+}